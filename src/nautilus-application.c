@@ -45,6 +45,7 @@
 #include "nautilus-dbus-launcher.h"
 #include "nautilus-dbus-manager.h"
 #include "nautilus-directory-private.h"
+#include "nautilus-emblems-paintable.h"
 #include "nautilus-file.h"
 #include "nautilus-file-operations.h"
 #include "nautilus-file-undo-manager.h"
@@ -52,23 +53,28 @@
 #include "nautilus-freedesktop-dbus.h"
 #include "nautilus-global-preferences.h"
 #include "nautilus-icon-info.h"
+#include "nautilus-keyfile-metadata.h"
 #include "nautilus-module.h"
 #include "nautilus-preferences-window.h"
 #include "nautilus-previewer.h"
+#include "nautilus-progress-info-manager.h"
 #include "nautilus-progress-persistence-handler.h"
 #include "nautilus-scheme.h"
 #include "nautilus-shell-search-provider.h"
 #include "nautilus-signaller.h"
 #include "nautilus-tag-manager.h"
+#include "nautilus-thumbnail-cache.h"
 #include "nautilus-tracker-utilities.h"
 #include "nautilus-trash-monitor.h"
 #include "nautilus-ui-utilities.h"
+#include "nautilus-vfs-file.h"
 #include "nautilus-view.h"
 #include "nautilus-window-slot.h"
 #include "nautilus-window.h"
 
 typedef struct
 {
+    NautilusProgressInfoManager *progress_manager;
     NautilusProgressPersistenceHandler *progress_handler;
     NautilusDBusManager *dbus_manager;
     NautilusFreedesktopDBus *fdb_manager;
@@ -546,6 +552,7 @@ nautilus_application_finalize (GObject *object)
     priv = nautilus_application_get_instance_private (self);
 
     g_clear_object (&priv->progress_handler);
+    g_clear_object (&priv->progress_manager);
     g_clear_object (&priv->bookmark_list);
 
     g_list_free (priv->windows);
@@ -1062,7 +1069,11 @@ on_application_shutdown (GApplication *application,
 
     g_list_free (notification_ids);
 
+    nautilus_keyfile_metadata_flush ();
+    nautilus_vfs_file_flush_metadata ();
     nautilus_icon_info_clear_caches ();
+    nautilus_emblems_paintable_clear_cache ();
+    nautilus_thumbnail_cache_clear ();
 }
 
 static void
@@ -1071,6 +1082,7 @@ icon_theme_changed_callback (GtkIconTheme *icon_theme,
 {
     /* Clear all pixmap caches as the icon => pixmap lookup changed */
     nautilus_icon_info_clear_caches ();
+    nautilus_emblems_paintable_clear_cache ();
 
     /* Tell the world that icons might have changed. We could invent a narrower-scope
      * signal to mean only "thumbnails might have changed" if this ends up being slow
@@ -1138,6 +1150,13 @@ nautilus_application_startup (GApplication *app)
     /* attach menu-provider module callback */
     menu_provider_init_callback ();
 
+    /* Limit the file operations writing to the same device at once */
+    priv->progress_manager = nautilus_progress_info_manager_dup_singleton ();
+    g_settings_bind (nautilus_preferences,
+                     NAUTILUS_PREFERENCES_FILE_OPERATIONS_PER_DEVICE,
+                     priv->progress_manager, "max-jobs-per-device",
+                     G_SETTINGS_BIND_GET);
+
     /* Initialize the UI handler singleton for file operations */
     priv->progress_handler = nautilus_progress_persistence_handler_new (G_OBJECT (self));
 
@@ -280,6 +280,37 @@ nautilus_get_columns_for_file (NautilusFile *file)
     return columns;
 }
 
+/**
+ * nautilus_column_is_from_extension:
+ * @attribute: the attribute of a column
+ *
+ * Returns: whether the column comes from an extension, so that its values
+ *     need NAUTILUS_FILE_ATTRIBUTE_EXTENSION_INFO.
+ */
+gboolean
+nautilus_column_is_from_extension (const char *attribute)
+{
+    static GList *columns = NULL;
+
+    if (columns == NULL)
+    {
+        columns = get_extension_columns ();
+    }
+
+    for (GList *l = columns; l != NULL; l = l->next)
+    {
+        g_autofree char *column_attribute = NULL;
+
+        g_object_get (l->data, "attribute", &column_attribute, NULL);
+        if (g_strcmp0 (column_attribute, attribute) == 0)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 GList *
 nautilus_column_list_copy (GList *columns)
 {
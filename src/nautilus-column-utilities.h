@@ -27,6 +27,7 @@
 GList *nautilus_get_all_columns       (void);
 GList *nautilus_get_common_columns    (void);
 GList *nautilus_get_columns_for_file (NautilusFile *file);
+gboolean nautilus_column_is_from_extension (const char *attribute);
 GList *nautilus_column_list_copy      (GList       *columns);
 void   nautilus_column_list_free      (GList       *columns);
 
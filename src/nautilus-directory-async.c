@@ -25,6 +25,7 @@
 
 #include "nautilus-directory-notify.h"
 #include "nautilus-directory-private.h"
+#include "nautilus-directory-snapshot.h"
 #include "nautilus-enums.h"
 #include "nautilus-file-private.h"
 #include "nautilus-file-utilities.h"
@@ -43,6 +44,10 @@
 /* Keep async. jobs down to this number for all directories. */
 #define MAX_ASYNC_JOBS 10
 
+/* Thumbnails are decoded in threads, this many at once per directory. They
+ * count as a single async. job. */
+#define MAX_THUMBNAIL_LOADS 4
+
 struct ThumbnailState
 {
     NautilusDirectory *directory;
@@ -64,6 +69,23 @@ struct FilesystemInfoState
     NautilusFile *file;
 };
 
+struct ExtraInfoState
+{
+    NautilusDirectory *directory;
+    GCancellable *cancellable;
+    GFileEnumerator *enumerator;
+    GList *files; /* the files lacking the extra info when it was started */
+    GList *infos;
+    /* The only file is self-owned, so it is queried instead of listed */
+    gboolean self_owned;
+};
+
+struct PendingFileInfo
+{
+    GFileInfo *info;
+    gboolean is_basic; /* only has NAUTILUS_FILE_BASIC_ATTRIBUTES */
+};
+
 struct DirectoryLoadState
 {
     NautilusDirectory *directory;
@@ -71,6 +93,15 @@ struct DirectoryLoadState
     GFileEnumerator *enumerator;
     NautilusFile *load_directory_file;
     int load_file_count;
+    /* In microseconds, read by the snapshot load along the enumeration, to
+     * save the snapshot with. A change made right as the enumeration starts
+     * may be missing from the saved snapshot, which the next enumeration
+     * corrects. -1 if unknown or if the snapshot mustn't be saved. */
+    gint64 directory_mtime;
+    /* The files were shown from a valid snapshot before being enumerated */
+    gboolean shown_snapshot;
+    /* The enumeration added, changed or removed files */
+    gboolean differs_from_snapshot;
 };
 
 struct GetInfoState
@@ -160,6 +191,9 @@ static gboolean request_is_satisfied (NautilusDirectory *directory,
 static void     cancel_loading_attributes (NautilusDirectory     *directory,
                                            NautilusFileAttributes file_attributes);
 static void     add_all_files_to_work_queue (NautilusDirectory *directory);
+static void     enqueue_file (NautilusDirectory *directory,
+                              NautilusHashQueue *queue,
+                              NautilusFile      *file);
 static void     move_file_to_low_priority_queue (NautilusDirectory *directory,
                                                  NautilusFile      *file);
 static void     move_file_to_extension_queue (NautilusDirectory *directory,
@@ -432,18 +466,38 @@ deep_count_cancel (NautilusDirectory *directory)
     }
 }
 
+/* Forget about a thumbnail load, which is done or no longer wanted */
 static void
-thumbnail_cancel (NautilusDirectory *directory)
+thumbnail_load_end (NautilusDirectory *directory,
+                    ThumbnailState    *state)
 {
-    if (directory->details->thumbnail_state != NULL)
+    directory->details->thumbnail_states = g_list_remove (directory->details->thumbnail_states,
+                                                          state);
+    state->directory = NULL;
+
+    if (directory->details->thumbnail_states == NULL)
     {
-        g_cancellable_cancel (directory->details->thumbnail_state->cancellable);
-        directory->details->thumbnail_state->directory = NULL;
-        directory->details->thumbnail_state = NULL;
         async_job_end (directory, "thumbnail");
     }
 }
 
+static void
+thumbnail_load_cancel (NautilusDirectory *directory,
+                       ThumbnailState    *state)
+{
+    g_cancellable_cancel (state->cancellable);
+    thumbnail_load_end (directory, state);
+}
+
+static void
+thumbnail_cancel (NautilusDirectory *directory)
+{
+    while (directory->details->thumbnail_states != NULL)
+    {
+        thumbnail_load_cancel (directory, directory->details->thumbnail_states->data);
+    }
+}
+
 static void
 mount_cancel (NautilusDirectory *directory)
 {
@@ -645,6 +699,12 @@ nautilus_directory_set_up_request (NautilusFileAttributes file_attributes)
         REQUEST_SET_TYPE (request, REQUEST_FILE_INFO);
     }
 
+    if ((file_attributes & NAUTILUS_FILE_ATTRIBUTE_EXTRA_INFO) != 0)
+    {
+        REQUEST_SET_TYPE (request, REQUEST_FILE_INFO);
+        REQUEST_SET_TYPE (request, REQUEST_EXTRA_INFO);
+    }
+
     if ((file_attributes & NAUTILUS_FILE_ATTRIBUTE_EXTENSION_INFO) != 0)
     {
         REQUEST_SET_TYPE (request, REQUEST_EXTENSION_INFO);
@@ -654,6 +714,8 @@ nautilus_directory_set_up_request (NautilusFileAttributes file_attributes)
     {
         REQUEST_SET_TYPE (request, REQUEST_THUMBNAIL);
         REQUEST_SET_TYPE (request, REQUEST_FILE_INFO);
+        /* The thumbnail path is part of the extra info */
+        REQUEST_SET_TYPE (request, REQUEST_EXTRA_INFO);
     }
 
     if (file_attributes & NAUTILUS_FILE_ATTRIBUTE_MOUNT)
@@ -842,6 +904,7 @@ dequeue_pending_idle_callback (gpointer callback_data)
     GList *node, *next;
     NautilusFile *file;
     GList *changed_files, *added_files;
+    PendingFileInfo *pending;
     GFileInfo *file_info;
     const char *name;
     DirectoryLoadState *dir_load_state;
@@ -871,7 +934,8 @@ dequeue_pending_idle_callback (gpointer callback_data)
     /* Build a list of NautilusFile objects. */
     for (node = pending_file_info; node != NULL; node = node->next)
     {
-        file_info = node->data;
+        pending = node->data;
+        file_info = pending->info;
 
         name = g_file_info_get_name (file_info);
 
@@ -904,7 +968,9 @@ dequeue_pending_idle_callback (gpointer callback_data)
                 file->details->is_added = TRUE;
                 added_files = g_list_prepend (added_files, file);
             }
-            else if (nautilus_file_update_info (file, file_info))
+            else if (pending->is_basic ?
+                     nautilus_file_update_basic_info (file, file_info) :
+                     nautilus_file_update_info (file, file_info))
             {
                 /* File changed, notify about the change. */
                 nautilus_file_ref (file);
@@ -914,7 +980,9 @@ dequeue_pending_idle_callback (gpointer callback_data)
         else
         {
             /* new file, create a nautilus file object and add it to the list */
-            file = nautilus_file_new_from_info (directory, file_info);
+            file = pending->is_basic ?
+                   nautilus_file_new_from_basic_info (directory, file_info) :
+                   nautilus_file_new_from_info (directory, file_info);
             nautilus_directory_add_file (directory, file);
             file->details->is_added = TRUE;
             added_files = g_list_prepend (added_files, file);
@@ -942,6 +1010,11 @@ dequeue_pending_idle_callback (gpointer callback_data)
         }
     }
 
+    if (dir_load_state != NULL && (added_files != NULL || changed_files != NULL))
+    {
+        dir_load_state->differs_from_snapshot = TRUE;
+    }
+
     /* Send the changed and added signals. */
     nautilus_directory_emit_change_signals (directory, changed_files);
     nautilus_file_list_free (changed_files);
@@ -963,6 +1036,16 @@ dequeue_pending_idle_callback (gpointer callback_data)
             file->details->got_directory_count = TRUE;
 
             nautilus_file_changed (file);
+
+            /* No need to save the snapshot again if it was up to date */
+            if (dir_load_state->directory_mtime >= 0 &&
+                directory->details->confirmed_file_count >= NAUTILUS_DIRECTORY_SNAPSHOT_MIN_FILES &&
+                (!dir_load_state->shown_snapshot || dir_load_state->differs_from_snapshot))
+            {
+                nautilus_directory_snapshot_save (directory->details->location,
+                                                  dir_load_state->directory_mtime,
+                                                  directory->details->file_list);
+            }
         }
 
         nautilus_directory_async_state_changed (directory);
@@ -975,7 +1058,8 @@ dequeue_pending_idle_callback (gpointer callback_data)
     notify_files_changed_while_being_added (directory);
 
 drain:
-    g_list_free_full (pending_file_info, g_object_unref);
+    g_list_free_full (pending_file_info,
+                      (GDestroyNotify) nautilus_directory_pending_file_info_free);
 
     /* Get the state machine running again. */
     nautilus_directory_async_state_changed (directory);
@@ -994,10 +1078,20 @@ nautilus_directory_schedule_dequeue_pending (NautilusDirectory *directory)
     }
 }
 
+void
+nautilus_directory_pending_file_info_free (PendingFileInfo *pending)
+{
+    g_object_unref (pending->info);
+    g_free (pending);
+}
+
 static void
 directory_load_one (NautilusDirectory *directory,
-                    GFileInfo         *info)
+                    GFileInfo         *info,
+                    gboolean           is_basic)
 {
+    PendingFileInfo *pending;
+
     if (info == NULL)
     {
         return;
@@ -1015,9 +1109,11 @@ directory_load_one (NautilusDirectory *directory,
     }
 
     /* Arrange for the "loading" part of the work. */
-    g_object_ref (info);
+    pending = g_new (PendingFileInfo, 1);
+    pending->info = g_object_ref (info);
+    pending->is_basic = is_basic;
     directory->details->pending_file_info
-        = g_list_prepend (directory->details->pending_file_info, info);
+        = g_list_prepend (directory->details->pending_file_info, pending);
     nautilus_directory_schedule_dequeue_pending (directory);
 }
 
@@ -1057,7 +1153,8 @@ file_list_cancel (NautilusDirectory *directory)
 
     if (directory->details->pending_file_info != NULL)
     {
-        g_list_free_full (directory->details->pending_file_info, g_object_unref);
+        g_list_free_full (directory->details->pending_file_info,
+                          (GDestroyNotify) nautilus_directory_pending_file_info_free);
         directory->details->pending_file_info = NULL;
     }
 }
@@ -1075,16 +1172,37 @@ directory_load_done (NautilusDirectory *directory,
 
     if (error != NULL)
     {
+        DirectoryLoadState *state = directory->details->directory_load_in_progress;
+
+        /* Don't save an incomplete listing, and don't show an outdated one
+         * the next time, the directory may have become unreadable */
+        if (state != NULL)
+        {
+            state->directory_mtime = -1;
+        }
+        if (g_file_is_native (directory->details->location))
+        {
+            nautilus_directory_snapshot_delete (directory->details->location);
+        }
+
         /* The load did not complete successfully. This means
          * we don't know the status of the files in this directory.
          * We clear the unconfirmed bit on each file here so that
          * they won't be marked "gone" later -- we don't know enough
          * about them to know whether they are really gone.
+         *
+         * The snapshot is only shown for a directory without files, so
+         * all the unconfirmed files then come from it. They were never
+         * seen by this load, so they are left unconfirmed, to be marked
+         * "gone" below, in dequeue_pending_idle_callback().
          */
-        for (node = directory->details->file_list;
-             node != NULL; node = node->next)
+        if (state == NULL || !state->shown_snapshot)
         {
-            set_file_unconfirmed (NAUTILUS_FILE (node->data), FALSE);
+            for (node = directory->details->file_list;
+                 node != NULL; node = node->next)
+            {
+                set_file_unconfirmed (NAUTILUS_FILE (node->data), FALSE);
+            }
         }
 
         nautilus_directory_emit_load_error (directory, error);
@@ -1475,7 +1593,7 @@ new_files_callback (GObject      *source_object,
     info = g_file_query_info_finish (G_FILE (source_object), res, NULL);
     if (info != NULL)
     {
-        directory_load_one (directory, info);
+        directory_load_one (directory, info, FALSE);
         g_object_unref (info);
     }
 
@@ -1592,11 +1710,15 @@ nautilus_async_destroying_file (NautilusFile *file)
         changed = TRUE;
     }
 
-    if (directory->details->thumbnail_state != NULL &&
-        directory->details->thumbnail_state->file == file)
+    for (GList *l = directory->details->thumbnail_states; l != NULL; l = l->next)
     {
-        directory->details->thumbnail_state->file = NULL;
-        changed = TRUE;
+        ThumbnailState *state = l->data;
+
+        if (state->file == file)
+        {
+            state->file = NULL;
+            changed = TRUE;
+        }
     }
 
     if (directory->details->mount_state != NULL &&
@@ -1641,6 +1763,14 @@ lacks_info (NautilusFile *file)
            && !file->details->is_gone;
 }
 
+static gboolean
+lacks_extra_info (NautilusFile *file)
+{
+    return !file->details->extra_info_is_up_to_date
+           && !file->details->get_info_failed
+           && !file->details->is_gone;
+}
+
 static gboolean
 lacks_filesystem_info (NautilusFile *file)
 {
@@ -1737,6 +1867,14 @@ request_is_satisfied (NautilusDirectory *directory,
         }
     }
 
+    if (REQUEST_WANTS_TYPE (request, REQUEST_EXTRA_INFO))
+    {
+        if (has_problem (directory, file, lacks_extra_info))
+        {
+            return FALSE;
+        }
+    }
+
     if (REQUEST_WANTS_TYPE (request, REQUEST_FILESYSTEM_INFO))
     {
         if (has_problem (directory, file, lacks_filesystem_info))
@@ -1998,7 +2136,7 @@ more_files_callback (GObject      *source_object,
     for (l = files; l != NULL; l = l->next)
     {
         info = l->data;
-        directory_load_one (directory, info);
+        directory_load_one (directory, info, TRUE);
         g_object_unref (info);
     }
 
@@ -2068,6 +2206,77 @@ enumerate_children_callback (GObject      *source_object,
     }
 }
 
+/* The snapshot is loaded while the directory is enumerated. Its files are
+ * shown until the enumeration confirms, updates or removes them, see
+ * dequeue_pending_idle_callback(). */
+static void
+snapshot_loaded_callback (GObject      *source_object,
+                          GAsyncResult *res,
+                          gpointer      user_data)
+{
+    NautilusDirectory *directory = user_data;
+    DirectoryLoadState *state;
+    g_autoptr (GPtrArray) infos = NULL;
+    gint64 directory_mtime;
+    GList *added_files;
+
+    infos = nautilus_directory_snapshot_load_finish (res, &directory_mtime);
+
+    /* Ending the load cancels the snapshot load, so getting the time means
+     * that the load is still in progress */
+    if (directory_mtime < 0)
+    {
+        nautilus_directory_unref (directory);
+        return;
+    }
+
+    state = directory->details->directory_load_in_progress;
+    g_assert (state != NULL);
+
+    state->directory_mtime = directory_mtime;
+    if (infos == NULL)
+    {
+        nautilus_directory_unref (directory);
+        return;
+    }
+
+    state->shown_snapshot = TRUE;
+
+    added_files = NULL;
+    for (guint i = 0; i < infos->len; i++)
+    {
+        GFileInfo *info = g_ptr_array_index (infos, i);
+        NautilusFile *file;
+
+        /* Already enumerated, it can't be told whether it changed */
+        if (nautilus_directory_find_file_by_name (directory, g_file_info_get_name (info)) != NULL)
+        {
+            state->differs_from_snapshot = TRUE;
+            continue;
+        }
+
+        file = nautilus_file_new_from_basic_info (directory, info);
+        nautilus_directory_add_file (directory, file);
+        set_file_unconfirmed (file, TRUE);
+        file->details->is_added = TRUE;
+        added_files = g_list_prepend (added_files, file);
+    }
+
+    nautilus_directory_emit_files_added (directory, added_files);
+    nautilus_file_list_free (added_files);
+
+    nautilus_directory_unref (directory);
+}
+
+static gboolean
+should_load_snapshot (NautilusDirectory *directory)
+{
+    /* Reloads already show the files */
+    return directory->details->file_list == NULL &&
+           g_file_is_native (directory->details->location) &&
+           g_settings_get_boolean (nautilus_preferences,
+                                   NAUTILUS_PREFERENCES_CACHE_DIRECTORY_LISTINGS);
+}
 
 /* Start monitoring the file list if it isn't already. */
 static void
@@ -2099,6 +2308,7 @@ start_monitoring_file_list (NautilusDirectory *directory)
     state->directory = directory;
     state->cancellable = g_cancellable_new ();
     state->load_file_count = 0;
+    state->directory_mtime = -1;
 
     g_assert (directory->details->location != NULL);
     state->load_directory_file =
@@ -2110,8 +2320,18 @@ start_monitoring_file_list (NautilusDirectory *directory)
 
     directory->details->directory_load_in_progress = state;
 
+    if (should_load_snapshot (directory))
+    {
+        nautilus_directory_snapshot_load_async (directory->details->location,
+                                                state->cancellable,
+                                                snapshot_loaded_callback,
+                                                nautilus_directory_ref (directory));
+    }
+
+    /* Only ask for what's needed to show the files, the rest is queried
+     * afterwards, see extra_info_start() */
     g_file_enumerate_children_async (directory->details->location,
-                                     NAUTILUS_FILE_DEFAULT_ATTRIBUTES,
+                                     NAUTILUS_FILE_BASIC_ATTRIBUTES,
                                      0,     /* flags */
                                      G_PRIORITY_DEFAULT,     /* prio */
                                      state->cancellable,
@@ -2314,6 +2534,23 @@ is_needy (NautilusFile *file,
     return FALSE;
 }
 
+static gboolean
+has_thumbnail (NautilusFile *file)
+{
+    return file->details->thumbnail != NULL;
+}
+
+/* This checks if the loaded thumbnail of the file is still asked for,
+ * usually because the file is on screen. */
+gboolean
+nautilus_directory_is_thumbnail_wanted (NautilusDirectory *directory,
+                                        NautilusFile      *file)
+{
+    g_assert (file->details->directory == directory);
+
+    return is_needy (file, has_thumbnail, REQUEST_THUMBNAIL);
+}
+
 static void
 directory_count_stop (NautilusDirectory *directory)
 {
@@ -2640,7 +2877,7 @@ deep_count_one (DeepCountState *state,
     if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
     {
         /* Count the directory. */
-        file->details->deep_directory_count += 1;
+        file->details->cold->deep_directory_count += 1;
 
         /* Record the fact that we have to descend into this directory. */
         fs_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
@@ -2655,13 +2892,13 @@ deep_count_one (DeepCountState *state,
     else
     {
         /* Even non-regular files count as files. */
-        file->details->deep_file_count += 1;
+        file->details->cold->deep_file_count += 1;
     }
 
     /* Count the size. */
     if (!is_seen_inode && g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_SIZE))
     {
-        file->details->deep_size += g_file_info_get_size (info);
+        file->details->cold->deep_size += g_file_info_get_size (info);
     }
 }
 
@@ -2813,7 +3050,7 @@ deep_count_callback (GObject      *source_object,
 
     if (enumerator == NULL)
     {
-        file->details->deep_unreadable_count += 1;
+        file->details->cold->deep_unreadable_count += 1;
 
         deep_count_next_dir (state);
     }
@@ -2904,6 +3141,7 @@ deep_count_start (NautilusDirectory *directory,
 {
     GFile *location;
     DeepCountState *state;
+    NautilusFileColdData *cold;
 
     if (directory->details->deep_count_in_progress != NULL)
     {
@@ -2934,10 +3172,11 @@ deep_count_start (NautilusDirectory *directory,
 
     /* Start counting. */
     file->details->deep_counts_status = NAUTILUS_REQUEST_IN_PROGRESS;
-    file->details->deep_directory_count = 0;
-    file->details->deep_file_count = 0;
-    file->details->deep_unreadable_count = 0;
-    file->details->deep_size = 0;
+    cold = nautilus_file_get_cold_data (file);
+    cold->deep_directory_count = 0;
+    cold->deep_file_count = 0;
+    cold->deep_unreadable_count = 0;
+    cold->deep_size = 0;
     directory->details->deep_count_file = file;
 
     state = g_new0 (DeepCountState, 1);
@@ -3118,14 +3357,34 @@ thumbnail_done (NautilusDirectory *directory,
     nautilus_directory_async_state_changed (directory);
 }
 
+static ThumbnailState *
+find_thumbnail_state (NautilusDirectory *directory,
+                      NautilusFile      *file)
+{
+    for (GList *l = directory->details->thumbnail_states; l != NULL; l = l->next)
+    {
+        ThumbnailState *state = l->data;
+
+        if (state->file == file)
+        {
+            return state;
+        }
+    }
+
+    return NULL;
+}
+
 static void
 thumbnail_stop (NautilusDirectory *directory)
 {
-    NautilusFile *file;
+    GList *next;
 
-    if (directory->details->thumbnail_state != NULL)
+    for (GList *l = directory->details->thumbnail_states; l != NULL; l = next)
     {
-        file = directory->details->thumbnail_state->file;
+        ThumbnailState *state = l->data;
+        NautilusFile *file = state->file;
+
+        next = l->next;
 
         if (file != NULL)
         {
@@ -3135,12 +3394,12 @@ thumbnail_stop (NautilusDirectory *directory)
                           lacks_thumbnail,
                           REQUEST_THUMBNAIL))
             {
-                return;
+                continue;
             }
         }
 
-        /* The link info is not wanted, so stop it. */
-        thumbnail_cancel (directory);
+        /* The thumbnail is not wanted, so stop loading it. */
+        thumbnail_load_cancel (directory, state);
     }
 }
 
@@ -3241,45 +3500,66 @@ get_pixbuf_for_content (goffset  file_len,
 }
 
 
+/* Runs in a thread, so it must only use its own copy of the path */
 static void
-thumbnail_read_callback (GObject      *source_object,
+thumbnail_load_thread (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancellable)
+{
+    const char *thumbnail_path = task_data;
+    g_autoptr (GFile) location = g_file_new_for_path (thumbnail_path);
+    g_autofree char *file_contents = NULL;
+    gsize file_size;
+    GError *error = NULL;
+
+    if (!g_file_load_contents (location, cancellable,
+                               &file_contents, &file_size,
+                               NULL, &error))
+    {
+        g_task_return_error (task, error);
+        return;
+    }
+
+    g_task_return_pointer (task,
+                           get_pixbuf_for_content (file_size, file_contents),
+                           g_object_unref);
+}
+
+static void
+thumbnail_load_callback (GObject      *source_object,
                          GAsyncResult *res,
                          gpointer      user_data)
 {
     ThumbnailState *state;
-    gsize file_size;
-    char *file_contents;
-    gboolean result;
     NautilusDirectory *directory;
     GdkPixbuf *pixbuf;
 
     state = user_data;
+    pixbuf = g_task_propagate_pointer (G_TASK (res), NULL);
 
     if (state->directory == NULL)
     {
         /* Operation was cancelled. Bail out */
+        g_clear_object (&pixbuf);
         thumbnail_state_free (state);
         return;
     }
 
     directory = nautilus_directory_ref (state->directory);
 
-    result = g_file_load_contents_finish (G_FILE (source_object),
-                                          res,
-                                          &file_contents, &file_size,
-                                          NULL, NULL);
+    thumbnail_load_end (directory, state);
 
-    pixbuf = NULL;
-    if (result)
+    if (state->file != NULL)
     {
-        pixbuf = get_pixbuf_for_content (file_size, file_contents);
-        g_free (file_contents);
+        thumbnail_got_pixbuf (directory, state->file, pixbuf);
+    }
+    else
+    {
+        /* The file went away in the meantime */
+        g_clear_object (&pixbuf);
+        nautilus_directory_async_state_changed (directory);
     }
-
-    state->directory->details->thumbnail_state = NULL;
-    async_job_end (state->directory, "thumbnail");
-
-    thumbnail_got_pixbuf (state->directory, state->file, pixbuf);
 
     thumbnail_state_free (state);
 
@@ -3291,25 +3571,32 @@ thumbnail_start (NautilusDirectory *directory,
                  NautilusFile      *file,
                  gboolean          *doing_io)
 {
-    GFile *location;
+    g_autoptr (GTask) task = NULL;
     ThumbnailState *state;
 
-    if (directory->details->thumbnail_state != NULL)
+    if (!is_needy (file,
+                   lacks_thumbnail,
+                   REQUEST_THUMBNAIL))
     {
-        *doing_io = TRUE;
         return;
     }
 
-    if (!is_needy (file,
-                   lacks_thumbnail,
-                   REQUEST_THUMBNAIL))
+    /* Already on its way, let the next files start theirs */
+    if (find_thumbnail_state (directory, file) != NULL)
     {
         return;
     }
-    *doing_io = TRUE;
 
-    if (!async_job_start (directory, "thumbnail"))
+    if (g_list_length (directory->details->thumbnail_states) >= MAX_THUMBNAIL_LOADS)
     {
+        *doing_io = TRUE;
+        return;
+    }
+
+    if (directory->details->thumbnail_states == NULL &&
+        !async_job_start (directory, "thumbnail"))
+    {
+        *doing_io = TRUE;
         return;
     }
 
@@ -3318,15 +3605,15 @@ thumbnail_start (NautilusDirectory *directory,
     state->file = file;
     state->cancellable = g_cancellable_new ();
 
-    location = g_file_new_for_path (file->details->thumbnail_path);
+    directory->details->thumbnail_states = g_list_prepend (directory->details->thumbnail_states,
+                                                           state);
 
-    directory->details->thumbnail_state = state;
-
-    g_file_load_contents_async (location,
-                                state->cancellable,
-                                thumbnail_read_callback,
-                                state);
-    g_object_unref (location);
+    /* Reading and decoding happen in a thread, the main thread only gets
+     * the decoded, oriented and scaled down pixbuf */
+    task = g_task_new (NULL, state->cancellable, thumbnail_load_callback, state);
+    g_task_set_source_tag (task, thumbnail_start);
+    g_task_set_task_data (task, g_strdup (file->details->thumbnail_path), g_free);
+    g_task_run_in_thread (task, thumbnail_load_thread);
 }
 
 static void
@@ -3651,6 +3938,281 @@ filesystem_info_start (NautilusDirectory *directory,
     g_object_unref (location);
 }
 
+static void
+extra_info_cancel (NautilusDirectory *directory)
+{
+    if (directory->details->extra_info_state != NULL)
+    {
+        g_cancellable_cancel (directory->details->extra_info_state->cancellable);
+        directory->details->extra_info_state->directory = NULL;
+        directory->details->extra_info_state = NULL;
+        async_job_end (directory, "extra info");
+    }
+}
+
+static void
+extra_info_stop (NautilusDirectory *directory)
+{
+    ExtraInfoState *state;
+
+    state = directory->details->extra_info_state;
+    if (state != NULL)
+    {
+        for (GList *l = state->files; l != NULL; l = l->next)
+        {
+            if (is_needy (l->data,
+                          lacks_extra_info,
+                          REQUEST_EXTRA_INFO))
+            {
+                return;
+            }
+        }
+
+        /* The extra info is not wanted, so stop it. */
+        extra_info_cancel (directory);
+    }
+}
+
+static void
+extra_info_state_free (ExtraInfoState *state)
+{
+    if (state->enumerator != NULL)
+    {
+        if (!g_file_enumerator_is_closed (state->enumerator))
+        {
+            g_file_enumerator_close_async (state->enumerator,
+                                           0, NULL, NULL, NULL);
+        }
+        g_object_unref (state->enumerator);
+    }
+    nautilus_file_list_free (state->files);
+    g_list_free_full (state->infos, g_object_unref);
+    g_object_unref (state->cancellable);
+    g_free (state);
+}
+
+static void
+extra_info_done (ExtraInfoState *state)
+{
+    NautilusDirectory *directory;
+    NautilusFile *file;
+    GList *changed_files;
+
+    directory = nautilus_directory_ref (state->directory);
+
+    directory->details->extra_info_state = NULL;
+    async_job_end (directory, "extra info");
+
+    /* Update all the files in one go, rather than one change signal each */
+    changed_files = NULL;
+    for (GList *l = state->infos; l != NULL; l = l->next)
+    {
+        GFileInfo *info = l->data;
+
+        if (state->self_owned)
+        {
+            file = state->files->data;
+        }
+        else
+        {
+            file = nautilus_directory_find_file_by_name (directory, g_file_info_get_name (info));
+        }
+        if (file != NULL &&
+            file->details->file_info_is_up_to_date &&
+            lacks_extra_info (file) &&
+            nautilus_file_update_extra_info (file, info))
+        {
+            changed_files = g_list_prepend (changed_files, nautilus_file_ref (file));
+        }
+    }
+
+    /* Not getting it is no reason to try again, the file info query
+     * notices if a file is gone. */
+    for (GList *l = state->files; l != NULL; l = l->next)
+    {
+        file = l->data;
+        if (lacks_extra_info (file))
+        {
+            file->details->extra_info_is_up_to_date = TRUE;
+        }
+    }
+
+    nautilus_directory_emit_change_signals (directory, changed_files);
+    nautilus_file_list_free (changed_files);
+
+    nautilus_directory_async_state_changed (directory);
+
+    nautilus_directory_unref (directory);
+
+    extra_info_state_free (state);
+}
+
+static void
+extra_info_more_files_callback (GObject      *source_object,
+                                GAsyncResult *res,
+                                gpointer      user_data)
+{
+    ExtraInfoState *state;
+    GList *infos;
+
+    state = user_data;
+    if (state->directory == NULL)
+    {
+        /* Operation was cancelled. Bail out */
+        extra_info_state_free (state);
+        return;
+    }
+
+    infos = g_file_enumerator_next_files_finish (state->enumerator, res, NULL);
+    if (infos == NULL)
+    {
+        extra_info_done (state);
+        return;
+    }
+
+    state->infos = g_list_concat (infos, state->infos);
+    g_file_enumerator_next_files_async (state->enumerator,
+                                        DIRECTORY_LOAD_ITEMS_PER_CALLBACK,
+                                        G_PRIORITY_LOW,
+                                        state->cancellable,
+                                        extra_info_more_files_callback,
+                                        state);
+}
+
+static void
+extra_info_enumerate_callback (GObject      *source_object,
+                               GAsyncResult *res,
+                               gpointer      user_data)
+{
+    ExtraInfoState *state;
+
+    state = user_data;
+    if (state->directory == NULL)
+    {
+        /* Operation was cancelled. Bail out */
+        extra_info_state_free (state);
+        return;
+    }
+
+    state->enumerator = g_file_enumerate_children_finish (G_FILE (source_object), res, NULL);
+    if (state->enumerator == NULL)
+    {
+        extra_info_done (state);
+        return;
+    }
+
+    g_file_enumerator_next_files_async (state->enumerator,
+                                        DIRECTORY_LOAD_ITEMS_PER_CALLBACK,
+                                        G_PRIORITY_LOW,
+                                        state->cancellable,
+                                        extra_info_more_files_callback,
+                                        state);
+}
+
+static void
+extra_info_query_callback (GObject      *source_object,
+                           GAsyncResult *res,
+                           gpointer      user_data)
+{
+    ExtraInfoState *state;
+    GFileInfo *info;
+
+    state = user_data;
+    if (state->directory == NULL)
+    {
+        /* Operation was cancelled. Bail out */
+        extra_info_state_free (state);
+        return;
+    }
+
+    info = g_file_query_info_finish (G_FILE (source_object), res, NULL);
+    if (info != NULL)
+    {
+        state->infos = g_list_prepend (state->infos, info);
+    }
+
+    extra_info_done (state);
+}
+
+/* The extra info is only missing for files which were listed, so it is
+ * listed as well: one enumeration of the directory gets it for all of its
+ * files, instead of a query per file. A self-owned file, like the root or
+ * trash:///, isn't in the listing, so it is queried on its own. */
+static void
+extra_info_start (NautilusDirectory *directory,
+                  NautilusFile      *file,
+                  gboolean          *doing_io)
+{
+    ExtraInfoState *state;
+
+    if (directory->details->extra_info_state != NULL)
+    {
+        *doing_io = TRUE;
+        return;
+    }
+
+    /* A full file info query gets the extra info as well */
+    if (!file->details->file_info_is_up_to_date ||
+        !is_needy (file,
+                   lacks_extra_info,
+                   REQUEST_EXTRA_INFO))
+    {
+        return;
+    }
+    *doing_io = TRUE;
+
+    if (!async_job_start (directory, "extra info"))
+    {
+        return;
+    }
+
+    state = g_new0 (ExtraInfoState, 1);
+    state->directory = directory;
+    state->cancellable = g_cancellable_new ();
+    directory->details->extra_info_state = state;
+
+    if (nautilus_file_is_self_owned (file))
+    {
+        g_autoptr (GFile) location = nautilus_file_get_location (file);
+
+        state->self_owned = TRUE;
+        state->files = g_list_prepend (NULL, nautilus_file_ref (file));
+        g_file_query_info_async (location,
+                                 NAUTILUS_FILE_EXTRA_ATTRIBUTES,
+                                 0,
+                                 G_PRIORITY_LOW,
+                                 state->cancellable,
+                                 extra_info_query_callback,
+                                 state);
+        return;
+    }
+
+    for (GList *l = directory->details->file_list; l != NULL; l = l->next)
+    {
+        NautilusFile *listed_file = l->data;
+
+        if (listed_file->details->file_info_is_up_to_date &&
+            lacks_extra_info (listed_file))
+        {
+            state->files = g_list_prepend (state->files, nautilus_file_ref (listed_file));
+        }
+    }
+    /* So that it isn't asked for again if it isn't listed */
+    if (g_list_find (state->files, file) == NULL)
+    {
+        state->files = g_list_prepend (state->files, nautilus_file_ref (file));
+    }
+
+    g_file_enumerate_children_async (directory->details->location,
+                                     G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                     NAUTILUS_FILE_EXTRA_ATTRIBUTES,
+                                     0,
+                                     G_PRIORITY_LOW,
+                                     state->cancellable,
+                                     extra_info_enumerate_callback,
+                                     state);
+}
+
 static void
 extension_info_cancel (NautilusDirectory *directory)
 {
@@ -3844,6 +4406,7 @@ start_or_stop_io (NautilusDirectory *directory)
     mount_stop (directory);
     thumbnail_stop (directory);
     filesystem_info_stop (directory);
+    extra_info_stop (directory);
 
     doing_io = FALSE;
     /* Take files that are all done off the queue. */
@@ -3867,11 +4430,16 @@ start_or_stop_io (NautilusDirectory *directory)
     {
         file = nautilus_hash_queue_peek_head (directory->details->low_priority_queue);
 
-        /* Start getting attributes if possible */
+        /* Start getting attributes if possible. The thumbnail needs the
+         * thumbnail path from the extra info. */
+        extra_info_start (directory, file, &doing_io);
         mount_start (directory, file, &doing_io);
         directory_count_start (directory, file, &doing_io);
         deep_count_start (directory, file, &doing_io);
-        thumbnail_start (directory, file, &doing_io);
+        if (!lacks_extra_info (file))
+        {
+            thumbnail_start (directory, file, &doing_io);
+        }
         filesystem_info_start (directory, file, &doing_io);
 
         if (doing_io)
@@ -3942,6 +4510,7 @@ nautilus_directory_cancel (NautilusDirectory *directory)
     /* Arbitrary order (kept alphabetical). */
     deep_count_cancel (directory);
     directory_count_cancel (directory);
+    extra_info_cancel (directory);
     file_info_cancel (directory);
     file_list_cancel (directory);
     new_files_cancel (directory);
@@ -3995,10 +4564,11 @@ static void
 cancel_thumbnail_for_file (NautilusDirectory *directory,
                            NautilusFile      *file)
 {
-    if (directory->details->thumbnail_state != NULL &&
-        directory->details->thumbnail_state->file == file)
+    ThumbnailState *state = find_thumbnail_state (directory, file);
+
+    if (state != NULL)
     {
-        thumbnail_cancel (directory);
+        thumbnail_load_cancel (directory, state);
     }
 }
 
@@ -4044,6 +4614,10 @@ cancel_loading_attributes (NautilusDirectory      *directory,
     {
         file_info_cancel (directory);
     }
+    if (REQUEST_WANTS_TYPE (request, REQUEST_EXTRA_INFO))
+    {
+        extra_info_cancel (directory);
+    }
     if (REQUEST_WANTS_TYPE (request, REQUEST_FILESYSTEM_INFO))
     {
         filesystem_info_cancel (directory);
@@ -4089,6 +4663,8 @@ nautilus_directory_cancel_loading_file_attributes (NautilusDirectory      *direc
     {
         cancel_file_info_for_file (directory, file);
     }
+    /* The extra info is listed for all the files of the directory at
+     * once, extra_info_stop() stops it once none of them needs it. */
     if (REQUEST_WANTS_TYPE (request, REQUEST_FILESYSTEM_INFO))
     {
         cancel_filesystem_info_for_file (directory, file);
@@ -4111,8 +4687,7 @@ nautilus_directory_add_file_to_work_queue (NautilusDirectory *directory,
 {
     g_return_if_fail (file->details->directory == directory);
 
-    nautilus_hash_queue_enqueue (directory->details->high_priority_queue,
-                                 file);
+    enqueue_file (directory, directory->details->high_priority_queue, file);
 }
 
 
@@ -4140,13 +4715,27 @@ nautilus_directory_remove_file_from_work_queue (NautilusDirectory *directory,
 }
 
 
+/* Files with monitors of their own, rather than just the one for the whole
+ * directory, are usually on screen, so keep them ahead in each queue. */
+static void
+enqueue_file (NautilusDirectory *directory,
+              NautilusHashQueue *queue,
+              NautilusFile      *file)
+{
+    nautilus_hash_queue_enqueue (queue, file);
+
+    if (g_hash_table_contains (directory->details->monitor_table, file))
+    {
+        nautilus_hash_queue_move_existing_to_head (queue, file);
+    }
+}
+
 static void
 move_file_to_low_priority_queue (NautilusDirectory *directory,
                                  NautilusFile      *file)
 {
     /* Must add before removing to avoid ref underflow */
-    nautilus_hash_queue_enqueue (directory->details->low_priority_queue,
-                                 file);
+    enqueue_file (directory, directory->details->low_priority_queue, file);
     nautilus_hash_queue_remove (directory->details->high_priority_queue,
                                 file);
 }
@@ -4156,8 +4745,7 @@ move_file_to_extension_queue (NautilusDirectory *directory,
                               NautilusFile      *file)
 {
     /* Must add before removing to avoid ref underflow */
-    nautilus_hash_queue_enqueue (directory->details->extension_queue,
-                                 file);
+    enqueue_file (directory, directory->details->extension_queue, file);
     nautilus_hash_queue_remove (directory->details->low_priority_queue,
                                 file);
 }
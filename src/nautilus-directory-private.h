@@ -36,6 +36,8 @@ typedef struct NewFilesState NewFilesState;
 typedef struct ThumbnailState ThumbnailState;
 typedef struct MountState MountState;
 typedef struct FilesystemInfoState FilesystemInfoState;
+typedef struct ExtraInfoState ExtraInfoState;
+typedef struct PendingFileInfo PendingFileInfo;
 
 typedef enum {
 	REQUEST_DEEP_COUNT,
@@ -46,6 +48,7 @@ typedef enum {
 	REQUEST_THUMBNAIL,
 	REQUEST_MOUNT,
 	REQUEST_FILESYSTEM_INFO,
+	REQUEST_EXTRA_INFO,
 	REQUEST_TYPE_LAST
 } RequestType;
 
@@ -91,7 +94,7 @@ struct NautilusDirectoryPrivate
 	gboolean directory_loaded_sent_notification;
 	DirectoryLoadState *directory_load_in_progress;
 
-	GList *pending_file_info; /* list of GnomeVFSFileInfo's that are pending */
+	GList *pending_file_info; /* list of PendingFileInfo's that are pending */
 	int confirmed_file_count;
         guint dequeue_pending_idle_id;
 
@@ -116,12 +119,14 @@ struct NautilusDirectoryPrivate
 	NautilusOperationHandle *extension_info_in_progress;
 	guint extension_info_idle;
 
-	ThumbnailState *thumbnail_state;
+	GList *thumbnail_states; /* list of ThumbnailState *, loading in parallel */
 
 	MountState *mount_state;
 
 	FilesystemInfoState *filesystem_info_state;
 
+	ExtraInfoState *extra_info_state;
+
 	GList *file_operations_in_progress; /* list of FileOperation * */
 };
 
@@ -162,10 +167,13 @@ gboolean           nautilus_directory_is_file_list_monitored          (NautilusD
 gboolean           nautilus_directory_is_anyone_monitoring_file_list  (NautilusDirectory         *directory);
 gboolean           nautilus_directory_has_request_for_file            (NautilusDirectory         *directory,
 								       NautilusFile              *file);
+gboolean           nautilus_directory_is_thumbnail_wanted             (NautilusDirectory         *directory,
+								       NautilusFile              *file);
 void               nautilus_directory_schedule_dequeue_pending        (NautilusDirectory         *directory);
 void               nautilus_directory_stop_monitoring_file_list       (NautilusDirectory         *directory);
 void               nautilus_directory_cancel                          (NautilusDirectory         *directory);
 void               nautilus_async_destroying_file                     (NautilusFile              *file);
+void               nautilus_directory_pending_file_info_free          (PendingFileInfo           *pending);
 void               nautilus_directory_force_reload_internal           (NautilusDirectory         *directory,
 								       NautilusFileAttributes     file_attributes);
 void               nautilus_directory_cancel_loading_file_attributes  (NautilusDirectory         *directory,
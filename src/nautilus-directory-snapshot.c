@@ -0,0 +1,641 @@
+/*
+ * Copyright (C) 2026 The GNOME project contributors
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <config.h>
+#include "nautilus-directory-snapshot.h"
+
+#include <errno.h>
+#include <glib/gstdio.h>
+
+#include "nautilus-file-private.h"
+
+/**
+ * A directory snapshot is the listing of a directory as it was when it was
+ * last loaded, saved in the user cache directory. When the directory is
+ * opened again, the files of the snapshot can be shown right away, while the
+ * directory is enumerated. The enumeration then confirms, updates or removes
+ * them, like it does when a directory is reloaded.
+ *
+ * A snapshot is only used if the modification time of the directory is the
+ * one it was saved with, so that files which were added, removed or renamed
+ * since don't show up for the time of the enumeration.
+ *
+ * The file is in the native byte order and meant to be mapped in memory: a
+ * header, then an array of fixed size entries, then the strings they point
+ * to. Content types and filesystem ids are shared by many files, so they are
+ * only stored once.
+ */
+
+#define SNAPSHOT_MAGIC "NDS1"
+/* Only the most recently saved snapshots are kept */
+#define MAX_SNAPSHOTS 20
+
+#define NO_STRING G_MAXUINT32
+
+typedef enum
+{
+    ENTRY_IS_HIDDEN = 1 << 0,
+    ENTRY_IS_SYMLINK = 1 << 1,
+    ENTRY_IS_MOUNTPOINT = 1 << 2,
+    ENTRY_HAS_SIZE = 1 << 3,
+    ENTRY_HAS_PERMISSIONS = 1 << 4,
+    ENTRY_HAS_UID = 1 << 5,
+    ENTRY_HAS_GID = 1 << 6,
+    ENTRY_CAN_READ = 1 << 7,
+    ENTRY_CAN_WRITE = 1 << 8,
+    ENTRY_CAN_EXECUTE = 1 << 9,
+    ENTRY_CAN_DELETE = 1 << 10,
+    ENTRY_CAN_TRASH = 1 << 11,
+    ENTRY_CAN_RENAME = 1 << 12,
+} EntryFlags;
+
+typedef struct
+{
+    char magic[4];
+    guint32 n_entries;
+    gint64 directory_mtime;
+} SnapshotHeader;
+
+/* String offsets are relative to the start of the strings */
+typedef struct
+{
+    guint32 name;
+    guint32 display_name;
+    guint32 content_type;
+    guint32 symlink_target;
+    guint32 filesystem_id;
+    guint32 file_type;
+    guint32 flags;
+    guint32 permissions;
+    guint32 uid;
+    guint32 gid;
+    gint32 sort_order;
+    guint32 padding;
+    gint64 size;
+    guint64 atime;
+    guint64 mtime;
+    guint64 btime;
+} SnapshotEntry;
+
+G_STATIC_ASSERT (sizeof (SnapshotHeader) == 16);
+G_STATIC_ASSERT (sizeof (SnapshotEntry) == 80);
+
+G_LOCK_DEFINE_STATIC (snapshots);
+
+static char *
+get_snapshots_dir (void)
+{
+    return g_build_filename (g_get_user_cache_dir (), "nautilus", "listings", NULL);
+}
+
+static char *
+get_snapshot_path (GFile *location)
+{
+    g_autofree char *uri = g_file_get_uri (location);
+    g_autofree char *checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+    g_autofree char *dirname = get_snapshots_dir ();
+
+    return g_build_filename (dirname, checksum, NULL);
+}
+
+static guint32
+add_string (GByteArray *strings,
+            GHashTable *shared_strings,
+            const char *string)
+{
+    gpointer offset;
+
+    if (string == NULL)
+    {
+        return NO_STRING;
+    }
+
+    if (shared_strings != NULL &&
+        g_hash_table_lookup_extended (shared_strings, string, NULL, &offset))
+    {
+        return GPOINTER_TO_UINT (offset);
+    }
+
+    offset = GUINT_TO_POINTER (strings->len);
+    g_byte_array_append (strings, (const guint8 *) string, strlen (string) + 1);
+
+    if (shared_strings != NULL)
+    {
+        g_hash_table_insert (shared_strings, (gpointer) string, offset);
+    }
+
+    return GPOINTER_TO_UINT (offset);
+}
+
+static void
+entry_init_from_file (SnapshotEntry *entry,
+                      NautilusFile  *file,
+                      GByteArray    *strings,
+                      GHashTable    *shared_strings)
+{
+    NautilusFilePrivate *details = file->details;
+    const char *symlink_target = details->cold != NULL ? details->cold->symlink_name : NULL;
+
+    entry->name = add_string (strings, NULL, details->name);
+    if (g_strcmp0 (details->display_name, details->name) == 0)
+    {
+        entry->display_name = entry->name;
+    }
+    else
+    {
+        entry->display_name = add_string (strings, NULL, details->display_name);
+    }
+    entry->content_type = add_string (strings, shared_strings, details->mime_type);
+    entry->symlink_target = add_string (strings, NULL, symlink_target);
+    entry->filesystem_id = add_string (strings, shared_strings, details->filesystem_id);
+
+    entry->file_type = details->type;
+    entry->flags = (details->is_hidden ? ENTRY_IS_HIDDEN : 0) |
+                   (details->is_symlink ? ENTRY_IS_SYMLINK : 0) |
+                   (details->is_mountpoint ? ENTRY_IS_MOUNTPOINT : 0) |
+                   (details->size >= 0 ? ENTRY_HAS_SIZE : 0) |
+                   (details->has_permissions ? ENTRY_HAS_PERMISSIONS : 0) |
+                   (details->has_uid ? ENTRY_HAS_UID : 0) |
+                   (details->has_gid ? ENTRY_HAS_GID : 0) |
+                   (details->can_read ? ENTRY_CAN_READ : 0) |
+                   (details->can_write ? ENTRY_CAN_WRITE : 0) |
+                   (details->can_execute ? ENTRY_CAN_EXECUTE : 0) |
+                   (details->can_delete ? ENTRY_CAN_DELETE : 0) |
+                   (details->can_trash ? ENTRY_CAN_TRASH : 0) |
+                   (details->can_rename ? ENTRY_CAN_RENAME : 0);
+    entry->permissions = details->permissions;
+    entry->uid = details->uid;
+    entry->gid = details->gid;
+    entry->sort_order = details->sort_order;
+    entry->size = details->size;
+    entry->atime = details->atime;
+    entry->mtime = details->mtime;
+    entry->btime = details->btime;
+}
+
+/**
+ * nautilus_directory_snapshot_serialize:
+ * @directory_mtime: the modification time of the directory, in microseconds,
+ *     from before it was enumerated
+ * @files: (element-type NautilusFile): the files of the directory
+ *
+ * Returns: (transfer full): the snapshot of @files, in the format it is
+ *     saved in. Files without info or which are gone are left out.
+ */
+GBytes *
+nautilus_directory_snapshot_serialize (gint64  directory_mtime,
+                                       GList  *files)
+{
+    g_autoptr (GArray) entries = g_array_new (FALSE, TRUE, sizeof (SnapshotEntry));
+    g_autoptr (GByteArray) strings = g_byte_array_new ();
+    g_autoptr (GHashTable) shared_strings = g_hash_table_new (g_str_hash, g_str_equal);
+    GByteArray *data;
+    SnapshotHeader header = { 0 };
+
+    for (GList *l = files; l != NULL; l = l->next)
+    {
+        NautilusFile *file = l->data;
+        SnapshotEntry entry = { 0 };
+
+        if (file->details->is_gone ||
+            !file->details->got_file_info ||
+            file->details->get_info_failed)
+        {
+            continue;
+        }
+
+        entry_init_from_file (&entry, file, strings, shared_strings);
+        g_array_append_val (entries, entry);
+    }
+
+    memcpy (header.magic, SNAPSHOT_MAGIC, sizeof (header.magic));
+    header.n_entries = entries->len;
+    header.directory_mtime = directory_mtime;
+
+    data = g_byte_array_sized_new (sizeof (header) +
+                                   entries->len * sizeof (SnapshotEntry) +
+                                   strings->len);
+    g_byte_array_append (data, (const guint8 *) &header, sizeof (header));
+    g_byte_array_append (data, (const guint8 *) entries->data,
+                         entries->len * sizeof (SnapshotEntry));
+    g_byte_array_append (data, strings->data, strings->len);
+
+    return g_byte_array_free_to_bytes (data);
+}
+
+static const char *
+get_string (const char *strings,
+            gsize       strings_length,
+            guint32     offset)
+{
+    if (offset == NO_STRING || offset >= strings_length)
+    {
+        return NULL;
+    }
+
+    return strings + offset;
+}
+
+static GFileInfo *
+entry_to_info (const SnapshotEntry *entry,
+               const char          *strings,
+               gsize                strings_length)
+{
+    const char *name = get_string (strings, strings_length, entry->name);
+    const char *display_name = get_string (strings, strings_length, entry->display_name);
+    const char *content_type = get_string (strings, strings_length, entry->content_type);
+    const char *symlink_target = get_string (strings, strings_length, entry->symlink_target);
+    const char *filesystem_id = get_string (strings, strings_length, entry->filesystem_id);
+    GFileInfo *info;
+
+    if (name == NULL || display_name == NULL)
+    {
+        return NULL;
+    }
+
+    info = g_file_info_new ();
+
+    g_file_info_set_name (info, name);
+    g_file_info_set_display_name (info, display_name);
+    g_file_info_set_file_type (info, entry->file_type);
+    g_file_info_set_is_hidden (info, entry->flags & ENTRY_IS_HIDDEN);
+    g_file_info_set_is_symlink (info, entry->flags & ENTRY_IS_SYMLINK);
+    g_file_info_set_sort_order (info, entry->sort_order);
+    g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_UNIX_IS_MOUNTPOINT,
+                                       entry->flags & ENTRY_IS_MOUNTPOINT);
+
+    if (content_type != NULL)
+    {
+        g_autoptr (GIcon) icon = g_content_type_get_icon (content_type);
+
+        g_file_info_set_content_type (info, content_type);
+        g_file_info_set_icon (info, icon);
+    }
+    if (symlink_target != NULL)
+    {
+        g_file_info_set_symlink_target (info, symlink_target);
+    }
+    if (filesystem_id != NULL)
+    {
+        g_file_info_set_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM, filesystem_id);
+    }
+
+    if (entry->flags & ENTRY_HAS_SIZE)
+    {
+        g_file_info_set_size (info, entry->size);
+    }
+    if (entry->flags & ENTRY_HAS_PERMISSIONS)
+    {
+        g_file_info_set_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_MODE, entry->permissions);
+    }
+    if (entry->flags & ENTRY_HAS_UID)
+    {
+        g_file_info_set_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_UID, entry->uid);
+    }
+    if (entry->flags & ENTRY_HAS_GID)
+    {
+        g_file_info_set_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_GID, entry->gid);
+    }
+
+    g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ,
+                                       entry->flags & ENTRY_CAN_READ);
+    g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE,
+                                       entry->flags & ENTRY_CAN_WRITE);
+    g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE,
+                                       entry->flags & ENTRY_CAN_EXECUTE);
+    g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_DELETE,
+                                       entry->flags & ENTRY_CAN_DELETE);
+    g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH,
+                                       entry->flags & ENTRY_CAN_TRASH);
+    g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_RENAME,
+                                       entry->flags & ENTRY_CAN_RENAME);
+
+    /* 0 is unknown, like for NautilusFile */
+    if (entry->atime != 0)
+    {
+        g_file_info_set_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_ACCESS, entry->atime);
+    }
+    if (entry->mtime != 0)
+    {
+        g_file_info_set_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED, entry->mtime);
+    }
+    if (entry->btime != 0)
+    {
+        g_file_info_set_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_CREATED, entry->btime);
+    }
+
+    return info;
+}
+
+/**
+ * nautilus_directory_snapshot_parse:
+ * @bytes: a snapshot, as returned by nautilus_directory_snapshot_serialize()
+ * @directory_mtime: the current modification time of the directory
+ *
+ * Returns: (transfer full) (nullable) (element-type GFileInfo): the infos of
+ *     the files in the snapshot, or %NULL if it is invalid or was saved for
+ *     another modification time. Like those of the enumeration, they only
+ *     have the basic attributes, see nautilus_file_new_from_basic_info().
+ */
+GPtrArray *
+nautilus_directory_snapshot_parse (GBytes *bytes,
+                                   gint64  directory_mtime)
+{
+    gsize length;
+    const guint8 *data = g_bytes_get_data (bytes, &length);
+    SnapshotHeader header;
+    const SnapshotEntry *entries;
+    const char *strings;
+    gsize strings_length;
+    GPtrArray *infos;
+
+    if (length < sizeof (header))
+    {
+        return NULL;
+    }
+
+    memcpy (&header, data, sizeof (header));
+    if (memcmp (header.magic, SNAPSHOT_MAGIC, sizeof (header.magic)) != 0 ||
+        header.directory_mtime != directory_mtime ||
+        header.n_entries > (length - sizeof (header)) / sizeof (SnapshotEntry))
+    {
+        return NULL;
+    }
+
+    entries = (const SnapshotEntry *) (data + sizeof (header));
+    strings = (const char *) (entries + header.n_entries);
+    strings_length = length - sizeof (header) - header.n_entries * sizeof (SnapshotEntry);
+
+    /* So that every string in there is terminated */
+    if (strings_length > 0 && strings[strings_length - 1] != '\0')
+    {
+        return NULL;
+    }
+
+    infos = g_ptr_array_new_full (header.n_entries, g_object_unref);
+    for (guint32 i = 0; i < header.n_entries; i++)
+    {
+        GFileInfo *info = entry_to_info (&entries[i], strings, strings_length);
+
+        if (info == NULL)
+        {
+            g_ptr_array_unref (infos);
+            return NULL;
+        }
+
+        g_ptr_array_add (infos, info);
+    }
+
+    return infos;
+}
+
+typedef struct
+{
+    gint64 directory_mtime;
+    GPtrArray *infos;
+} LoadResult;
+
+static void
+load_result_free (LoadResult *result)
+{
+    g_clear_pointer (&result->infos, g_ptr_array_unref);
+    g_free (result);
+}
+
+static void
+load_thread (GTask        *task,
+             gpointer      source_object,
+             gpointer      task_data,
+             GCancellable *cancellable)
+{
+    GFile *location = source_object;
+    LoadResult *result = g_new0 (LoadResult, 1);
+    g_autoptr (GFileInfo) info = NULL;
+    g_autoptr (GMappedFile) mapped_file = NULL;
+    g_autoptr (GBytes) bytes = NULL;
+    g_autofree char *path = NULL;
+
+    result->directory_mtime = -1;
+
+    info = g_file_query_info (location,
+                              G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                              G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                              G_FILE_QUERY_INFO_NONE,
+                              cancellable,
+                              NULL);
+    if (info == NULL ||
+        !g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_TIME_MODIFIED))
+    {
+        g_task_return_pointer (task, result, (GDestroyNotify) load_result_free);
+        return;
+    }
+
+    result->directory_mtime =
+        g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+        g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+
+    path = get_snapshot_path (location);
+    mapped_file = g_mapped_file_new (path, FALSE, NULL);
+    if (mapped_file != NULL)
+    {
+        bytes = g_mapped_file_get_bytes (mapped_file);
+        result->infos = nautilus_directory_snapshot_parse (bytes, result->directory_mtime);
+    }
+
+    g_task_return_pointer (task, result, (GDestroyNotify) load_result_free);
+}
+
+/**
+ * nautilus_directory_snapshot_load_async:
+ * @location: the directory
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: called when the snapshot is loaded
+ * @user_data: data for @callback
+ *
+ * Gets the modification time of the directory at @location and, if its
+ * snapshot was saved for that time, loads it.
+ */
+void
+nautilus_directory_snapshot_load_async (GFile               *location,
+                                        GCancellable        *cancellable,
+                                        GAsyncReadyCallback  callback,
+                                        gpointer             user_data)
+{
+    g_autoptr (GTask) task = g_task_new (location, cancellable, callback, user_data);
+
+    g_task_set_source_tag (task, nautilus_directory_snapshot_load_async);
+    g_task_run_in_thread (task, load_thread);
+}
+
+/**
+ * nautilus_directory_snapshot_load_finish:
+ * @result: the result passed to the callback
+ * @directory_mtime: (out): the modification time of the directory, in
+ *     microseconds, or -1 if it couldn't be read or the load was cancelled
+ *
+ * Returns: (transfer full) (nullable) (element-type GFileInfo): the infos of
+ *     the files in the snapshot, or %NULL if there is no valid one.
+ */
+GPtrArray *
+nautilus_directory_snapshot_load_finish (GAsyncResult *result,
+                                         gint64       *directory_mtime)
+{
+    LoadResult *load_result = g_task_propagate_pointer (G_TASK (result), NULL);
+    GPtrArray *infos;
+
+    if (load_result == NULL)
+    {
+        /* Cancelled */
+        *directory_mtime = -1;
+        return NULL;
+    }
+
+    *directory_mtime = load_result->directory_mtime;
+    infos = g_steal_pointer (&load_result->infos);
+    load_result_free (load_result);
+
+    return infos;
+}
+
+static int
+compare_by_mtime (gconstpointer a,
+                  gconstpointer b)
+{
+    const GStatBuf *stat_a = *(GStatBuf **) a;
+    const GStatBuf *stat_b = *(GStatBuf **) b;
+
+    return (stat_a->st_mtime > stat_b->st_mtime) - (stat_a->st_mtime < stat_b->st_mtime);
+}
+
+static void
+prune_snapshots (const char *dirname)
+{
+    g_autoptr (GDir) dir = g_dir_open (dirname, 0, NULL);
+    g_autoptr (GPtrArray) paths = g_ptr_array_new_with_free_func (g_free);
+    g_autoptr (GPtrArray) stats = g_ptr_array_new_with_free_func (g_free);
+    g_autoptr (GHashTable) stat_paths = g_hash_table_new (NULL, NULL);
+    const char *name;
+
+    if (dir == NULL)
+    {
+        return;
+    }
+
+    while ((name = g_dir_read_name (dir)) != NULL)
+    {
+        char *path = g_build_filename (dirname, name, NULL);
+        GStatBuf *stat_buf = g_new0 (GStatBuf, 1);
+
+        if (g_stat (path, stat_buf) != 0)
+        {
+            g_free (path);
+            g_free (stat_buf);
+            continue;
+        }
+
+        g_ptr_array_add (paths, path);
+        g_ptr_array_add (stats, stat_buf);
+        g_hash_table_insert (stat_paths, stat_buf, path);
+    }
+
+    if (stats->len <= MAX_SNAPSHOTS)
+    {
+        return;
+    }
+
+    g_ptr_array_sort (stats, compare_by_mtime);
+    for (guint i = 0; i < stats->len - MAX_SNAPSHOTS; i++)
+    {
+        g_unlink (g_hash_table_lookup (stat_paths, g_ptr_array_index (stats, i)));
+    }
+}
+
+static void
+save_thread (GTask        *task,
+             gpointer      source_object,
+             gpointer      task_data,
+             GCancellable *cancellable)
+{
+    GFile *location = source_object;
+    GBytes *bytes = task_data;
+    g_autofree char *dirname = get_snapshots_dir ();
+    g_autofree char *path = get_snapshot_path (location);
+    g_autoptr (GError) error = NULL;
+
+    G_LOCK (snapshots);
+
+    /* Written to a temporary file, then renamed over the old one, so that a
+     * mapped snapshot is never changed under the reader */
+    if (g_mkdir_with_parents (dirname, 0700) != 0 ||
+        !g_file_set_contents (path,
+                              g_bytes_get_data (bytes, NULL),
+                              g_bytes_get_size (bytes),
+                              &error))
+    {
+        g_debug ("Couldn't save the directory snapshot: %s",
+                 error != NULL ? error->message : g_strerror (errno));
+    }
+
+    prune_snapshots (dirname);
+
+    G_UNLOCK (snapshots);
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+delete_thread (GTask        *task,
+               gpointer      source_object,
+               gpointer      task_data,
+               GCancellable *cancellable)
+{
+    GFile *location = source_object;
+    g_autofree char *path = get_snapshot_path (location);
+
+    G_LOCK (snapshots);
+    g_unlink (path);
+    G_UNLOCK (snapshots);
+
+    g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * nautilus_directory_snapshot_delete:
+ * @location: the directory
+ *
+ * Deletes the snapshot of the directory in the background, if there is one.
+ */
+void
+nautilus_directory_snapshot_delete (GFile *location)
+{
+    g_autoptr (GTask) task = g_task_new (location, NULL, NULL, NULL);
+
+    g_task_set_source_tag (task, nautilus_directory_snapshot_delete);
+    g_task_run_in_thread (task, delete_thread);
+}
+
+/**
+ * nautilus_directory_snapshot_save:
+ * @location: the directory
+ * @directory_mtime: the modification time of the directory, in microseconds,
+ *     from before it was enumerated
+ * @files: (element-type NautilusFile): the files of the directory
+ *
+ * Saves the snapshot of the directory in the background.
+ */
+void
+nautilus_directory_snapshot_save (GFile  *location,
+                                  gint64  directory_mtime,
+                                  GList  *files)
+{
+    g_autoptr (GTask) task = g_task_new (location, NULL, NULL, NULL);
+
+    g_task_set_source_tag (task, nautilus_directory_snapshot_save);
+    g_task_set_task_data (task,
+                          nautilus_directory_snapshot_serialize (directory_mtime, files),
+                          (GDestroyNotify) g_bytes_unref);
+    g_task_run_in_thread (task, save_thread);
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2026 The GNOME project contributors
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* Smaller directories are listed fast enough without a snapshot */
+#define NAUTILUS_DIRECTORY_SNAPSHOT_MIN_FILES 1000
+
+void       nautilus_directory_snapshot_load_async  (GFile               *location,
+                                                    GCancellable        *cancellable,
+                                                    GAsyncReadyCallback  callback,
+                                                    gpointer             user_data);
+GPtrArray *nautilus_directory_snapshot_load_finish (GAsyncResult        *result,
+                                                    gint64              *directory_mtime);
+void       nautilus_directory_snapshot_save        (GFile               *location,
+                                                    gint64               directory_mtime,
+                                                    GList               *files);
+void       nautilus_directory_snapshot_delete      (GFile               *location);
+
+GBytes    *nautilus_directory_snapshot_serialize   (gint64               directory_mtime,
+                                                    GList               *files);
+GPtrArray *nautilus_directory_snapshot_parse       (GBytes              *bytes,
+                                                    gint64               directory_mtime);
+
+G_END_DECLS
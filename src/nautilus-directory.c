@@ -59,6 +59,16 @@ static GParamSpec *properties[NUM_PROPERTIES] = { NULL, };
 
 static GHashTable *directories;
 
+/* Recently viewed directories are kept loaded and monitored after their last
+ * view goes away, so that going back to them shows them right away, instead
+ * of enumerating them again. Directories beyond these limits are released,
+ * the least recently viewed first. */
+#define RECENT_DIRECTORIES_MAX 5
+#define RECENT_DIRECTORIES_MAX_FILES 100000
+
+/* Most recently viewed first, each with a ref and a monitor */
+static GQueue recent_directories = G_QUEUE_INIT;
+
 static NautilusDirectory *nautilus_directory_new (GFile *location);
 static void               set_directory_location (NautilusDirectory *directory,
                                                   GFile             *location);
@@ -218,7 +228,8 @@ nautilus_directory_finalize (GObject *object)
     g_assert (directory->details->directory_load_in_progress == NULL);
     g_assert (directory->details->count_in_progress == NULL);
     g_assert (directory->details->dequeue_pending_idle_id == 0);
-    g_list_free_full (directory->details->pending_file_info, g_object_unref);
+    g_list_free_full (directory->details->pending_file_info,
+                      (GDestroyNotify) nautilus_directory_pending_file_info_free);
 
     G_OBJECT_CLASS (nautilus_directory_parent_class)->finalize (object);
 }
@@ -787,6 +798,90 @@ nautilus_directory_is_local_or_fuse (NautilusDirectory *directory)
     }
 }
 
+static guint
+count_recent_directories_files (void)
+{
+    guint n_files = 0;
+
+    for (GList *l = recent_directories.head; l != NULL; l = l->next)
+    {
+        NautilusDirectory *directory = l->data;
+
+        n_files += g_hash_table_size (directory->details->file_hash);
+    }
+
+    return n_files;
+}
+
+static void on_recent_directory_done_loading (NautilusDirectory *directory,
+                                              gpointer           user_data);
+
+static void
+trim_recent_directories (void)
+{
+    while (recent_directories.length > RECENT_DIRECTORIES_MAX ||
+           (!g_queue_is_empty (&recent_directories) &&
+            count_recent_directories_files () > RECENT_DIRECTORIES_MAX_FILES))
+    {
+        NautilusDirectory *oldest = g_queue_pop_tail (&recent_directories);
+
+        g_signal_handlers_disconnect_by_func (oldest, on_recent_directory_done_loading, NULL);
+        nautilus_directory_file_monitor_remove (oldest, &recent_directories);
+        nautilus_directory_unref (oldest);
+    }
+}
+
+/* The number of files is only known once the directory is loaded */
+static void
+on_recent_directory_done_loading (NautilusDirectory *directory,
+                                  gpointer           user_data)
+{
+    nautilus_directory_ref (directory);
+    trim_recent_directories ();
+    nautilus_directory_unref (directory);
+}
+
+/**
+ * nautilus_directory_keep_loaded:
+ * @directory: a #NautilusDirectory being viewed
+ *
+ * Keeps the files of @directory loaded and monitored for a while after it is
+ * not viewed anymore, so it can be shown again without reloading it. Only
+ * the few most recently viewed directories are kept, within a limit of files.
+ * Only native directories are kept: monitoring remote ones is not cheap, even
+ * when they have a local path through FUSE.
+ */
+void
+nautilus_directory_keep_loaded (NautilusDirectory *directory)
+{
+    GList *link;
+
+    g_return_if_fail (NAUTILUS_IS_DIRECTORY (directory));
+
+    link = g_queue_find (&recent_directories, directory);
+    if (link != NULL)
+    {
+        g_queue_unlink (&recent_directories, link);
+        g_queue_push_head_link (&recent_directories, link);
+        return;
+    }
+
+    if (!g_file_is_native (directory->details->location))
+    {
+        return;
+    }
+
+    g_queue_push_head (&recent_directories, nautilus_directory_ref (directory));
+    nautilus_directory_file_monitor_add (directory, &recent_directories, TRUE,
+                                         NAUTILUS_FILE_ATTRIBUTE_INFO |
+                                         NAUTILUS_FILE_ATTRIBUTE_EXTRA_INFO,
+                                         NULL, NULL);
+    g_signal_connect (directory, "done-loading",
+                      G_CALLBACK (on_recent_directory_done_loading), NULL);
+
+    trim_recent_directories ();
+}
+
 gboolean
 nautilus_directory_is_in_trash (NautilusDirectory *directory)
 {
@@ -1055,23 +1150,68 @@ get_parent_directory (GFile *location)
     return NULL;
 }
 
-/* If a directory object exists for this one's parent, then
- * return it, otherwise return NULL.
+/* Notifications come in batches, mostly of files in the same directory. This
+ * looks up the directory of the parent once for all the consecutive locations
+ * in it, comparing their parent to the previous one instead of hashing it.
  */
-static NautilusDirectory *
-get_parent_directory_if_exists (GFile *location)
+typedef struct
 {
-    NautilusDirectory *directory;
     GFile *parent;
+    NautilusDirectory *directory;
+} ParentLookup;
 
-    parent = g_file_get_parent (location);
-    if (parent)
+static void
+parent_lookup_clear (ParentLookup *lookup)
+{
+    g_clear_object (&lookup->parent);
+    g_clear_pointer (&lookup->directory, nautilus_directory_unref);
+}
+
+/* Returns the directory of the parent of @location if it exists, not reffed */
+static NautilusDirectory *
+parent_lookup_get_directory (ParentLookup *lookup,
+                             GFile        *location)
+{
+    g_autoptr (GFile) parent = g_file_get_parent (location);
+
+    if (parent == NULL)
     {
-        directory = nautilus_directory_get_internal (parent, FALSE);
-        g_object_unref (parent);
-        return directory;
+        parent_lookup_clear (lookup);
     }
-    return NULL;
+    else if (lookup->parent == NULL || !g_file_equal (parent, lookup->parent))
+    {
+        parent_lookup_clear (lookup);
+        lookup->parent = g_steal_pointer (&parent);
+        lookup->directory = nautilus_directory_get_existing (lookup->parent);
+    }
+
+    return lookup->directory;
+}
+
+/* Like nautilus_file_get_existing(), reusing the parent lookup */
+static NautilusFile *
+parent_lookup_get_file (ParentLookup *lookup,
+                        GFile        *location)
+{
+    NautilusDirectory *directory = parent_lookup_get_directory (lookup, location);
+    g_autofree char *basename = NULL;
+    NautilusFile *file;
+
+    if (lookup->parent == NULL)
+    {
+        /* The root of a filesystem, which is its own directory */
+        return nautilus_file_get_existing (location);
+    }
+
+    if (directory == NULL)
+    {
+        return NULL;
+    }
+
+    basename = g_file_get_basename (location);
+    file = nautilus_directory_find_file_by_name (directory, basename);
+
+    return file != NULL ? nautilus_file_ref (file) : NULL;
 }
 
 static void
@@ -1203,7 +1343,8 @@ nautilus_directory_notify_files_added (GList *files)
     NautilusDirectory *directory;
     GHashTable *parent_directories;
     NautilusFile *file;
-    GFile *location, *parent;
+    GFile *location;
+    ParentLookup lookup = { NULL, NULL };
 
     /* Make a list of added files in each directory. */
     added_lists = g_hash_table_new (NULL, NULL);
@@ -1216,7 +1357,7 @@ nautilus_directory_notify_files_added (GList *files)
         location = p->data;
 
         /* See if the directory is already known. */
-        directory = get_parent_directory_if_exists (location);
+        directory = parent_lookup_get_directory (&lookup, location);
         if (directory == NULL)
         {
             /* In case the directory is not being
@@ -1226,11 +1367,9 @@ nautilus_directory_notify_files_added (GList *files)
 
 
             file = NULL;
-            parent = g_file_get_parent (location);
-            if (parent)
+            if (lookup.parent != NULL)
             {
-                file = nautilus_file_get_existing (parent);
-                g_object_unref (parent);
+                file = nautilus_file_get_existing (lookup.parent);
             }
 
             if (file != NULL)
@@ -1247,11 +1386,10 @@ nautilus_directory_notify_files_added (GList *files)
         /* If no one is monitoring files in the directory, nothing to do. */
         if (!nautilus_directory_is_file_list_monitored (directory))
         {
-            nautilus_directory_unref (directory);
             continue;
         }
 
-        file = nautilus_file_get_existing (location);
+        file = parent_lookup_get_file (&lookup, location);
         /* We check is_added here, because the file could have been added
          * to the directory by a nautilus_file_get() but not gotten
          * files_added emitted
@@ -1270,9 +1408,10 @@ nautilus_directory_notify_files_added (GList *files)
                                      g_object_ref (location));
         }
         nautilus_file_unref (file);
-        nautilus_directory_unref (directory);
     }
 
+    parent_lookup_clear (&lookup);
+
     /* Now get file info for the new files. This creates NautilusFile
      * objects for the new files, and sends out a files_added signal.
      */
@@ -1290,8 +1429,9 @@ nautilus_directory_notify_files_changed (GList *files)
     GHashTable *changed_lists;
     GList *node;
     GFile *location;
-    g_autoptr (NautilusDirectory) dir = NULL;
+    NautilusDirectory *dir;
     NautilusFile *file;
+    ParentLookup lookup = { NULL, NULL };
 
     /* Make a list of changed files in each directory. */
     changed_lists = g_hash_table_new (NULL, NULL);
@@ -1302,7 +1442,7 @@ nautilus_directory_notify_files_changed (GList *files)
         location = node->data;
 
         /* Find the file. */
-        file = nautilus_file_get_existing (location);
+        file = parent_lookup_get_file (&lookup, location);
         if (file != NULL)
         {
             NautilusDirectory *directory;
@@ -1319,9 +1459,7 @@ nautilus_directory_notify_files_changed (GList *files)
         }
         else
         {
-            g_autoptr (GFile) parent = g_file_get_parent (location);
-
-            dir = nautilus_directory_get_existing (parent);
+            dir = lookup.directory;
             if (dir != NULL && dir->details->new_files_in_progress != NULL &&
                 files != dir->details->files_changed_while_adding)
             {
@@ -1332,6 +1470,8 @@ nautilus_directory_notify_files_changed (GList *files)
         }
     }
 
+    parent_lookup_clear (&lookup);
+
     /* Now send out the changed signals. */
     g_hash_table_foreach (changed_lists, call_files_changed_unref_free_list, NULL);
     g_hash_table_destroy (changed_lists);
@@ -1359,6 +1499,7 @@ nautilus_directory_notify_files_removed (GList *files)
     GHashTable *parent_directories;
     NautilusFile *file;
     GFile *location;
+    ParentLookup lookup = { NULL, NULL };
 
     /* Make a list of changed files in each directory. */
     changed_lists = g_hash_table_new (NULL, NULL);
@@ -1374,15 +1515,14 @@ nautilus_directory_notify_files_removed (GList *files)
         location = p->data;
 
         /* Update file count for parent directory if anyone might care. */
-        directory = get_parent_directory_if_exists (location);
+        directory = parent_lookup_get_directory (&lookup, location);
         if (directory != NULL)
         {
             collect_parent_directories (parent_directories, directory);
-            nautilus_directory_unref (directory);
         }
 
         /* Find the file. */
-        file = nautilus_file_get_existing (location);
+        file = parent_lookup_get_file (&lookup, location);
         if (file != NULL && !nautilus_file_rename_in_progress (file))
         {
             directory = nautilus_file_get_directory (file);
@@ -1395,6 +1535,8 @@ nautilus_directory_notify_files_removed (GList *files)
         nautilus_file_unref (file);
     }
 
+    parent_lookup_clear (&lookup);
+
     /* Now send out the changed signals. */
     g_hash_table_foreach (changed_lists, call_files_changed_unref_free_list, NULL);
     g_hash_table_destroy (changed_lists);
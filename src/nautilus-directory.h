@@ -209,6 +209,7 @@ void               nautilus_directory_file_monitor_add         (NautilusDirector
 void               nautilus_directory_file_monitor_remove      (NautilusDirectory         *directory,
 								gconstpointer              client);
 void               nautilus_directory_force_reload             (NautilusDirectory         *directory);
+void               nautilus_directory_keep_loaded              (NautilusDirectory         *directory);
 
 /* Get a list of all files currently known in the directory. */
 GList *            nautilus_directory_get_file_list            (NautilusDirectory         *directory);
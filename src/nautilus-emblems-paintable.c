@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2026 The GNOME project contributors
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "nautilus-emblems-paintable.h"
+
+#include "nautilus-file.h"
+
+/**
+ * NautilusEmblemsPaintable:
+ *
+ * Draws a row or a column of emblems, as a single paintable.
+ *
+ * Many files share the same emblems, so the paintables are cached by the
+ * emblems key of the files: cells showing files with the same emblems share
+ * the paintable, and a cell doesn't need to do anything when the emblems of
+ * its file didn't change. The emblems are looked up in the icon theme only
+ * once per combination.
+ *
+ * Symbolic emblems are recolored like in a #GtkImage, by showing the
+ * paintable in a #GtkImage, sized with nautilus_emblems_paintable_get_length().
+ */
+
+#define EMBLEM_SIZE 16
+#define EMBLEM_SPACING 6
+
+struct _NautilusEmblemsPaintable
+{
+    GObject parent_instance;
+
+    GPtrArray *icons; /* of GtkIconPaintable */
+    GtkOrientation orientation;
+};
+
+static void nautilus_emblems_paintable_paintable_init (GdkPaintableInterface *iface);
+static void nautilus_emblems_paintable_symbolic_paintable_init (GtkSymbolicPaintableInterface *iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE (NautilusEmblemsPaintable, nautilus_emblems_paintable, G_TYPE_OBJECT,
+                               G_IMPLEMENT_INTERFACE (GDK_TYPE_PAINTABLE,
+                                                      nautilus_emblems_paintable_paintable_init)
+                               G_IMPLEMENT_INTERFACE (GTK_TYPE_SYMBOLIC_PAINTABLE,
+                                                      nautilus_emblems_paintable_symbolic_paintable_init))
+
+typedef struct
+{
+    const char *emblems_key; /* Interned */
+    gboolean starred;
+    GtkOrientation orientation;
+    int scale;
+} PaintableKey;
+
+/* PaintableKey => NautilusEmblemsPaintable */
+static GHashTable *paintables = NULL;
+
+static void
+nautilus_emblems_paintable_finalize (GObject *object)
+{
+    NautilusEmblemsPaintable *self = NAUTILUS_EMBLEMS_PAINTABLE (object);
+
+    g_ptr_array_unref (self->icons);
+
+    G_OBJECT_CLASS (nautilus_emblems_paintable_parent_class)->finalize (object);
+}
+
+static void
+nautilus_emblems_paintable_class_init (NautilusEmblemsPaintableClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->finalize = nautilus_emblems_paintable_finalize;
+}
+
+static void
+nautilus_emblems_paintable_init (NautilusEmblemsPaintable *self)
+{
+    self->icons = g_ptr_array_new_with_free_func (g_object_unref);
+}
+
+/**
+ * nautilus_emblems_paintable_get_length:
+ * @self: a #NautilusEmblemsPaintable
+ *
+ * Returns: the size of @self along its orientation, which is also its
+ *     largest dimension.
+ */
+int
+nautilus_emblems_paintable_get_length (NautilusEmblemsPaintable *self)
+{
+    g_return_val_if_fail (NAUTILUS_IS_EMBLEMS_PAINTABLE (self), 0);
+
+    return self->icons->len * (EMBLEM_SIZE + EMBLEM_SPACING) - EMBLEM_SPACING;
+}
+
+static int
+nautilus_emblems_paintable_get_intrinsic_width (GdkPaintable *paintable)
+{
+    NautilusEmblemsPaintable *self = NAUTILUS_EMBLEMS_PAINTABLE (paintable);
+
+    if (self->orientation == GTK_ORIENTATION_VERTICAL)
+    {
+        return EMBLEM_SIZE;
+    }
+
+    return nautilus_emblems_paintable_get_length (self);
+}
+
+static int
+nautilus_emblems_paintable_get_intrinsic_height (GdkPaintable *paintable)
+{
+    NautilusEmblemsPaintable *self = NAUTILUS_EMBLEMS_PAINTABLE (paintable);
+
+    if (self->orientation == GTK_ORIENTATION_HORIZONTAL)
+    {
+        return EMBLEM_SIZE;
+    }
+
+    return nautilus_emblems_paintable_get_length (self);
+}
+
+static void
+snapshot_emblems (NautilusEmblemsPaintable *self,
+                  GdkSnapshot              *gdk_snapshot,
+                  double                    width,
+                  double                    height,
+                  const GdkRGBA            *colors,
+                  gsize                     n_colors)
+{
+    GtkSnapshot *snapshot = GTK_SNAPSHOT (gdk_snapshot);
+    /* In case it is not drawn at its intrinsic size */
+    double zoom = MIN (width / nautilus_emblems_paintable_get_intrinsic_width (GDK_PAINTABLE (self)),
+                       height / nautilus_emblems_paintable_get_intrinsic_height (GDK_PAINTABLE (self)));
+    double size = EMBLEM_SIZE * zoom;
+    double step = (EMBLEM_SIZE + EMBLEM_SPACING) * zoom;
+
+    for (guint i = 0; i < self->icons->len; i++)
+    {
+        GtkIconPaintable *icon = g_ptr_array_index (self->icons, i);
+        float offset = i * step;
+
+        gtk_snapshot_save (snapshot);
+        gtk_snapshot_translate (snapshot,
+                                self->orientation == GTK_ORIENTATION_HORIZONTAL ?
+                                &GRAPHENE_POINT_INIT (offset, 0) :
+                                &GRAPHENE_POINT_INIT (0, offset));
+
+        if (colors != NULL)
+        {
+            gtk_symbolic_paintable_snapshot_symbolic (GTK_SYMBOLIC_PAINTABLE (icon),
+                                                      gdk_snapshot, size, size,
+                                                      colors, n_colors);
+        }
+        else
+        {
+            gdk_paintable_snapshot (GDK_PAINTABLE (icon), gdk_snapshot, size, size);
+        }
+
+        gtk_snapshot_restore (snapshot);
+    }
+}
+
+static void
+nautilus_emblems_paintable_snapshot (GdkPaintable *paintable,
+                                     GdkSnapshot  *snapshot,
+                                     double        width,
+                                     double        height)
+{
+    snapshot_emblems (NAUTILUS_EMBLEMS_PAINTABLE (paintable), snapshot, width, height, NULL, 0);
+}
+
+static GdkPaintableFlags
+nautilus_emblems_paintable_get_flags (GdkPaintable *paintable)
+{
+    return GDK_PAINTABLE_STATIC_SIZE | GDK_PAINTABLE_STATIC_CONTENTS;
+}
+
+static void
+nautilus_emblems_paintable_paintable_init (GdkPaintableInterface *iface)
+{
+    iface->snapshot = nautilus_emblems_paintable_snapshot;
+    iface->get_flags = nautilus_emblems_paintable_get_flags;
+    iface->get_intrinsic_width = nautilus_emblems_paintable_get_intrinsic_width;
+    iface->get_intrinsic_height = nautilus_emblems_paintable_get_intrinsic_height;
+}
+
+static void
+nautilus_emblems_paintable_snapshot_symbolic (GtkSymbolicPaintable *paintable,
+                                              GdkSnapshot          *snapshot,
+                                              double                width,
+                                              double                height,
+                                              const GdkRGBA        *colors,
+                                              gsize                 n_colors)
+{
+    snapshot_emblems (NAUTILUS_EMBLEMS_PAINTABLE (paintable), snapshot, width, height, colors, n_colors);
+}
+
+static void
+nautilus_emblems_paintable_symbolic_paintable_init (GtkSymbolicPaintableInterface *iface)
+{
+    iface->snapshot_symbolic = nautilus_emblems_paintable_snapshot_symbolic;
+}
+
+static guint
+paintable_key_hash (gconstpointer key)
+{
+    const PaintableKey *k = key;
+
+    return g_direct_hash (k->emblems_key) ^ (k->starred << 1) ^ (k->orientation << 2) ^ (k->scale << 3);
+}
+
+static gboolean
+paintable_key_equal (gconstpointer a,
+                     gconstpointer b)
+{
+    const PaintableKey *k1 = a;
+    const PaintableKey *k2 = b;
+
+    return k1->emblems_key == k2->emblems_key &&
+           k1->starred == k2->starred &&
+           k1->orientation == k2->orientation &&
+           k1->scale == k2->scale;
+}
+
+static NautilusEmblemsPaintable *
+emblems_paintable_new (GList          *emblems,
+                       GtkOrientation  orientation,
+                       int             scale)
+{
+    NautilusEmblemsPaintable *self = g_object_new (NAUTILUS_TYPE_EMBLEMS_PAINTABLE, NULL);
+    GtkIconTheme *theme = gtk_icon_theme_get_for_display (gdk_display_get_default ());
+
+    self->orientation = orientation;
+
+    for (GList *l = emblems; l != NULL; l = l->next)
+    {
+        if (!gtk_icon_theme_has_gicon (theme, l->data))
+        {
+            g_autofree gchar *icon_string = g_icon_to_string (l->data);
+            g_warning ("Failed to add emblem. “%s” not found in the icon theme",
+                       icon_string);
+            continue;
+        }
+
+        g_ptr_array_add (self->icons,
+                         gtk_icon_theme_lookup_by_gicon (theme, l->data, EMBLEM_SIZE, scale,
+                                                         GTK_TEXT_DIR_NONE, 0));
+    }
+
+    return self;
+}
+
+/**
+ * nautilus_emblems_paintable_lookup_for_file:
+ * @file: the file to draw the emblems of
+ * @show_starred: whether to draw an emblem for starred files too
+ * @orientation: whether to draw them in a row or in a column
+ * @scale: the scale factor of the display
+ *
+ * Returns: (transfer full) (nullable): a paintable drawing the emblems of
+ *     @file, shared with other files with the same emblems, or %NULL if
+ *     there is no emblem to draw.
+ */
+GdkPaintable *
+nautilus_emblems_paintable_lookup_for_file (NautilusFile   *file,
+                                            gboolean        show_starred,
+                                            GtkOrientation  orientation,
+                                            int             scale)
+{
+    PaintableKey key;
+    NautilusEmblemsPaintable *self;
+
+    key.emblems_key = nautilus_file_get_emblems_key (file);
+    key.starred = show_starred && nautilus_file_is_starred (file);
+    key.orientation = orientation;
+    key.scale = scale;
+
+    if (key.emblems_key == NULL && !key.starred)
+    {
+        return NULL;
+    }
+
+    if (paintables == NULL)
+    {
+        paintables = g_hash_table_new_full (paintable_key_hash, paintable_key_equal,
+                                            g_free, g_object_unref);
+    }
+
+    self = g_hash_table_lookup (paintables, &key);
+    if (self == NULL)
+    {
+        g_autolist (GIcon) emblems = nautilus_file_get_emblem_icons (file);
+
+        if (key.starred)
+        {
+            emblems = g_list_prepend (emblems, g_themed_icon_new ("starred-symbolic"));
+        }
+
+        self = emblems_paintable_new (emblems, orientation, scale);
+        g_hash_table_insert (paintables, g_memdup2 (&key, sizeof (key)), self);
+    }
+
+    if (self->icons->len == 0)
+    {
+        return NULL;
+    }
+
+    return g_object_ref (GDK_PAINTABLE (self));
+}
+
+/**
+ * nautilus_emblems_paintable_clear_cache:
+ *
+ * Drops the cached paintables, for the emblems to be looked up again, e.g.
+ * after the icon theme changed.
+ */
+void
+nautilus_emblems_paintable_clear_cache (void)
+{
+    if (paintables != NULL)
+    {
+        g_hash_table_remove_all (paintables);
+    }
+}
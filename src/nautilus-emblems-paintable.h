@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2026 The GNOME project contributors
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+#include "nautilus-types.h"
+
+G_BEGIN_DECLS
+
+#define NAUTILUS_TYPE_EMBLEMS_PAINTABLE (nautilus_emblems_paintable_get_type ())
+
+G_DECLARE_FINAL_TYPE (NautilusEmblemsPaintable, nautilus_emblems_paintable, NAUTILUS, EMBLEMS_PAINTABLE, GObject)
+
+GdkPaintable *nautilus_emblems_paintable_lookup_for_file (NautilusFile             *file,
+                                                         gboolean                  show_starred,
+                                                         GtkOrientation            orientation,
+                                                         int                       scale);
+int           nautilus_emblems_paintable_get_length     (NautilusEmblemsPaintable *self);
+
+void          nautilus_emblems_paintable_clear_cache    (void);
+
+G_END_DECLS
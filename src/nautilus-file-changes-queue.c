@@ -128,6 +128,32 @@ nautilus_file_changes_queue_file_moved (GFile *from,
     g_async_queue_push (queue, new_item);
 }
 
+/* Same as calling nautilus_file_changes_queue_file_moved() for each pair of
+ * @from and @to, but without contending for the queue once per file. */
+void
+nautilus_file_changes_queue_files_moved (GList *from,
+                                         GList *to)
+{
+    GAsyncQueue *queue;
+
+    g_return_if_fail (g_list_length (from) == g_list_length (to));
+
+    queue = nautilus_file_changes_queue_get ();
+
+    g_async_queue_lock (queue);
+    for (GList *f = from, *t = to; f != NULL; f = f->next, t = t->next)
+    {
+        NautilusFileChange *new_item;
+
+        new_item = g_new (NautilusFileChange, 1);
+        new_item->kind = CHANGE_FILE_MOVED;
+        new_item->from = g_object_ref (f->data);
+        new_item->to = g_object_ref (t->data);
+        g_async_queue_push_unlocked (queue, new_item);
+    }
+    g_async_queue_unlock (queue);
+}
+
 static void
 pairs_list_free (GList *pairs)
 {
@@ -28,5 +28,7 @@ void nautilus_file_changes_queue_file_unmounted                  (GFile      *lo
 void nautilus_file_changes_queue_file_removed                    (GFile      *location);
 void nautilus_file_changes_queue_file_moved                      (GFile      *from,
 								  GFile      *to);
+void nautilus_file_changes_queue_files_moved                     (GList      *from,
+								  GList      *to);
 
 void nautilus_file_changes_consume_changes                       (void);
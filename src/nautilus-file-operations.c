@@ -36,6 +36,7 @@
 #include "nautilus-file-changes-queue.h"
 
 #include "nautilus-progress-info.h"
+#include "nautilus-progress-info-manager.h"
 
 #include <adwaita.h>
 #include <glib/gi18n.h>
@@ -54,6 +55,8 @@
 #include "nautilus-filename-utilities.h"
 #include "nautilus-tag-manager.h"
 #include "nautilus-trash-monitor.h"
+#include "nautilus-transfer-estimator.h"
+#include "nautilus-transfer-journal.h"
 #include "nautilus-file-utilities.h"
 #include "nautilus-file-undo-operations.h"
 #include "nautilus-file-undo-manager.h"
@@ -75,6 +78,7 @@ typedef struct
     NautilusFileOperationsDBusData *dbus_data;
     guint inhibit_cookie;
     NautilusProgressInfo *progress;
+    NautilusProgressInfoManager *progress_manager;
     GCancellable *cancellable;
     GHashTable *skip_files;
     GHashTable *skip_readdir_error;
@@ -86,6 +90,31 @@ typedef struct
     gboolean delete_all;
 } CommonJob;
 
+typedef enum
+{
+    OP_KIND_COPY,
+    OP_KIND_MOVE,
+    OP_KIND_DELETE,
+    OP_KIND_TRASH,
+    OP_KIND_COMPRESS
+} OpKind;
+
+typedef struct
+{
+    int num_files_children;
+    goffset num_bytes_children;
+} SourceDirInfo;
+
+typedef struct
+{
+    int num_files;
+    goffset num_bytes;
+    goffset largest_file_bytes;
+    int num_files_since_progress;
+    OpKind op;
+    GHashTable *scanned_dirs_info;
+} SourceInfo;
+
 typedef struct
 {
     CommonJob common;
@@ -95,8 +124,16 @@ typedef struct
     GFile *fake_display_source;
     GHashTable *debuting_files;
     gchar *target_name;
+    NautilusTransferJournal *journal;
+    NautilusTransferEstimator *estimator;
     NautilusCopyCallback done_callback;
     gpointer done_callback_data;
+
+    /* Handed from the scan thread over to the transfer thread */
+    SourceInfo source_info;
+    char *dest_fs_id;
+    char *dest_fs_type;
+    GList *fallbacks;
 } CopyMoveJob;
 
 typedef struct
@@ -155,31 +192,6 @@ typedef struct
     guint32 dir_mask;
 } SetPermissionsJob;
 
-typedef enum
-{
-    OP_KIND_COPY,
-    OP_KIND_MOVE,
-    OP_KIND_DELETE,
-    OP_KIND_TRASH,
-    OP_KIND_COMPRESS
-} OpKind;
-
-typedef struct
-{
-    int num_files_children;
-    goffset num_bytes_children;
-} SourceDirInfo;
-
-typedef struct
-{
-    int num_files;
-    goffset num_bytes;
-    goffset largest_file_bytes;
-    int num_files_since_progress;
-    OpKind op;
-    GHashTable *scanned_dirs_info;
-} SourceInfo;
-
 typedef struct
 {
     int num_files;
@@ -187,6 +199,7 @@ typedef struct
     OpKind op;
     guint64 last_report_time;
     int last_reported_files_left;
+    int last_reported_num_files;
 
     /*
      * This is used when reporting progress for copy/move operations to not show
@@ -313,16 +326,25 @@ static void empty_trash_task_done (GObject      *source_object,
 static char *query_fs_type (GFile        *file,
                             GCancellable *cancellable);
 
-static void nautilus_file_operations_copy (GTask        *task,
-                                           gpointer      source_object,
-                                           gpointer      task_data,
-                                           GCancellable *cancellable);
-
 static void nautilus_file_operations_move (GTask        *task,
                                            gpointer      source_object,
                                            gpointer      task_data,
                                            GCancellable *cancellable);
 
+static void move_scan_thread_func (GTask        *task,
+                                   gpointer      source_object,
+                                   gpointer      task_data,
+                                   GCancellable *cancellable);
+
+static void move_transfer_thread_func (GTask        *task,
+                                       gpointer      source_object,
+                                       gpointer      task_data,
+                                       GCancellable *cancellable);
+
+static void move_task_done (GObject      *source_object,
+                            GAsyncResult *res,
+                            gpointer      user_data);
+
 static gboolean
 is_dir (GFile        *file,
         GCancellable *cancellable)
@@ -336,95 +358,6 @@ is_dir (GFile        *file,
     return file_type == G_FILE_TYPE_DIRECTORY;
 }
 
-/* keep in time with get_formatted_time ()
- *
- * This counts and outputs the number of “time units”
- * formatted and displayed by get_formatted_time ().
- * For instance, if get_formatted_time outputs “3 hours, 4 minutes”
- * it yields 7.
- */
-static int
-seconds_count_format_time_units (int seconds)
-{
-    int minutes;
-    int hours;
-
-    if (seconds < 0)
-    {
-        /* Just to make sure... */
-        seconds = 0;
-    }
-
-    if (seconds < 60)
-    {
-        /* seconds */
-        return seconds;
-    }
-
-    if (seconds < 60 * 60)
-    {
-        /* minutes */
-        minutes = seconds / 60;
-        return minutes;
-    }
-
-    hours = seconds / (60 * 60);
-
-    if (seconds < 60 * 60 * 4)
-    {
-        /* minutes + hours */
-        minutes = (seconds - hours * 60 * 60) / 60;
-        return minutes + hours;
-    }
-
-    return hours;
-}
-
-static gchar *
-get_formatted_time (int seconds)
-{
-    int minutes;
-    int hours;
-    gchar *res;
-
-    if (seconds < 0)
-    {
-        /* Just to make sure... */
-        seconds = 0;
-    }
-
-    if (seconds < 60)
-    {
-        return g_strdup_printf (ngettext ("%'d second", "%'d seconds", (int) seconds), (int) seconds);
-    }
-
-    if (seconds < 60 * 60)
-    {
-        minutes = seconds / 60;
-        return g_strdup_printf (ngettext ("%'d minute", "%'d minutes", minutes), minutes);
-    }
-
-    hours = seconds / (60 * 60);
-
-    if (seconds < 60 * 60 * 4)
-    {
-        gchar *h, *m;
-
-        minutes = (seconds - hours * 60 * 60) / 60;
-
-        h = g_strdup_printf (ngettext ("%'d hour", "%'d hours", hours), hours);
-        m = g_strdup_printf (ngettext ("%'d minute", "%'d minutes", minutes), minutes);
-        res = g_strconcat (h, ", ", m, NULL);
-        g_free (h);
-        g_free (m);
-        return res;
-    }
-
-    return g_strdup_printf (ngettext ("%'d hour",
-                                      "%'d hours",
-                                      hours), hours);
-}
-
 static gboolean
 has_invalid_xml_char (char *str)
 {
@@ -549,6 +482,7 @@ init_common (gsize                           job_size,
     }
 
     common->progress = nautilus_progress_info_new ();
+    common->progress_manager = nautilus_progress_info_manager_dup_singleton ();
     common->cancellable = nautilus_progress_info_get_cancellable (common->progress);
     common->time = g_timer_new ();
     common->inhibit_cookie = 0;
@@ -560,6 +494,8 @@ static void
 finalize_common (CommonJob *common)
 {
     nautilus_progress_info_finish (common->progress);
+    nautilus_progress_info_manager_release_device (common->progress_manager,
+                                                   common->progress);
 
     if (common->inhibit_cookie != 0)
     {
@@ -597,6 +533,7 @@ finalize_common (CommonJob *common)
     }
 
     g_object_unref (common->progress);
+    g_object_unref (common->progress_manager);
     g_object_unref (common->cancellable);
     g_free (common);
 }
@@ -1223,10 +1160,10 @@ report_delete_progress (CommonJob    *job,
     double elapsed, transfer_rate;
     int remaining_time;
     gint64 now;
-    char *details;
     gboolean is_clear_action;
     char *status;
     DeleteJob *delete_job;
+    NautilusProgressDetailsFormat details_format;
 
     delete_job = (DeleteJob *) job;
     now = g_get_monotonic_time ();
@@ -1338,68 +1275,6 @@ report_delete_progress (CommonJob    *job,
         }
     }
 
-    if (elapsed < SECONDS_NEEDED_FOR_RELIABLE_TRANSFER_RATE ||
-        transfer_rate == 0)
-    {
-        if (files_left > 0)
-        {
-            /* To translators: %'d is the number of files completed for the operation,
-             * so it will be something like 2/14. */
-            details = g_strdup_printf (_("%'d / %'d"),
-                                       transfer_info->num_files + 1,
-                                       source_info->num_files);
-        }
-        else
-        {
-            /* To translators: %'d is the number of files completed for the operation,
-             * so it will be something like 2/14. */
-            details = g_strdup_printf (_("%'d / %'d"),
-                                       transfer_info->num_files,
-                                       source_info->num_files);
-        }
-    }
-    else
-    {
-        if (files_left > 0)
-        {
-            gchar *time_left_message;
-            gchar *files_per_second_message;
-            gchar *concat_detail;
-            g_autofree gchar *formatted_time = NULL;
-
-            /* To translators: %s will expand to a time duration like "2 minutes".
-             * So the whole thing will be something like "1 / 5 -- 2 hours left (4 files/s)"
-             *
-             * The singular/plural form will be used depending on the remaining time (i.e. the %s argument).
-             */
-            time_left_message = ngettext ("%'d / %'d \xE2\x80\x94 %s left",
-                                          "%'d / %'d \xE2\x80\x94 %s left",
-                                          seconds_count_format_time_units (remaining_time));
-            transfer_rate += 0.5;
-            files_per_second_message = ngettext ("(%d file/s)",
-                                                 "(%d files/s)",
-                                                 (int) transfer_rate);
-            concat_detail = g_strconcat (time_left_message, " ", files_per_second_message, NULL);
-
-            formatted_time = get_formatted_time (remaining_time);
-            details = g_strdup_printf (concat_detail,
-                                       transfer_info->num_files + 1, source_info->num_files,
-                                       formatted_time,
-                                       (int) transfer_rate);
-
-            g_free (concat_detail);
-        }
-        else
-        {
-            /* To translators: %'d is the number of files completed for the operation,
-             * so it will be something like 2/14. */
-            details = g_strdup_printf (_("%'d / %'d"),
-                                       transfer_info->num_files,
-                                       source_info->num_files);
-        }
-    }
-    nautilus_progress_info_take_details (job->progress, details);
-
     if (elapsed > SECONDS_NEEDED_FOR_APROXIMATE_TRANSFER_RATE)
     {
         nautilus_progress_info_set_remaining_time (job->progress,
@@ -1408,9 +1283,27 @@ report_delete_progress (CommonJob    *job,
                                                  elapsed);
     }
 
+    /* The details are only formatted on the main thread, when shown */
+    if (elapsed < SECONDS_NEEDED_FOR_RELIABLE_TRANSFER_RATE ||
+        transfer_rate == 0 ||
+        files_left == 0)
+    {
+        details_format = NAUTILUS_PROGRESS_DETAILS_FILES;
+    }
+    else
+    {
+        details_format = NAUTILUS_PROGRESS_DETAILS_FILES_PER_SECOND;
+    }
+
     if (source_info->num_files != 0)
     {
-        nautilus_progress_info_set_progress (job->progress, transfer_info->num_files, source_info->num_files);
+        nautilus_progress_info_publish_counters (job->progress,
+                                                 details_format,
+                                                 transfer_info->num_files + (files_left > 0 ? 1 : 0),
+                                                 transfer_info->num_files,
+                                                 source_info->num_files,
+                                                 0, 0,
+                                                 transfer_rate);
     }
 }
 #pragma GCC diagnostic pop
@@ -1768,13 +1661,13 @@ report_trash_progress (CommonJob    *job,
              */
             time_left_message = ngettext ("%'d / %'d \xE2\x80\x94 %s left",
                                           "%'d / %'d \xE2\x80\x94 %s left",
-                                          seconds_count_format_time_units (remaining_time));
+                                          nautilus_progress_info_count_time_units (remaining_time));
             files_per_second_message = ngettext ("(%d file/s)",
                                                  "(%d files/s)",
                                                  (int) (transfer_rate + 0.5));
             concat_detail = g_strconcat (time_left_message, " ", files_per_second_message, NULL);
 
-            formatted_time = get_formatted_time (remaining_time);
+            formatted_time = nautilus_progress_info_format_time (remaining_time);
             details = g_strdup_printf (concat_detail,
                                        transfer_info->num_files + 1,
                                        source_info->num_files,
@@ -3456,8 +3349,9 @@ report_copy_progress (CopyMoveJob  *copy_job,
     CommonJob *job;
     gboolean is_move;
     gchar *status;
-    char *details;
     gchar *tmp;
+    gboolean has_history;
+    NautilusProgressDetailsFormat details_format;
 
     job = (CommonJob *) copy_job;
 
@@ -3484,10 +3378,12 @@ report_copy_progress (CopyMoveJob  *copy_job,
     }
     transfer_info->last_report_time = now;
 
-    if (files_left != transfer_info->last_reported_files_left ||
-        transfer_info->last_reported_files_left == 0)
+    /* The status only says how many files there are and whether we are done */
+    if (source_info->num_files != transfer_info->last_reported_num_files ||
+        files_left == 0 || transfer_info->last_reported_files_left == 0)
     {
-        /* Avoid changing this unless files_left changed since last time */
+        /* Avoid changing this unless the above changed since last time */
+        transfer_info->last_reported_num_files = source_info->num_files;
         transfer_info->last_reported_files_left = files_left;
 
         if (source_info->num_files == 1)
@@ -3654,125 +3550,35 @@ report_copy_progress (CopyMoveJob  *copy_job,
     elapsed = g_timer_elapsed (job->time, NULL);
     transfer_rate = 0;
     remaining_time = INT_MAX;
-    if (elapsed > 0)
+    has_history = FALSE;
+    if (copy_job->estimator != NULL)
     {
-        transfer_rate = transfer_info->num_bytes / elapsed;
-        if (transfer_rate > 0)
-        {
-            remaining_time = (total_size - transfer_info->num_bytes) / transfer_rate;
-        }
-    }
+        gdouble estimate;
 
-    if (elapsed < SECONDS_NEEDED_FOR_RELIABLE_TRANSFER_RATE ||
-        transfer_rate == 0 ||
-        !transfer_info->partial_progress)
-    {
-        if (source_info->num_files == 1)
+        nautilus_transfer_estimator_update (copy_job->estimator, elapsed,
+                                            transfer_info->num_bytes,
+                                            transfer_info->num_files);
+        transfer_rate = nautilus_transfer_estimator_get_rate (copy_job->estimator);
+        estimate = nautilus_transfer_estimator_get_remaining_time (copy_job->estimator,
+                                                                   total_size - transfer_info->num_bytes,
+                                                                   files_left);
+        if (estimate >= 0)
         {
-            g_autofree gchar *formatted_size_num_bytes = NULL;
-            g_autofree gchar *formatted_size_total_size = NULL;
-
-            formatted_size_num_bytes = g_format_size (transfer_info->num_bytes);
-            formatted_size_total_size = g_format_size (total_size);
-            /* To translators: %s will expand to a size like "2 bytes" or "3 MB", so something like "4 kB / 4 MB" */
-            details = g_strdup_printf (_("%s / %s"),
-                                       formatted_size_num_bytes,
-                                       formatted_size_total_size);
-        }
-        else
-        {
-            if (files_left > 0)
-            {
-                /* To translators: %'d is the number of files completed for the operation,
-                 * so it will be something like 2/14. */
-                details = g_strdup_printf (_("%'d / %'d"),
-                                           transfer_info->num_files + 1,
-                                           source_info->num_files);
-            }
-            else
-            {
-                /* To translators: %'d is the number of files completed for the operation,
-                 * so it will be something like 2/14. */
-                details = g_strdup_printf (_("%'d / %'d"),
-                                           transfer_info->num_files,
-                                           source_info->num_files);
-            }
+            remaining_time = (int) MIN (estimate, INT_MAX);
         }
+        has_history = nautilus_transfer_estimator_has_history (copy_job->estimator);
     }
-    else
+    else if (elapsed > 0)
     {
-        if (source_info->num_files == 1)
-        {
-            if (files_left > 0)
-            {
-                g_autofree gchar *formatted_time = NULL;
-                g_autofree gchar *formatted_size_num_bytes = NULL;
-                g_autofree gchar *formatted_size_total_size = NULL;
-                g_autofree gchar *formatted_size_transfer_rate = NULL;
-
-                formatted_time = get_formatted_time (remaining_time);
-                formatted_size_num_bytes = g_format_size (transfer_info->num_bytes);
-                formatted_size_total_size = g_format_size (total_size);
-                formatted_size_transfer_rate = g_format_size ((goffset) transfer_rate);
-                /* To translators: %s will expand to a size like "2 bytes" or "3 MB", %s to a time duration like
-                 * "2 minutes". So the whole thing will be something like "2 kB / 4 MB -- 2 hours left (4 kB/s)"
-                 *
-                 * The singular/plural form will be used depending on the remaining time (i.e. the %s argument).
-                 */
-                details = g_strdup_printf (ngettext ("%s / %s \xE2\x80\x94 %s left (%s/s)",
-                                                     "%s / %s \xE2\x80\x94 %s left (%s/s)",
-                                                     seconds_count_format_time_units (remaining_time)),
-                                           formatted_size_num_bytes,
-                                           formatted_size_total_size,
-                                           formatted_time,
-                                           formatted_size_transfer_rate);
-            }
-            else
-            {
-                g_autofree gchar *formatted_size_num_bytes = NULL;
-                g_autofree gchar *formatted_size_total_size = NULL;
-
-                formatted_size_num_bytes = g_format_size (transfer_info->num_bytes);
-                formatted_size_total_size = g_format_size (total_size);
-                /* To translators: %s will expand to a size like "2 bytes" or "3 MB". */
-                details = g_strdup_printf (_("%s / %s"),
-                                           formatted_size_num_bytes,
-                                           formatted_size_total_size);
-            }
-        }
-        else
+        transfer_rate = transfer_info->num_bytes / elapsed;
+        if (transfer_rate > 0)
         {
-            if (files_left > 0)
-            {
-                g_autofree gchar *formatted_time = NULL;
-                g_autofree gchar *formatted_size = NULL;
-                formatted_time = get_formatted_time (remaining_time);
-                formatted_size = g_format_size ((goffset) transfer_rate);
-                /* To translators: %s will expand to a time duration like "2 minutes".
-                 * So the whole thing will be something like "1 / 5 -- 2 hours left (4 kB/s)"
-                 *
-                 * The singular/plural form will be used depending on the remaining time (i.e. the %s argument).
-                 */
-                details = g_strdup_printf (ngettext ("%'d / %'d \xE2\x80\x94 %s left (%s/s)",
-                                                     "%'d / %'d \xE2\x80\x94 %s left (%s/s)",
-                                                     seconds_count_format_time_units (remaining_time)),
-                                           transfer_info->num_files + 1, source_info->num_files,
-                                           formatted_time,
-                                           formatted_size);
-            }
-            else
-            {
-                /* To translators: %'d is the number of files completed for the operation,
-                 * so it will be something like 2/14. */
-                details = g_strdup_printf (_("%'d / %'d"),
-                                           transfer_info->num_files,
-                                           source_info->num_files);
-            }
+            remaining_time = (total_size - transfer_info->num_bytes) / transfer_rate;
         }
     }
-    nautilus_progress_info_take_details (job->progress, details);
 
-    if (elapsed > SECONDS_NEEDED_FOR_APROXIMATE_TRANSFER_RATE)
+    /* With the history of the device, the estimate is realistic from the start */
+    if (has_history || elapsed > SECONDS_NEEDED_FOR_APROXIMATE_TRANSFER_RATE)
     {
         nautilus_progress_info_set_remaining_time (job->progress,
                                                    remaining_time);
@@ -3780,7 +3586,29 @@ report_copy_progress (CopyMoveJob  *copy_job,
                                                  elapsed);
     }
 
-    nautilus_progress_info_set_progress (job->progress, transfer_info->num_bytes, total_size);
+    /* The details are only formatted on the main thread, when shown */
+    if ((!has_history && elapsed < SECONDS_NEEDED_FOR_RELIABLE_TRANSFER_RATE) ||
+        transfer_rate == 0 ||
+        !transfer_info->partial_progress ||
+        files_left == 0)
+    {
+        details_format = (source_info->num_files == 1) ? NAUTILUS_PROGRESS_DETAILS_BYTES :
+                         NAUTILUS_PROGRESS_DETAILS_FILES;
+    }
+    else
+    {
+        details_format = (source_info->num_files == 1) ? NAUTILUS_PROGRESS_DETAILS_BYTES_RATE :
+                         NAUTILUS_PROGRESS_DETAILS_FILES_RATE;
+    }
+
+    nautilus_progress_info_publish_counters (job->progress,
+                                             details_format,
+                                             transfer_info->num_files + (files_left > 0 ? 1 : 0),
+                                             transfer_info->num_files,
+                                             source_info->num_files,
+                                             transfer_info->num_bytes,
+                                             total_size,
+                                             transfer_rate);
 }
 #pragma GCC diagnostic pop
 
@@ -4387,6 +4215,10 @@ copy_move_directory (CopyMoveJob   *copy_job,
             case CREATE_DEST_DIR_SUCCESS:
             default:
             {
+                if (copy_job->journal != NULL && !copy_job->is_move)
+                {
+                    nautilus_transfer_journal_record_directory (copy_job->journal, src, *dest);
+                }
             }
             break;
         }
@@ -4667,6 +4499,9 @@ typedef struct
 {
     CopyMoveJob *job;
     goffset last_size;
+    goffset last_checkpoint;
+    GFile *src;
+    GFile *dest;
     SourceInfo *source_info;
     TransferInfo *transfer_info;
 } ProgressData;
@@ -4697,6 +4532,98 @@ copy_file_progress_callback (goffset  current_num_bytes,
                               pdata->source_info,
                               pdata->transfer_info);
     }
+
+    if (pdata->job->journal != NULL &&
+        current_num_bytes != total_num_bytes &&
+        current_num_bytes - pdata->last_checkpoint >= NAUTILUS_TRANSFER_JOURNAL_CHECKPOINT_INTERVAL)
+    {
+        nautilus_transfer_journal_record_checkpoint (pdata->job->journal,
+                                                     pdata->src, pdata->dest,
+                                                     current_num_bytes,
+                                                     pdata->job->common.cancellable);
+        pdata->last_checkpoint = current_num_bytes;
+    }
+}
+
+#define RESUME_COPY_BUFFER_SIZE (256 * 1024)
+
+/* Continues a copy of @src to @dest which a previous attempt left off at
+ * @offset, according to the transfer journal. */
+static gboolean
+resume_partial_copy (CopyMoveJob     *copy_job,
+                     GFile           *src,
+                     GFile           *dest,
+                     goffset          offset,
+                     GFileCopyFlags   flags,
+                     ProgressData    *pdata,
+                     GError         **error)
+{
+    GCancellable *cancellable = copy_job->common.cancellable;
+    g_autoptr (GFileInputStream) in = NULL;
+    g_autoptr (GFileIOStream) io = NULL;
+    g_autoptr (GFileInfo) info = NULL;
+    g_autofree guchar *buffer = NULL;
+    GOutputStream *out;
+    goffset total;
+    goffset current;
+    gssize n_read;
+
+    info = g_file_query_info (src, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                              cancellable, error);
+    if (info == NULL)
+    {
+        return FALSE;
+    }
+    total = g_file_info_get_size (info);
+
+    in = g_file_read (src, cancellable, error);
+    if (in == NULL ||
+        !g_seekable_seek (G_SEEKABLE (in), offset, G_SEEK_SET, cancellable, error))
+    {
+        return FALSE;
+    }
+
+    io = g_file_open_readwrite (dest, cancellable, error);
+    if (io == NULL ||
+        !g_seekable_truncate (G_SEEKABLE (io), offset, cancellable, error) ||
+        !g_seekable_seek (G_SEEKABLE (io), offset, G_SEEK_SET, cancellable, error))
+    {
+        return FALSE;
+    }
+    out = g_io_stream_get_output_stream (G_IO_STREAM (io));
+
+    buffer = g_malloc (RESUME_COPY_BUFFER_SIZE);
+    current = offset;
+    if (copy_job->estimator != NULL)
+    {
+        nautilus_transfer_estimator_skip (copy_job->estimator, offset, 0);
+    }
+    copy_file_progress_callback (current, total, pdata);
+
+    while ((n_read = g_input_stream_read (G_INPUT_STREAM (in), buffer,
+                                          RESUME_COPY_BUFFER_SIZE,
+                                          cancellable, error)) > 0)
+    {
+        if (!g_output_stream_write_all (out, buffer, n_read, NULL, cancellable, error))
+        {
+            return FALSE;
+        }
+
+        current += n_read;
+        copy_file_progress_callback (current, total, pdata);
+    }
+
+    if (n_read < 0 ||
+        !g_io_stream_close (G_IO_STREAM (io), cancellable, error))
+    {
+        return FALSE;
+    }
+
+    return g_file_copy_attributes (src, dest,
+                                   flags & (G_FILE_COPY_NOFOLLOW_SYMLINKS |
+                                            G_FILE_COPY_TARGET_DEFAULT_PERMS),
+                                   cancellable, error);
 }
 
 static gboolean
@@ -4882,6 +4809,8 @@ copy_move_file (CopyMoveJob   *copy_job,
     gboolean res;
     int unique_name_nr;
     gboolean handled_invalid_filename;
+    gboolean resume = FALSE;
+    goffset resume_offset = 0;
 
     job = (CommonJob *) copy_job;
 
@@ -5009,6 +4938,36 @@ copy_move_file (CopyMoveJob   *copy_job,
         goto out;
     }
 
+    if (copy_job->journal != NULL && !copy_job->is_move)
+    {
+        NautilusTransferJournalState state;
+        goffset size;
+
+        state = nautilus_transfer_journal_lookup (copy_job->journal, src, dest,
+                                                  &resume_offset, &size,
+                                                  job->cancellable);
+        if (state == NAUTILUS_TRANSFER_JOURNAL_COMPLETE)
+        {
+            /* Already copied by an earlier, interrupted attempt */
+            if (copy_job->estimator != NULL)
+            {
+                nautilus_transfer_estimator_skip (copy_job->estimator, size, 1);
+            }
+            transfer_info->num_files++;
+            transfer_info->num_bytes += size;
+            report_copy_progress (copy_job, source_info, transfer_info);
+
+            if (debuting_files)
+            {
+                g_hash_table_replace (debuting_files, g_object_ref (dest), GINT_TO_POINTER (FALSE));
+            }
+
+            g_object_unref (dest);
+            return;
+        }
+
+        resume = (state == NAUTILUS_TRANSFER_JOURNAL_PARTIAL);
+    }
 
 retry:
 
@@ -5025,6 +4984,9 @@ retry:
 
     pdata.job = copy_job;
     pdata.last_size = 0;
+    pdata.last_checkpoint = resume ? resume_offset : 0;
+    pdata.src = src;
+    pdata.dest = dest;
     pdata.source_info = source_info;
     pdata.transfer_info = transfer_info;
 
@@ -5037,6 +4999,19 @@ retry:
                            &pdata,
                            &error);
     }
+    else if (resume)
+    {
+        /* Only try once, a retry after an error starts over */
+        resume = FALSE;
+        res = resume_partial_copy (copy_job, src, dest, resume_offset,
+                                   flags, &pdata, &error);
+        if (!res && IS_IO_ERROR (error, NOT_SUPPORTED))
+        {
+            g_clear_error (&error);
+            overwrite = TRUE;
+            goto retry;
+        }
+    }
     else
     {
         res = g_file_copy (src, dest,
@@ -5065,6 +5040,12 @@ retry:
 
     if (res)
     {
+        if (copy_job->journal != NULL && !copy_job->is_move)
+        {
+            nautilus_transfer_journal_record_complete (copy_job->journal, src, dest,
+                                                       job->cancellable);
+        }
+
         transfer_info->num_files++;
         report_copy_progress (copy_job, source_info, transfer_info);
 
@@ -5093,6 +5074,16 @@ retry:
         return;
     }
 
+    /* Checkpoints are only trusted while the destination is exactly as they
+     * recorded it, so record where the interrupted copy stopped. The job
+     * cancellable may be what interrupted it. */
+    if (copy_job->journal != NULL && !copy_job->is_move &&
+        pdata.last_size >= NAUTILUS_TRANSFER_JOURNAL_CHECKPOINT_INTERVAL)
+    {
+        nautilus_transfer_journal_record_checkpoint (copy_job->journal, src, dest,
+                                                     pdata.last_size, NULL);
+    }
+
     /* On smb shares INVALID_ARGUMENT is typically returned instead of INVALID_FILENAME
      * (i.e. FAT_FORBIDDEN_CHARACTER) except with '\' where NOT_DIRECTORY is returned
      */
@@ -5155,6 +5146,14 @@ retry:
         if (source_is_directory && destination_is_directory)
         {
             is_merge = TRUE;
+
+            /* We created it ourselves in an earlier, interrupted attempt */
+            if (copy_job->journal != NULL &&
+                nautilus_transfer_journal_has_directory (copy_job->journal, src, dest))
+            {
+                overwrite = TRUE;
+                goto retry;
+            }
         }
         else if (!source_is_directory && destination_is_directory)
         {
@@ -5494,7 +5493,20 @@ copy_task_done (GObject      *source_object,
     g_hash_table_unref (job->debuting_files);
     g_free (job->target_name);
 
+    if (job->journal != NULL)
+    {
+        /* Keep the journal around only if there is something left to resume */
+        if (!job_aborted ((CommonJob *) job))
+        {
+            nautilus_transfer_journal_discard (job->journal);
+        }
+        g_clear_pointer (&job->journal, nautilus_transfer_journal_free);
+    }
+
+    g_clear_pointer (&job->estimator, nautilus_transfer_estimator_free);
     g_clear_object (&job->fake_display_source);
+    source_info_clear (&job->source_info);
+    g_free (job->dest_fs_id);
 
     finalize_common ((CommonJob *) job);
 
@@ -5525,16 +5537,13 @@ copy_job_setup (GList                          *files,
 }
 
 static void
-nautilus_file_operations_copy (GTask        *task,
-                               gpointer      source_object,
-                               gpointer      task_data,
-                               GCancellable *cancellable)
+copy_scan_thread_func (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancellable)
 {
     CopyMoveJob *job;
     CommonJob *common;
-    g_auto (SourceInfo) source_info = SOURCE_INFO_INIT;
-    TransferInfo transfer_info;
-    g_autofree char *dest_fs_id = NULL;
     GFile *dest;
 
     job = task_data;
@@ -5564,7 +5573,7 @@ nautilus_file_operations_copy (GTask        *task,
     nautilus_progress_info_start (job->common.progress);
 
     scan_sources (job->files,
-                  &source_info,
+                  &job->source_info,
                   common,
                   OP_KIND_COPY);
     if (job_aborted (common))
@@ -5586,20 +5595,132 @@ nautilus_file_operations_copy (GTask        *task,
 
     verify_destination (&job->common,
                         dest,
-                        &dest_fs_id,
-                        &source_info);
+                        &job->dest_fs_id,
+                        &job->source_info);
     g_object_unref (dest);
-    if (job_aborted (common))
+}
+
+static void
+copy_transfer_thread_func (GTask        *task,
+                           gpointer      source_object,
+                           gpointer      task_data,
+                           GCancellable *cancellable)
+{
+    CopyMoveJob *job;
+    TransferInfo transfer_info;
+
+    job = task_data;
+
+    /* Duplicates get unique names, so there is nothing to resume */
+    if (job->destination != NULL)
     {
-        return;
+        job->journal = nautilus_transfer_journal_open (job->files, job->destination);
     }
 
+    job->estimator = nautilus_transfer_estimator_new (job->dest_fs_id);
+
     g_timer_start (job->common.time);
 
     memset (&transfer_info, 0, sizeof (transfer_info));
     copy_files (job,
-                dest_fs_id,
-                &source_info, &transfer_info);
+                job->dest_fs_id,
+                &job->source_info, &transfer_info);
+
+    nautilus_transfer_estimator_save_history (job->estimator);
+}
+
+static void
+nautilus_file_operations_copy (GTask        *task,
+                               gpointer      source_object,
+                               gpointer      task_data,
+                               GCancellable *cancellable)
+{
+    CopyMoveJob *job = task_data;
+
+    /* Synchronous copies are not queued behind other jobs */
+    copy_scan_thread_func (task, source_object, task_data, cancellable);
+    if (!job_aborted (&job->common))
+    {
+        copy_transfer_thread_func (task, source_object, task_data, cancellable);
+    }
+}
+
+static void
+copy_move_device_granted (gpointer user_data)
+{
+    CopyMoveJob *job = user_data;
+    g_autoptr (GTask) task = NULL;
+
+    if (job_aborted (&job->common))
+    {
+        /* Cancelled while waiting for the device */
+        if (job->is_move)
+        {
+            move_task_done (NULL, NULL, job);
+        }
+        else
+        {
+            copy_task_done (NULL, NULL, job);
+        }
+        return;
+    }
+
+    if (job->is_move)
+    {
+        task = g_task_new (NULL, job->common.cancellable, move_task_done, job);
+        g_task_set_task_data (task, job, NULL);
+        g_task_run_in_thread (task, move_transfer_thread_func);
+    }
+    else
+    {
+        task = g_task_new (NULL, job->common.cancellable, copy_task_done, job);
+        g_task_set_task_data (task, job, NULL);
+        g_task_run_in_thread (task, copy_transfer_thread_func);
+    }
+}
+
+static void
+copy_move_scan_done (GObject      *source_object,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+    CopyMoveJob *job = user_data;
+    CommonJob *common = &job->common;
+
+    /* Moves within the same filesystem are already done at this point */
+    if (job_aborted (common) || (job->is_move && job->fallbacks == NULL))
+    {
+        if (job->is_move)
+        {
+            move_task_done (source_object, res, job);
+        }
+        else
+        {
+            copy_task_done (source_object, res, job);
+        }
+        return;
+    }
+
+    /* Wait for our turn if other jobs are already writing to the same
+     * device. The transfer thread is only started once the slot is ours, so
+     * that waiting jobs don't take up a worker thread. */
+    nautilus_progress_info_manager_queue_for_device (common->progress_manager,
+                                                     common->progress,
+                                                     job->dest_fs_id,
+                                                     job->source_info.num_bytes,
+                                                     common->cancellable,
+                                                     copy_move_device_granted,
+                                                     job);
+}
+
+static void
+start_copy_move_job (CopyMoveJob *job)
+{
+    g_autoptr (GTask) task = NULL;
+
+    task = g_task_new (NULL, job->common.cancellable, copy_move_scan_done, job);
+    g_task_set_task_data (task, job, NULL);
+    g_task_run_in_thread (task, job->is_move ? move_scan_thread_func : copy_scan_thread_func);
 }
 
 void
@@ -5634,7 +5755,6 @@ nautilus_file_operations_copy_async (GList                          *files,
                                      NautilusCopyCallback            done_callback,
                                      gpointer                        done_callback_data)
 {
-    GTask *task;
     CopyMoveJob *job;
 
     job = copy_job_setup (files,
@@ -5644,10 +5764,7 @@ nautilus_file_operations_copy_async (GList                          *files,
                           done_callback,
                           done_callback_data);
 
-    task = g_task_new (NULL, job->common.cancellable, copy_task_done, job);
-    g_task_set_task_data (task, job, NULL);
-    g_task_run_in_thread (task, nautilus_file_operations_copy);
-    g_object_unref (task);
+    start_copy_move_job (job);
 }
 
 static void
@@ -6041,6 +6158,85 @@ out:
     g_object_unref (dest);
 }
 
+/* Fast path for the common case of moving native files within one
+ * filesystem: rename everything in one pass, and report all the changes in
+ * one batch at the end. g_file_move() is used rather than a bare rename so
+ * that the gvfs metadata of the files moves along. Anything out of the
+ * ordinary (conflicts, files on other filesystems, moving a folder into
+ * itself, errors, ...) is returned to go through move_file_prepare(), which
+ * knows how to ask the user about it. */
+static GList *
+move_files_rename_native (CopyMoveJob *job)
+{
+    CommonJob *common = &job->common;
+    g_autolist (GFile) moved_from = NULL;
+    g_autolist (GFile) moved_to = NULL;
+    GList *remaining = NULL;
+
+    if (!g_file_is_native (job->destination))
+    {
+        return g_list_copy (job->files);
+    }
+
+    for (GList *l = job->files; l != NULL && !job_aborted (common); l = l->next)
+    {
+        GFile *src = l->data;
+        g_autoptr (GFile) parent = NULL;
+        g_autoptr (GFile) dest = NULL;
+        g_autofree char *basename = NULL;
+
+        parent = g_file_get_parent (src);
+        if (!g_file_is_native (src) ||
+            parent == NULL ||
+            g_file_equal (parent, job->destination) ||
+            g_file_equal (src, job->destination) ||
+            g_file_has_prefix (job->destination, src))
+        {
+            remaining = g_list_prepend (remaining, src);
+            continue;
+        }
+
+        /* Without G_FILE_COPY_OVERWRITE, an existing destination fails the
+         * move, and without a fallback, so does another filesystem */
+        basename = g_file_get_basename (src);
+        dest = g_file_get_child (job->destination, basename);
+        if (!g_file_move (src, dest,
+                          G_FILE_COPY_NOFOLLOW_SYMLINKS | G_FILE_COPY_NO_FALLBACK_FOR_MOVE,
+                          common->cancellable,
+                          NULL, NULL, NULL))
+        {
+            remaining = g_list_prepend (remaining, src);
+            continue;
+        }
+
+        moved_from = g_list_prepend (moved_from, g_object_ref (src));
+        moved_to = g_list_prepend (moved_to, g_steal_pointer (&dest));
+    }
+
+    moved_from = g_list_reverse (moved_from);
+    moved_to = g_list_reverse (moved_to);
+
+    for (GList *from = moved_from, *to = moved_to;
+         from != NULL;
+         from = from->next, to = to->next)
+    {
+        if (job->debuting_files != NULL)
+        {
+            g_hash_table_replace (job->debuting_files, g_object_ref (to->data), GINT_TO_POINTER (TRUE));
+        }
+
+        if (common->undo_info != NULL)
+        {
+            nautilus_file_undo_info_ext_add_origin_target_pair (NAUTILUS_FILE_UNDO_INFO_EXT (common->undo_info),
+                                                                from->data, to->data);
+        }
+    }
+
+    nautilus_file_changes_queue_files_moved (moved_from, moved_to);
+
+    return g_list_reverse (remaining);
+}
+
 static void
 move_files_prepare (CopyMoveJob  *job,
                     const char   *dest_fs_id,
@@ -6048,6 +6244,7 @@ move_files_prepare (CopyMoveJob  *job,
                     GList       **fallbacks)
 {
     CommonJob *common;
+    g_autoptr (GList) remaining = NULL;
     GList *l;
     GFile *src;
     gboolean same_fs;
@@ -6060,8 +6257,12 @@ move_files_prepare (CopyMoveJob  *job,
 
     report_preparing_move_progress (job, total, left);
 
+    remaining = move_files_rename_native (job);
+    left = g_list_length (remaining);
+    report_preparing_move_progress (job, total, left);
+
     i = 0;
-    for (l = job->files;
+    for (l = remaining;
          l != NULL && !job_aborted (common);
          l = l->next)
     {
@@ -6155,6 +6356,11 @@ move_task_done (GObject      *source_object,
     g_list_free_full (job->files, g_object_unref);
     g_object_unref (job->destination);
     g_hash_table_unref (job->debuting_files);
+    g_clear_pointer (&job->estimator, nautilus_transfer_estimator_free);
+    source_info_clear (&job->source_info);
+    g_free (job->dest_fs_id);
+    g_free (job->dest_fs_type);
+    g_list_free_full (job->fallbacks, g_free);
 
     finalize_common ((CommonJob *) job);
 
@@ -6212,7 +6418,6 @@ nautilus_file_operations_move_async (GList                          *files,
                                      NautilusCopyCallback            done_callback,
                                      gpointer                        done_callback_data)
 {
-    GTask *task;
     CopyMoveJob *job;
 
     job = move_job_setup (files,
@@ -6222,25 +6427,17 @@ nautilus_file_operations_move_async (GList                          *files,
                           done_callback,
                           done_callback_data);
 
-    task = g_task_new (NULL, job->common.cancellable, move_task_done, job);
-    g_task_set_task_data (task, job, NULL);
-    g_task_run_in_thread (task, nautilus_file_operations_move);
-    g_object_unref (task);
+    start_copy_move_job (job);
 }
 
 static void
-nautilus_file_operations_move (GTask        *task,
-                               gpointer      source_object,
-                               gpointer      task_data,
-                               GCancellable *cancellable)
+move_scan_thread_func (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancellable)
 {
     CopyMoveJob *job;
     CommonJob *common;
-    GList *fallbacks;
-    g_auto (SourceInfo) source_info = SOURCE_INFO_INIT;
-    TransferInfo transfer_info;
-    g_autofree char *dest_fs_id = NULL;
-    g_autofree char *dest_fs_type = NULL;
     GList *fallback_files;
 
     job = task_data;
@@ -6280,35 +6477,33 @@ nautilus_file_operations_move (GTask        *task,
 
     nautilus_progress_info_start (job->common.progress);
 
-    fallbacks = NULL;
-
     verify_destination (&job->common,
                         job->destination,
-                        &dest_fs_id,
+                        &job->dest_fs_id,
                         NULL);
     if (job_aborted (common))
     {
-        goto aborted;
+        return;
     }
 
     /* This moves all files that we can do without copy + delete */
-    move_files_prepare (job, dest_fs_id, &dest_fs_type, &fallbacks);
+    move_files_prepare (job, job->dest_fs_id, &job->dest_fs_type, &job->fallbacks);
     if (job_aborted (common))
     {
-        goto aborted;
+        return;
     }
 
-    if (fallbacks == NULL)
+    if (job->fallbacks == NULL)
     {
+        TransferInfo transfer_info;
         gint total;
 
         total = g_list_length (job->files);
 
-        memset (&source_info, 0, sizeof (source_info));
-        source_info.num_files = total;
+        job->source_info.num_files = total;
         memset (&transfer_info, 0, sizeof (transfer_info));
         transfer_info.num_files = total;
-        report_copy_progress (job, &source_info, &transfer_info);
+        report_copy_progress (job, &job->source_info, &transfer_info);
 
         return;
     }
@@ -6316,9 +6511,9 @@ nautilus_file_operations_move (GTask        *task,
     /* The rest we need to do deep copy + delete behind on,
      *  so scan for size */
 
-    fallback_files = get_files_from_fallbacks (fallbacks);
+    fallback_files = get_files_from_fallbacks (job->fallbacks);
     scan_sources (fallback_files,
-                  &source_info,
+                  &job->source_info,
                   common,
                   OP_KIND_MOVE);
 
@@ -6326,26 +6521,52 @@ nautilus_file_operations_move (GTask        *task,
 
     if (job_aborted (common))
     {
-        goto aborted;
+        return;
     }
 
     verify_destination (&job->common,
                         job->destination,
                         NULL,
-                        &source_info);
-    if (job_aborted (common))
-    {
-        goto aborted;
-    }
+                        &job->source_info);
+}
+
+static void
+move_transfer_thread_func (GTask        *task,
+                           gpointer      source_object,
+                           gpointer      task_data,
+                           GCancellable *cancellable)
+{
+    CopyMoveJob *job;
+    TransferInfo transfer_info;
+
+    job = task_data;
+
+    /* Only the copy + delete fallbacks actually stream data to the device */
+    job->estimator = nautilus_transfer_estimator_new (job->dest_fs_id);
 
     memset (&transfer_info, 0, sizeof (transfer_info));
     move_files (job,
-                fallbacks,
-                dest_fs_id, &dest_fs_type,
-                &source_info, &transfer_info);
+                job->fallbacks,
+                job->dest_fs_id, &job->dest_fs_type,
+                &job->source_info, &transfer_info);
 
-aborted:
-    g_list_free_full (fallbacks, g_free);
+    nautilus_transfer_estimator_save_history (job->estimator);
+}
+
+static void
+nautilus_file_operations_move (GTask        *task,
+                               gpointer      source_object,
+                               gpointer      task_data,
+                               GCancellable *cancellable)
+{
+    CopyMoveJob *job = task_data;
+
+    /* Synchronous moves are not queued behind other jobs */
+    move_scan_thread_func (task, source_object, task_data, cancellable);
+    if (!job_aborted (&job->common) && job->fallbacks != NULL)
+    {
+        move_transfer_thread_func (task, source_object, task_data, cancellable);
+    }
 }
 
 static void
@@ -6681,7 +6902,6 @@ nautilus_file_operations_duplicate (GList                          *files,
                                     NautilusCopyCallback            done_callback,
                                     gpointer                        done_callback_data)
 {
-    g_autoptr (GTask) task = NULL;
     CopyMoveJob *job;
     g_autoptr (GFile) parent = NULL;
 
@@ -6709,9 +6929,7 @@ nautilus_file_operations_duplicate (GList                          *files,
                                              src_dir, src_dir);
     }
 
-    task = g_task_new (NULL, job->common.cancellable, copy_task_done, job);
-    g_task_set_task_data (task, job, NULL);
-    g_task_run_in_thread (task, nautilus_file_operations_copy);
+    start_copy_move_job (job);
 }
 
 static void
@@ -8003,7 +8221,7 @@ extract_job_on_progress (AutoarExtractor *extractor,
         g_autofree gchar *formatted_time = NULL;
         g_autofree gchar *formatted_size_transfer_rate = NULL;
 
-        formatted_time = get_formatted_time (remaining_time);
+        formatted_time = nautilus_progress_info_format_time (remaining_time);
         formatted_size_transfer_rate = g_format_size ((goffset) transfer_rate);
         /* To translators: %s will expand to a size like "2 bytes" or
          * "3 MB", %s to a time duration like "2 minutes". So the whole
@@ -8015,7 +8233,7 @@ extract_job_on_progress (AutoarExtractor *extractor,
          */
         details = g_strdup_printf (ngettext ("%s / %s \xE2\x80\x94 %s left (%s/s)",
                                              "%s / %s \xE2\x80\x94 %s left (%s/s)",
-                                             seconds_count_format_time_units (remaining_time)),
+                                             nautilus_progress_info_count_time_units (remaining_time)),
                                    formatted_size_job_completed_size,
                                    formatted_size_total_compressed_size,
                                    formatted_time,
@@ -8502,7 +8720,7 @@ compress_job_on_progress (AutoarCompressor *compressor,
                 g_autofree gchar *formatted_time = NULL;
                 g_autofree gchar *formatted_size_transfer_rate = NULL;
 
-                formatted_time = get_formatted_time (remaining_time);
+                formatted_time = nautilus_progress_info_format_time (remaining_time);
                 formatted_size_transfer_rate = g_format_size ((goffset) transfer_rate);
                 /* To translators: %s will expand to a size like "2 bytes" or "3 MB", %s to a time duration like
                  * "2 minutes". So the whole thing will be something like "2 kB / 4 MB -- 2 hours left (4 kB/s)"
@@ -8511,7 +8729,7 @@ compress_job_on_progress (AutoarCompressor *compressor,
                  */
                 details = g_strdup_printf (ngettext ("%s / %s \xE2\x80\x94 %s left (%s/s)",
                                                      "%s / %s \xE2\x80\x94 %s left (%s/s)",
-                                                     seconds_count_format_time_units (remaining_time)),
+                                                     nautilus_progress_info_count_time_units (remaining_time)),
                                            formatted_size_completed_size,
                                            formatted_size_total_size,
                                            formatted_time,
@@ -8532,7 +8750,7 @@ compress_job_on_progress (AutoarCompressor *compressor,
                 g_autofree gchar *formatted_time = NULL;
                 g_autofree gchar *formatted_size = NULL;
 
-                formatted_time = get_formatted_time (remaining_time);
+                formatted_time = nautilus_progress_info_format_time (remaining_time);
                 formatted_size = g_format_size ((goffset) transfer_rate);
                 /* To translators: %s will expand to a time duration like "2 minutes".
                  * So the whole thing will be something like "1 / 5 -- 2 hours left (4 kB/s)"
@@ -8541,7 +8759,7 @@ compress_job_on_progress (AutoarCompressor *compressor,
                  */
                 details = g_strdup_printf (ngettext ("%'d / %'d \xE2\x80\x94 %s left (%s/s)",
                                                      "%'d / %'d \xE2\x80\x94 %s left (%s/s)",
-                                                     seconds_count_format_time_units (remaining_time)),
+                                                     nautilus_progress_info_count_time_units (remaining_time)),
                                            completed_files + 1, compress_job->total_files,
                                            formatted_time,
                                            formatted_size);
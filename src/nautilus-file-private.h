@@ -26,8 +26,18 @@
 #include "nautilus-monitor.h"
 #include "nautilus-file-undo-operations.h"
 
+/* What listing a directory asks for: enough to show and sort the files */
+#define NAUTILUS_FILE_BASIC_ATTRIBUTES					\
+	"standard::*,access::*,mountable::*,time::*,unix::*,id::filesystem,trash::orig-path,trash::deletion-date,recent::*,preview::icon,metadata::*"
+
+/* Slower to get: user and group names are looked up and thumbnails are looked
+ * up on disk. Files listed with the basic attributes get these later, see
+ * NAUTILUS_FILE_ATTRIBUTE_EXTRA_INFO */
+#define NAUTILUS_FILE_EXTRA_ATTRIBUTES					\
+	"owner::*,selinux::*,thumbnail::*"
+
 #define NAUTILUS_FILE_DEFAULT_ATTRIBUTES				\
-	"standard::*,access::*,mountable::*,time::*,unix::*,owner::*,selinux::*,thumbnail::*,id::filesystem,trash::orig-path,trash::deletion-date,metadata::*,recent::*,preview::icon"
+	NAUTILUS_FILE_BASIC_ATTRIBUTES "," NAUTILUS_FILE_EXTRA_ATTRIBUTES
 
 /* These are in the typical sort order. Known things come first, then
  * things where we can't know, finally things where we don't yet know.
@@ -38,6 +48,39 @@ typedef enum {
 	UNKNOWN
 } Knowledge;
 
+/* Fields which are only set for a few files. They live outside of
+ * NautilusFilePrivate, so that the many files which don't need them
+ * in a large directory don't pay for them either.
+ */
+typedef struct {
+	char *symlink_name;
+	char *trash_orig_path;
+	gchar *fts_snippet;
+
+	/* File operations in progress */
+	GList *operations_in_progress;
+
+	/* Emblems provided by extensions */
+	GList *extension_emblems;
+	GList *pending_extension_emblems;
+
+	/* Attributes provided by extensions */
+	GHashTable *extension_attributes;
+	GHashTable *pending_extension_attributes;
+
+	guint deep_directory_count;
+	guint deep_file_count;
+	guint deep_unreadable_count;
+	goffset deep_size;
+
+	guint64 free_space; /* (guint)-1 for unknown */
+	time_t free_space_read; /* The time free_space was updated, or 0 for never */
+
+	/* Metadata set but not written yet, and being written */
+	GFileInfo *pending_metadata;
+	GFileInfo *writing_metadata;
+} NautilusFileColdData;
+
 struct NautilusFilePrivate
 {
 	NautilusDirectory *directory;
@@ -49,7 +92,7 @@ struct NautilusFilePrivate
 
 	GRefString *display_name;
 	char *display_name_collation_key;
-	char *directory_name_collation_key;
+	GRefString *directory_name_collation_key; /* interned, shared by the files of a directory */
 	GRefString *edit_name;
 
 	goffset size; /* -1 is unknown */
@@ -57,9 +100,7 @@ struct NautilusFilePrivate
 	int sort_order;
 	
 	guint32 permissions;
-	gboolean has_uid;
 	uid_t uid;
-	gboolean has_gid;
 	gid_t gid;
 
 	GRefString *owner;
@@ -70,8 +111,6 @@ struct NautilusFilePrivate
 	time_t mtime; /* 0 is unknown */
 	time_t btime; /* 0 is unknown */
 	
-	char *symlink_name;
-	
 	GRefString *mime_type;
 	
 	char *selinux_context;
@@ -80,19 +119,14 @@ struct NautilusFilePrivate
 	
 	guint directory_count;
 
-	guint deep_directory_count;
-	guint deep_file_count;
-	guint deep_unreadable_count;
-	goffset deep_size;
-
 	GIcon *icon;
 	
 	char *thumbnail_path;
 	GdkPixbuf *thumbnail;
 	time_t thumbnail_mtime;
+	GList *thumbnail_link; /* in the list of loaded thumbnails */
 
 	/* Info you might get from a link (.desktop, .directory or nautilus link) */
-	GIcon *custom_icon;
 	char *activation_uri;
 
 	/* used during DND, for checking whether source and destination are on
@@ -100,27 +134,16 @@ struct NautilusFilePrivate
 	 */
 	GRefString *filesystem_id;
 
-	char *trash_orig_path;
-
-	/* The following is for file operations in progress. Since
-	 * there are normally only a few of these, we can move them to
-	 * a separate hash table or something if required to keep the
-	 * file objects small.
-	 */
-	GList *operations_in_progress;
-
 	/* NautilusInfoProviders that need to be run for this file */
 	GList *pending_info_providers;
 
-	/* Emblems provided by extensions */
-	GList *extension_emblems;
-	GList *pending_extension_emblems;
+	GHashTable *metadata;
 
-	/* Attributes provided by extensions */
-	GHashTable *extension_attributes;
-	GHashTable *pending_extension_attributes;
+	/* Interned, see nautilus_file_get_emblems_key() */
+	const char *emblems_key;
 
-	GHashTable *metadata;
+	/* Fields few files use, see nautilus_file_get_cold_data() */
+	NautilusFileColdData *cold;
 
 	/* Mount for mountpoint or the references GMount for a "mountable" */
 	GMount *mount;
@@ -138,9 +161,12 @@ struct NautilusFilePrivate
 	 * list so the file knows not to do redundant I/O.
 	 */
 	guint loading_directory             : 1;
+	guint has_uid                       : 1;
+	guint has_gid                       : 1;
 	guint got_file_info                 : 1;
 	guint get_info_failed               : 1;
 	guint file_info_is_up_to_date       : 1;
+	guint extra_info_is_up_to_date      : 1;
 	
 	guint got_directory_count           : 1;
 	guint directory_count_failed        : 1;
@@ -183,6 +209,12 @@ struct NautilusFilePrivate
 	guint is_media_check_automatic      : 1;
 	guint has_preview_icon              : 1;
 
+	/* Cached from the tag manager, which invalidates it when it changes */
+	guint is_starred                    : 1;
+	guint starred_is_up_to_date         : 1;
+
+	guint emblems_key_is_up_to_date     : 1;
+
 	guint filesystem_readonly           : 1;
 	guint filesystem_use_preview        : 2; /* GFilesystemPreviewType */
 	guint filesystem_info_is_up_to_date : 1;
@@ -192,10 +224,6 @@ struct NautilusFilePrivate
 	time_t recency; /* 0 is unknown */
 
 	gdouble search_relevance;
-	gchar *fts_snippet;
-
-	guint64 free_space; /* (guint)-1 for unknown */
-	time_t free_space_read; /* The time free_space was updated, or 0 for never */
 };
 
 typedef struct {
@@ -215,6 +243,8 @@ typedef struct {
 
 NautilusFile *nautilus_file_new_from_info                  (NautilusDirectory      *directory,
 							    GFileInfo              *info);
+NautilusFile *nautilus_file_new_from_basic_info            (NautilusDirectory      *directory,
+							    GFileInfo              *info);
 NautilusFile *nautilus_file_new_from_filename              (NautilusDirectory *directory,
                                                             const char        *filename,
                                                             gboolean           self_owned);
@@ -233,10 +263,21 @@ void          nautilus_file_clear_info                     (NautilusFile
  * new state.  */
 gboolean      nautilus_file_update_info                    (NautilusFile           *file,
 							    GFileInfo              *info);
+/* Same, for an info which only has NAUTILUS_FILE_BASIC_ATTRIBUTES. The
+ * extra info is then marked as not up to date. */
+gboolean      nautilus_file_update_basic_info              (NautilusFile           *file,
+							    GFileInfo              *info);
+void          nautilus_file_invalidate_starred             (NautilusFile           *file);
+NautilusFileColdData *
+              nautilus_file_get_cold_data                  (NautilusFile           *file);
+gboolean      nautilus_file_update_extra_info              (NautilusFile           *file,
+							    GFileInfo              *info);
 gboolean      nautilus_file_update_name                    (NautilusFile           *file,
 							    const char             *name);
 gboolean      nautilus_file_update_metadata_from_info      (NautilusFile           *file,
 							    GFileInfo              *info);
+gboolean      nautilus_file_merge_metadata_from_info       (NautilusFile           *file,
+							    GFileInfo              *info);
 
 gboolean      nautilus_file_update_name_and_directory      (NautilusFile           *file,
 							    const char             *name,
@@ -60,6 +60,7 @@
 #include "nautilus-scheme.h"
 #include "nautilus-signaller.h"
 #include "nautilus-tag-manager.h"
+#include "nautilus-thumbnail-cache.h"
 #include "nautilus-thumbnails.h"
 #include "nautilus-ui-utilities.h"
 #include "nautilus-vfs-file.h"
@@ -121,6 +122,17 @@ static guint signals[LAST_SIGNAL];
 static GHashTable *symbolic_links;
 
 static guint64 cached_thumbnail_limit;
+
+/* Loaded thumbnails of files which are no longer shown are dropped, least
+ * recently used first, once they take more memory than this. They are loaded
+ * again through NAUTILUS_FILE_ATTRIBUTE_THUMBNAIL when needed. The paintables
+ * cached for a thumbnail share its pixels, so they are dropped along with it,
+ * and this covers them as well. */
+#define THUMBNAIL_MEMORY_BUDGET (256 * 1024 * 1024)
+
+/* Most recently used first, unowned */
+static GQueue loaded_thumbnails = G_QUEUE_INIT;
+static gsize loaded_thumbnails_size;
 static NautilusSpeedTradeoffValue show_file_thumbs;
 
 static NautilusSpeedTradeoffValue show_directory_item_count;
@@ -166,6 +178,10 @@ static char *nautilus_file_get_owner_as_string (NautilusFile *file,
 static char *nautilus_file_get_type_as_string (NautilusFile *file);
 static const char *nautilus_file_get_type_as_string_no_extra_text (NautilusFile *file);
 static char *nautilus_file_get_detailed_type_as_string (NautilusFile *file);
+static gboolean update_info_internal (NautilusFile *file,
+                                      GFileInfo    *info,
+                                      gboolean      update_name,
+                                      gboolean      is_basic);
 static gboolean update_info_and_name (NautilusFile *file,
                                       GFileInfo    *info);
 static const char *nautilus_file_peek_display_name (NautilusFile *file);
@@ -195,8 +211,52 @@ nautilus_file_init (NautilusFile *file)
 
     nautilus_file_clear_info (file);
     nautilus_file_invalidate_extension_info_internal (file);
+}
+
+/**
+ * nautilus_file_get_cold_data:
+ * @file: a #NautilusFile
+ *
+ * Returns: (transfer none): the fields of @file which are only set for a
+ *     few files, allocated on first use. Readers check whether
+ *     `file->details->cold` is %NULL instead, to not allocate it for nothing.
+ */
+NautilusFileColdData *
+nautilus_file_get_cold_data (NautilusFile *file)
+{
+    if (file->details->cold == NULL)
+    {
+        file->details->cold = g_new0 (NautilusFileColdData, 1);
+        file->details->cold->free_space = -1;
+    }
+
+    return file->details->cold;
+}
+
+static void
+cold_data_free (NautilusFileColdData *cold)
+{
+    g_assert (cold->operations_in_progress == NULL);
 
-    file->details->free_space = -1;
+    g_free (cold->symlink_name);
+    g_free (cold->trash_orig_path);
+    g_free (cold->fts_snippet);
+
+    g_list_free_full (cold->pending_extension_emblems, g_free);
+    g_list_free_full (cold->extension_emblems, g_free);
+    g_clear_pointer (&cold->pending_extension_attributes, g_hash_table_destroy);
+    g_clear_pointer (&cold->extension_attributes, g_hash_table_destroy);
+
+    g_clear_object (&cold->pending_metadata);
+    g_clear_object (&cold->writing_metadata);
+
+    g_free (cold);
+}
+
+static const char *
+get_symlink_name (NautilusFile *file)
+{
+    return file->details->cold != NULL ? file->details->cold->symlink_name : NULL;
 }
 
 static GObject *
@@ -359,80 +419,102 @@ _g_strv_equal (GStrv a,
     return TRUE;
 }
 
-static gboolean
-metadata_hash_equal (GHashTable *hash1,
-                     GHashTable *hash2)
+/* The emblems only depend on the info, the metadata, the mount and the
+ * extension emblems of the file, so their key is kept until one of these
+ * changes. */
+static void
+invalidate_emblems_key (NautilusFile *file)
 {
-    GHashTableIter iter;
-    gpointer key1, value1, value2;
-    guint id;
+    file->details->emblems_key_is_up_to_date = FALSE;
+}
 
-    if (hash1 == NULL && hash2 == NULL)
+static void
+clear_metadata (NautilusFile *file)
+{
+    if (file->details->metadata)
     {
-        return TRUE;
+        metadata_hash_free (file->details->metadata);
+        file->details->metadata = NULL;
     }
+}
+
+static void
+metadata_hash_remove (GHashTable *hash,
+                      guint       id)
+{
+    gpointer key, value;
 
-    if (hash1 == NULL || hash2 == NULL)
+    if (g_hash_table_steal_extended (hash, GUINT_TO_POINTER (id), &key, &value))
     {
-        return FALSE;
+        foreach_metadata_free (key, value, NULL);
     }
+}
 
-    if (g_hash_table_size (hash1) !=
-        g_hash_table_size (hash2))
+/* Whether @metadata holds the same values as the metadata namespace of @info,
+ * checked without copying them */
+static gboolean
+metadata_hash_matches_info (GHashTable  *metadata,
+                            GFileInfo   *info,
+                            char       **attrs)
+{
+    guint n_matched = 0;
+
+    if (metadata == NULL)
     {
         return FALSE;
     }
 
-    g_hash_table_iter_init (&iter, hash1);
-    while (g_hash_table_iter_next (&iter, &key1, &value1))
+    for (int i = 0; attrs[i] != NULL; i++)
     {
-        value2 = g_hash_table_lookup (hash2, key1);
-        if (value2 == NULL)
+        guint id = nautilus_metadata_get_id (attrs[i] + strlen ("metadata::"));
+        GFileAttributeType type;
+        gpointer value;
+        gpointer cached_value;
+
+        if (id == 0 ||
+            !g_file_info_get_attribute_data (info, attrs[i], &type, &value, NULL))
         {
-            return FALSE;
+            continue;
         }
-        id = GPOINTER_TO_UINT (key1);
-        if (id & METADATA_ID_IS_LIST_MASK)
+
+        if (type == G_FILE_ATTRIBUTE_TYPE_STRING)
         {
-            if (!_g_strv_equal ((char **) value1, (char **) value2))
+            cached_value = g_hash_table_lookup (metadata, GUINT_TO_POINTER (id));
+            if (cached_value == NULL || strcmp (cached_value, value) != 0)
             {
                 return FALSE;
             }
         }
-        else
+        else if (type == G_FILE_ATTRIBUTE_TYPE_STRINGV)
         {
-            if (strcmp ((char *) value1, (char *) value2) != 0)
+            cached_value = g_hash_table_lookup (metadata,
+                                                GUINT_TO_POINTER (id | METADATA_ID_IS_LIST_MASK));
+            if (cached_value == NULL || !_g_strv_equal (cached_value, value))
             {
                 return FALSE;
             }
         }
-    }
-
-    return TRUE;
-}
+        else
+        {
+            continue;
+        }
 
-static void
-clear_metadata (NautilusFile *file)
-{
-    if (file->details->metadata)
-    {
-        metadata_hash_free (file->details->metadata);
-        file->details->metadata = NULL;
+        n_matched++;
     }
+
+    return n_matched == g_hash_table_size (metadata);
 }
 
 static GHashTable *
-get_metadata_from_info (GFileInfo *info)
+get_metadata_from_info (GFileInfo  *info,
+                        char      **attrs)
 {
     GHashTable *metadata;
-    char **attrs;
     guint id;
     int i;
     GFileAttributeType type;
     gpointer value;
 
-    attrs = g_file_info_list_attributes (info, "metadata");
-
     metadata = g_hash_table_new (NULL, NULL);
 
     for (i = 0; attrs[i] != NULL; i++)
@@ -462,8 +544,6 @@ get_metadata_from_info (GFileInfo *info)
         }
     }
 
-    g_strfreev (attrs);
-
     return metadata;
 }
 
@@ -475,19 +555,13 @@ nautilus_file_update_metadata_from_info (NautilusFile *file,
 
     if (g_file_info_has_namespace (info, "metadata"))
     {
-        GHashTable *metadata;
+        g_auto (GStrv) attrs = g_file_info_list_attributes (info, "metadata");
 
-        metadata = get_metadata_from_info (info);
-        if (!metadata_hash_equal (metadata,
-                                  file->details->metadata))
+        if (!metadata_hash_matches_info (file->details->metadata, info, attrs))
         {
             changed = TRUE;
             clear_metadata (file);
-            file->details->metadata = metadata;
-        }
-        else
-        {
-            metadata_hash_free (metadata);
+            file->details->metadata = get_metadata_from_info (info, attrs);
         }
     }
     else if (file->details->metadata)
@@ -495,6 +569,116 @@ nautilus_file_update_metadata_from_info (NautilusFile *file,
         changed = TRUE;
         clear_metadata (file);
     }
+
+    /* The info may predate the values which are still being written */
+    if (file->details->cold != NULL)
+    {
+        NautilusFileColdData *cold = file->details->cold;
+
+        if (cold->writing_metadata != NULL)
+        {
+            changed |= nautilus_file_merge_metadata_from_info (file, cold->writing_metadata);
+        }
+        if (cold->pending_metadata != NULL)
+        {
+            changed |= nautilus_file_merge_metadata_from_info (file, cold->pending_metadata);
+        }
+    }
+
+    if (changed)
+    {
+        invalidate_emblems_key (file);
+    }
+
+    return changed;
+}
+
+/**
+ * nautilus_file_merge_metadata_from_info:
+ * @file: a #NautilusFile
+ * @info: a #GFileInfo with some metadata keys, where unset keys have the
+ *     %G_FILE_ATTRIBUTE_TYPE_INVALID type
+ *
+ * Updates the metadata of @file with the keys of @info, keeping the others.
+ *
+ * Returns: whether the metadata of @file changed.
+ */
+gboolean
+nautilus_file_merge_metadata_from_info (NautilusFile *file,
+                                        GFileInfo    *info)
+{
+    g_auto (GStrv) attrs = g_file_info_list_attributes (info, "metadata");
+    gboolean changed = FALSE;
+
+    for (int i = 0; attrs[i] != NULL; i++)
+    {
+        guint id = nautilus_metadata_get_id (attrs[i] + strlen ("metadata::"));
+        guint list_id = id | METADATA_ID_IS_LIST_MASK;
+        GFileAttributeType type;
+        gpointer value;
+        gpointer cached_value;
+
+        if (id == 0 ||
+            !g_file_info_get_attribute_data (info, attrs[i], &type, &value, NULL))
+        {
+            continue;
+        }
+
+        if (file->details->metadata == NULL)
+        {
+            file->details->metadata = g_hash_table_new (NULL, NULL);
+        }
+
+        if (type == G_FILE_ATTRIBUTE_TYPE_STRING)
+        {
+            cached_value = g_hash_table_lookup (file->details->metadata, GUINT_TO_POINTER (id));
+            if (cached_value != NULL && strcmp (cached_value, value) == 0)
+            {
+                continue;
+            }
+
+            metadata_hash_remove (file->details->metadata, id);
+            metadata_hash_remove (file->details->metadata, list_id);
+            g_hash_table_insert (file->details->metadata, GUINT_TO_POINTER (id),
+                                 g_strdup (value));
+        }
+        else if (type == G_FILE_ATTRIBUTE_TYPE_STRINGV)
+        {
+            cached_value = g_hash_table_lookup (file->details->metadata, GUINT_TO_POINTER (list_id));
+            if (cached_value != NULL && _g_strv_equal (cached_value, value))
+            {
+                continue;
+            }
+
+            metadata_hash_remove (file->details->metadata, id);
+            metadata_hash_remove (file->details->metadata, list_id);
+            g_hash_table_insert (file->details->metadata, GUINT_TO_POINTER (list_id),
+                                 g_strdupv (value));
+        }
+        else if (type == G_FILE_ATTRIBUTE_TYPE_INVALID)
+        {
+            if (!g_hash_table_contains (file->details->metadata, GUINT_TO_POINTER (id)) &&
+                !g_hash_table_contains (file->details->metadata, GUINT_TO_POINTER (list_id)))
+            {
+                continue;
+            }
+
+            metadata_hash_remove (file->details->metadata, id);
+            metadata_hash_remove (file->details->metadata, list_id);
+        }
+        else
+        {
+            continue;
+        }
+
+        changed = TRUE;
+    }
+
+    if (changed)
+    {
+        invalidate_emblems_key (file);
+    }
+
     return changed;
 }
 
@@ -531,6 +715,7 @@ nautilus_file_clear_info (NautilusFile *file)
     g_free (file->details->thumbnail_path);
     file->details->thumbnail_path = NULL;
     file->details->thumbnailing_failed = FALSE;
+    file->details->extra_info_is_up_to_date = FALSE;
 
     file->details->is_symlink = FALSE;
     file->details->is_hidden = FALSE;
@@ -561,8 +746,10 @@ nautilus_file_clear_info (NautilusFile *file)
     file->details->btime = 0;
     file->details->trash_time = 0;
     file->details->recency = 0;
-    g_free (file->details->symlink_name);
-    file->details->symlink_name = NULL;
+    if (file->details->cold != NULL)
+    {
+        g_clear_pointer (&file->details->cold->symlink_name, g_free);
+    }
     g_clear_pointer (&file->details->mime_type, g_ref_string_release);
     g_free (file->details->selinux_context);
     file->details->selinux_context = NULL;
@@ -587,16 +774,19 @@ void
 nautilus_file_set_directory (NautilusFile      *file,
                              NautilusDirectory *directory)
 {
-    char *parent_uri;
+    g_autofree char *parent_uri = NULL;
+    g_autofree char *collation_key = NULL;
 
     g_clear_object (&file->details->directory);
-    g_free (file->details->directory_name_collation_key);
+    g_clear_pointer (&file->details->directory_name_collation_key, g_ref_string_release);
 
     file->details->directory = nautilus_directory_ref (directory);
+    invalidate_emblems_key (file);
+    nautilus_file_invalidate_starred (file);
 
     parent_uri = nautilus_file_get_parent_uri (file);
-    file->details->directory_name_collation_key = g_utf8_collate_key_for_filename (parent_uri, -1);
-    g_free (parent_uri);
+    collation_key = g_utf8_collate_key_for_filename (parent_uri, -1);
+    file->details->directory_name_collation_key = g_ref_string_new_intern (collation_key);
 }
 
 NautilusFile *
@@ -630,7 +820,7 @@ modify_link_hash_table (NautilusFile       *file,
     GList **list_ptr;
 
     /* Check if there is a symlink name. If none, we are OK. */
-    if (file->details->symlink_name == NULL || !nautilus_file_is_symbolic_link (file))
+    if (get_symlink_name (file) == NULL || !nautilus_file_is_symbolic_link (file))
     {
         return;
     }
@@ -710,9 +900,10 @@ remove_from_link_hash_table (NautilusFile *file)
     modify_link_hash_table (file, remove_from_link_hash_table_list);
 }
 
-NautilusFile *
-nautilus_file_new_from_info (NautilusDirectory *directory,
-                             GFileInfo         *info)
+static NautilusFile *
+new_from_info_internal (NautilusDirectory *directory,
+                        GFileInfo         *info,
+                        gboolean           is_basic)
 {
     NautilusFile *file;
 
@@ -722,7 +913,7 @@ nautilus_file_new_from_info (NautilusDirectory *directory,
     file = NAUTILUS_FILE (g_object_new (NAUTILUS_TYPE_VFS_FILE, NULL));
     nautilus_file_set_directory (file, directory);
 
-    update_info_and_name (file, info);
+    update_info_internal (file, info, TRUE, is_basic);
 
 #ifdef NAUTILUS_FILE_DEBUG_REF
     DEBUG_REF_PRINTF ("%10p ref'd", file);
@@ -731,6 +922,22 @@ nautilus_file_new_from_info (NautilusDirectory *directory,
     return file;
 }
 
+NautilusFile *
+nautilus_file_new_from_info (NautilusDirectory *directory,
+                             GFileInfo         *info)
+{
+    return new_from_info_internal (directory, info, FALSE);
+}
+
+/* Like nautilus_file_new_from_info(), for an info which only has
+ * NAUTILUS_FILE_BASIC_ATTRIBUTES. The extra info is queried later. */
+NautilusFile *
+nautilus_file_new_from_basic_info (NautilusDirectory *directory,
+                                   GFileInfo         *info)
+{
+    return new_from_info_internal (directory, info, TRUE);
+}
+
 static NautilusFileInfo *
 nautilus_file_get_internal (GFile    *location,
                             gboolean  create)
@@ -847,6 +1054,67 @@ nautilus_file_is_self_owned (NautilusFile *file)
     return file->details->directory->details->as_file == file;
 }
 
+static void
+clear_thumbnail (NautilusFile *file)
+{
+    if (file->details->thumbnail_link != NULL)
+    {
+        g_queue_delete_link (&loaded_thumbnails, file->details->thumbnail_link);
+        file->details->thumbnail_link = NULL;
+        loaded_thumbnails_size -= gdk_pixbuf_get_byte_length (file->details->thumbnail);
+    }
+
+    if (file->details->thumbnail != NULL)
+    {
+        nautilus_thumbnail_cache_forget_pixbuf (file->details->thumbnail);
+    }
+    g_clear_object (&file->details->thumbnail);
+}
+
+static void
+touch_thumbnail (NautilusFile *file)
+{
+    GList *link = file->details->thumbnail_link;
+
+    if (link != NULL && link != loaded_thumbnails.head)
+    {
+        g_queue_unlink (&loaded_thumbnails, link);
+        g_queue_push_head_link (&loaded_thumbnails, link);
+    }
+}
+
+static void
+take_thumbnail (NautilusFile *file,
+                GdkPixbuf    *pixbuf)
+{
+    GList *link;
+
+    clear_thumbnail (file);
+
+    file->details->thumbnail = pixbuf;
+    g_queue_push_head (&loaded_thumbnails, file);
+    file->details->thumbnail_link = loaded_thumbnails.head;
+    loaded_thumbnails_size += gdk_pixbuf_get_byte_length (pixbuf);
+
+    link = loaded_thumbnails.tail;
+    while (loaded_thumbnails_size > THUMBNAIL_MEMORY_BUDGET && link != NULL)
+    {
+        NautilusFile *old_file = link->data;
+
+        link = link->prev;
+
+        /* Thumbnails on screen stay, even if that means going over budget */
+        if (old_file == file ||
+            nautilus_directory_is_thumbnail_wanted (old_file->details->directory, old_file))
+        {
+            continue;
+        }
+
+        clear_thumbnail (old_file);
+        old_file->details->thumbnail_is_up_to_date = FALSE;
+    }
+}
+
 static void
 finalize (GObject *object)
 {
@@ -856,8 +1124,6 @@ finalize (GObject *object)
 
     file = NAUTILUS_FILE (object);
 
-    g_assert (file->details->operations_in_progress == NULL);
-
     if (file->details->is_thumbnailing)
     {
         uri = nautilus_file_get_uri (file);
@@ -892,52 +1158,34 @@ finalize (GObject *object)
     g_clear_pointer (&file->details->name, g_ref_string_release);
     g_clear_pointer (&file->details->display_name, g_ref_string_release);
     g_free (file->details->display_name_collation_key);
-    g_free (file->details->directory_name_collation_key);
+    g_clear_pointer (&file->details->directory_name_collation_key, g_ref_string_release);
     g_clear_pointer (&file->details->edit_name, g_ref_string_release);
     if (file->details->icon)
     {
         g_object_unref (file->details->icon);
     }
     g_free (file->details->thumbnail_path);
-    g_free (file->details->symlink_name);
     g_clear_pointer (&file->details->mime_type, g_ref_string_release);
     g_clear_pointer (&file->details->owner, g_ref_string_release);
     g_clear_pointer (&file->details->owner_real, g_ref_string_release);
     g_clear_pointer (&file->details->group, g_ref_string_release);
     g_free (file->details->selinux_context);
     g_free (file->details->activation_uri);
-    g_clear_object (&file->details->custom_icon);
 
-    if (file->details->thumbnail)
-    {
-        g_object_unref (file->details->thumbnail);
-    }
+    clear_thumbnail (file);
 
     g_clear_object (&file->details->mount);
 
     g_clear_pointer (&file->details->filesystem_id, g_ref_string_release);
-    g_free (file->details->trash_orig_path);
 
-    g_list_free_full (file->details->pending_extension_emblems, g_free);
-    g_list_free_full (file->details->extension_emblems, g_free);
     g_list_free_full (file->details->pending_info_providers, g_object_unref);
 
-    if (file->details->pending_extension_attributes)
-    {
-        g_hash_table_destroy (file->details->pending_extension_attributes);
-    }
-
-    if (file->details->extension_attributes)
-    {
-        g_hash_table_destroy (file->details->extension_attributes);
-    }
-
     if (file->details->metadata)
     {
         metadata_hash_free (file->details->metadata);
     }
 
-    g_free (file->details->fts_snippet);
+    g_clear_pointer (&file->details->cold, cold_data_free);
 
     G_OBJECT_CLASS (nautilus_file_parent_class)->finalize (object);
 }
@@ -1661,6 +1909,7 @@ nautilus_file_operation_new (NautilusFile                  *file,
                              gpointer                       callback_data)
 {
     NautilusFileOperation *op;
+    NautilusFileColdData *cold;
 
     op = g_new0 (NautilusFileOperation, 1);
     op->file = nautilus_file_ref (file);
@@ -1668,8 +1917,8 @@ nautilus_file_operation_new (NautilusFile                  *file,
     op->callback_data = callback_data;
     op->cancellable = g_cancellable_new ();
 
-    op->file->details->operations_in_progress = g_list_prepend
-                                                    (op->file->details->operations_in_progress, op);
+    cold = nautilus_file_get_cold_data (file);
+    cold->operations_in_progress = g_list_prepend (cold->operations_in_progress, op);
 
     return op;
 }
@@ -1678,17 +1927,16 @@ static void
 nautilus_file_operation_remove (NautilusFileOperation *op)
 {
     GList *l;
-    NautilusFile *file;
-
-    op->file->details->operations_in_progress = g_list_remove
-                                                    (op->file->details->operations_in_progress, op);
+    NautilusFileColdData *cold;
 
+    /* Adding the operation allocated the cold data of all these files */
+    cold = op->file->details->cold;
+    cold->operations_in_progress = g_list_remove (cold->operations_in_progress, op);
 
     for (l = op->files; l != NULL; l = l->next)
     {
-        file = NAUTILUS_FILE (l->data);
-        file->details->operations_in_progress = g_list_remove
-                                                    (file->details->operations_in_progress, op);
+        cold = NAUTILUS_FILE (l->data)->details->cold;
+        cold->operations_in_progress = g_list_remove (cold->operations_in_progress, op);
     }
 }
 
@@ -2112,10 +2360,9 @@ real_batch_rename (GList                         *files,
 
     for (l1 = files->next; l1 != NULL; l1 = l1->next)
     {
-        file = NAUTILUS_FILE (l1->data);
+        NautilusFileColdData *cold = nautilus_file_get_cold_data (NAUTILUS_FILE (l1->data));
 
-        file->details->operations_in_progress = g_list_prepend (file->details->operations_in_progress,
-                                                                op);
+        cold->operations_in_progress = g_list_prepend (cold->operations_in_progress, op);
     }
 
     for (l1 = files, l2 = new_names; l1 != NULL && l2 != NULL; l1 = l1->next, l2 = l2->next)
@@ -2212,7 +2459,12 @@ nautilus_file_rename_in_progress (NautilusFile *file)
     GList *node;
     NautilusFileOperation *op;
 
-    for (node = file->details->operations_in_progress; node != NULL; node = node->next)
+    if (file->details->cold == NULL)
+    {
+        return FALSE;
+    }
+
+    for (node = file->details->cold->operations_in_progress; node != NULL; node = node->next)
     {
         op = node->data;
         if (op->is_rename)
@@ -2231,7 +2483,12 @@ nautilus_file_cancel (NautilusFile                  *file,
     GList *node, *next;
     NautilusFileOperation *op;
 
-    for (node = file->details->operations_in_progress; node != NULL; node = next)
+    if (file->details->cold == NULL)
+    {
+        return;
+    }
+
+    for (node = file->details->cold->operations_in_progress; node != NULL; node = next)
     {
         next = node->next;
         op = node->data;
@@ -2349,10 +2606,84 @@ update_links_if_target (NautilusFile *target_file)
     nautilus_file_list_free (link_files);
 }
 
+/* Updates the attributes of NAUTILUS_FILE_EXTRA_ATTRIBUTES, expects the
+ * basic ones to be known already. */
+gboolean
+nautilus_file_update_extra_info (NautilusFile *file,
+                                 GFileInfo    *info)
+{
+    gboolean changed = FALSE;
+    const char *owner, *owner_real, *group;
+    g_autofree char *uid_string = NULL;
+    g_autofree char *gid_string = NULL;
+    const char *selinux_context, *thumbnail_path;
+    gboolean thumbnailing_failed;
+
+    file->details->extra_info_is_up_to_date = TRUE;
+
+    owner = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_OWNER_USER);
+    owner_real = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_OWNER_USER_REAL);
+    group = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_OWNER_GROUP);
+
+    if (owner == NULL && file->details->has_uid)
+    {
+        uid_string = g_strdup_printf ("%d", file->details->uid);
+        owner = uid_string;
+    }
+    if (group == NULL && file->details->has_gid)
+    {
+        gid_string = g_strdup_printf ("%d", file->details->gid);
+        group = gid_string;
+    }
+
+    if (g_strcmp0 (file->details->owner, owner) != 0)
+    {
+        changed = TRUE;
+        g_clear_pointer (&file->details->owner, g_ref_string_release);
+        file->details->owner = g_ref_string_new_intern (owner);
+    }
+
+    if (g_strcmp0 (file->details->owner_real, owner_real) != 0)
+    {
+        changed = TRUE;
+        g_clear_pointer (&file->details->owner_real, g_ref_string_release);
+        file->details->owner_real = g_ref_string_new_intern (owner_real);
+    }
+
+    if (g_strcmp0 (file->details->group, group) != 0)
+    {
+        changed = TRUE;
+        g_clear_pointer (&file->details->group, g_ref_string_release);
+        file->details->group = g_ref_string_new_intern (group);
+    }
+
+    thumbnail_path = g_file_info_get_attribute_byte_string (info, G_FILE_ATTRIBUTE_THUMBNAIL_PATH);
+    if (g_set_str (&file->details->thumbnail_path, thumbnail_path))
+    {
+        changed = TRUE;
+    }
+
+    thumbnailing_failed = g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_THUMBNAILING_FAILED);
+    if (file->details->thumbnailing_failed != thumbnailing_failed)
+    {
+        changed = TRUE;
+        file->details->thumbnailing_failed = thumbnailing_failed;
+    }
+
+    selinux_context = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_SELINUX_CONTEXT);
+    if (g_set_str (&file->details->selinux_context, selinux_context))
+    {
+        changed = TRUE;
+    }
+
+    return changed;
+}
+
 static gboolean
 update_info_internal (NautilusFile *file,
                       GFileInfo    *info,
-                      gboolean      update_name)
+                      gboolean      update_name,
+                      gboolean      is_basic)
 {
     GList *node;
     gboolean changed;
@@ -2362,7 +2693,6 @@ update_info_internal (NautilusFile *file,
     gboolean can_read, can_write, can_execute, can_delete, can_trash, can_rename, can_mount, can_unmount, can_eject;
     gboolean can_start, can_start_degraded, can_stop, can_poll_for_media, is_media_check_automatic;
     GDriveStartStopType start_stop_type;
-    gboolean thumbnailing_failed;
     gboolean has_uid = FALSE;
     uid_t uid = 0;
     gboolean has_gid = FALSE;
@@ -2373,13 +2703,11 @@ update_info_internal (NautilusFile *file,
     time_t trash_time;
     time_t recency;
     const char *time_string;
-    const char *symlink_name, *mime_type, *selinux_context, *name, *thumbnail_path;
+    const char *symlink_name, *mime_type, *name;
     GFileType file_type;
     GIcon *icon;
     const char *filesystem_id;
     const char *trash_orig_path;
-    const char *group, *owner, *owner_real;
-    gboolean free_owner, free_group;
     const char *edit_name;
 
     if (file->details->is_gone)
@@ -2595,31 +2923,15 @@ update_info_internal (NautilusFile *file,
     file->details->can_poll_for_media = can_poll_for_media;
     file->details->is_media_check_automatic = is_media_check_automatic;
 
-    free_owner = FALSE;
-    owner = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_OWNER_USER);
-    owner_real = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_OWNER_USER_REAL);
-    free_group = FALSE;
-    group = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_OWNER_GROUP);
-
     if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_UNIX_UID))
     {
         uid = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_UID);
         has_uid = TRUE;
-        if (owner == NULL)
-        {
-            free_owner = TRUE;
-            owner = g_strdup_printf ("%d", uid);
-        }
     }
     if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_UNIX_GID))
     {
         gid = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_GID);
         has_gid = TRUE;
-        if (group == NULL)
-        {
-            free_group = TRUE;
-            group = g_strdup_printf ("%d", gid);
-        }
     }
     if (file->details->has_uid != has_uid ||
         (file->details->has_uid && file->details->uid != uid) ||
@@ -2633,36 +2945,6 @@ update_info_internal (NautilusFile *file,
     file->details->has_gid = has_gid;
     file->details->gid = gid;
 
-    if (g_strcmp0 (file->details->owner, owner) != 0)
-    {
-        changed = TRUE;
-        g_clear_pointer (&file->details->owner, g_ref_string_release);
-        file->details->owner = g_ref_string_new_intern (owner);
-    }
-
-    if (g_strcmp0 (file->details->owner_real, owner_real) != 0)
-    {
-        changed = TRUE;
-        g_clear_pointer (&file->details->owner_real, g_ref_string_release);
-        file->details->owner_real = g_ref_string_new_intern (owner_real);
-    }
-
-    if (g_strcmp0 (file->details->group, group) != 0)
-    {
-        changed = TRUE;
-        g_clear_pointer (&file->details->group, g_ref_string_release);
-        file->details->group = g_ref_string_new_intern (group);
-    }
-
-    if (free_owner)
-    {
-        g_free ((char *) owner);
-    }
-    if (free_group)
-    {
-        g_free ((char *) group);
-    }
-
     size = -1;
     if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_SIZE))
     {
@@ -2719,22 +3001,10 @@ update_info_internal (NautilusFile *file,
         file->details->icon = g_object_ref (icon);
     }
 
-    thumbnail_path = g_file_info_get_attribute_byte_string (info, G_FILE_ATTRIBUTE_THUMBNAIL_PATH);
-    if (g_set_str (&file->details->thumbnail_path, thumbnail_path))
-    {
-        changed = TRUE;
-    }
-
-    thumbnailing_failed = g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_THUMBNAILING_FAILED);
-    if (file->details->thumbnailing_failed != thumbnailing_failed)
-    {
-        changed = TRUE;
-        file->details->thumbnailing_failed = thumbnailing_failed;
-    }
-
     symlink_name = g_file_info_get_attribute_byte_string (info,
                                                           G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET);
-    if (g_set_str (&file->details->symlink_name, symlink_name))
+    if ((symlink_name != NULL || file->details->cold != NULL) &&
+        g_set_str (&nautilus_file_get_cold_data (file)->symlink_name, symlink_name))
     {
         changed = TRUE;
     }
@@ -2752,12 +3022,6 @@ update_info_internal (NautilusFile *file,
         file->details->mime_type = g_ref_string_new_intern (mime_type);
     }
 
-    selinux_context = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_SELINUX_CONTEXT);
-    if (g_set_str (&file->details->selinux_context, selinux_context))
-    {
-        changed = TRUE;
-    }
-
     filesystem_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
     if (g_strcmp0 (file->details->filesystem_id, filesystem_id) != 0)
     {
@@ -2789,7 +3053,8 @@ update_info_internal (NautilusFile *file,
     }
 
     trash_orig_path = g_file_info_get_attribute_byte_string (info, "trash::orig-path");
-    if (g_set_str (&file->details->trash_orig_path, trash_orig_path))
+    if ((trash_orig_path != NULL || file->details->cold != NULL) &&
+        g_set_str (&nautilus_file_get_cold_data (file)->trash_orig_path, trash_orig_path))
     {
         changed = TRUE;
     }
@@ -2799,8 +3064,19 @@ update_info_internal (NautilusFile *file,
         file->details->has_preview_icon = TRUE;
     }
 
-    changed |=
-        nautilus_file_update_metadata_from_info (file, info);
+    /* Custom icons and the like come from the metadata, so it is part of
+     * the basic info, to show them along with the file. */
+    changed |= nautilus_file_update_metadata_from_info (file, info);
+
+    /* The extra info is left as it is until it's queried. */
+    if (is_basic)
+    {
+        file->details->extra_info_is_up_to_date = FALSE;
+    }
+    else
+    {
+        changed |= nautilus_file_update_extra_info (file, info);
+    }
 
     if (update_name)
     {
@@ -2822,6 +3098,7 @@ update_info_internal (NautilusFile *file,
             {
                 file->details->name = g_ref_string_new (name);
             }
+            nautilus_file_invalidate_starred (file);
 
             if (!file->details->got_custom_display_name &&
                 g_file_info_get_display_name (info) == NULL)
@@ -2843,6 +3120,8 @@ update_info_internal (NautilusFile *file,
         add_to_link_hash_table (file);
 
         update_links_if_target (file);
+
+        invalidate_emblems_key (file);
     }
 
     return changed;
@@ -2852,14 +3131,21 @@ static gboolean
 update_info_and_name (NautilusFile *file,
                       GFileInfo    *info)
 {
-    return update_info_internal (file, info, TRUE);
+    return update_info_internal (file, info, TRUE, FALSE);
 }
 
 gboolean
 nautilus_file_update_info (NautilusFile *file,
                            GFileInfo    *info)
 {
-    return update_info_internal (file, info, FALSE);
+    return update_info_internal (file, info, FALSE, FALSE);
+}
+
+gboolean
+nautilus_file_update_basic_info (NautilusFile *file,
+                                 GFileInfo    *info)
+{
+    return update_info_internal (file, info, FALSE, TRUE);
 }
 
 static gboolean
@@ -2890,6 +3176,7 @@ update_name_internal (NautilusFile *file,
 
     g_clear_pointer (&file->details->name, g_ref_string_release);
     file->details->name = g_ref_string_new (name);
+    nautilus_file_invalidate_starred (file);
 
     if (!file->details->got_custom_display_name)
     {
@@ -3282,6 +3569,13 @@ static int
 compare_by_directory_name (NautilusFile *file_1,
                            NautilusFile *file_2)
 {
+    /* The keys are interned, so files of the same directory share theirs */
+    if (file_1->details->directory_name_collation_key ==
+        file_2->details->directory_name_collation_key)
+    {
+        return 0;
+    }
+
     return strcmp (file_1->details->directory_name_collation_key,
                    file_2->details->directory_name_collation_key);
 }
@@ -3324,15 +3618,70 @@ prepend_automatic_keywords (NautilusFile *file,
     return names;
 }
 
+/* Sorting by type compares ranks instead of collating strings. The strings
+ * are the type descriptions and the MIME types, of which there are only a
+ * few, so they are collated once and ranked whenever a new one shows up.
+ *
+ * Sorting only happens in the main thread. */
+typedef struct
+{
+    GHashTable *ranks;  /* char * → rank */
+    GPtrArray *strings; /* sorted, owns the keys of ranks */
+} RankTable;
+
+static RankTable type_description_ranks;
+static RankTable mime_type_ranks;
+
+static int
+collate_strings (gconstpointer a,
+                 gconstpointer b)
+{
+    return g_utf8_collate (a, b);
+}
+
+static guint
+rank_table_lookup (RankTable  *table,
+                   const char *string)
+{
+    gpointer rank;
+
+    /* Unknown types sort last */
+    if (string == NULL)
+    {
+        return G_MAXUINT;
+    }
+
+    if (table->ranks == NULL)
+    {
+        table->ranks = g_hash_table_new (g_str_hash, g_str_equal);
+        table->strings = g_ptr_array_new_with_free_func (g_free);
+    }
+
+    if (g_hash_table_lookup_extended (table->ranks, string, NULL, &rank))
+    {
+        return GPOINTER_TO_UINT (rank);
+    }
+
+    g_ptr_array_add (table->strings, g_strdup (string));
+    g_ptr_array_sort_values (table->strings, collate_strings);
+    for (guint i = 0; i < table->strings->len; i++)
+    {
+        g_hash_table_insert (table->ranks,
+                             g_ptr_array_index (table->strings, i),
+                             GUINT_TO_POINTER (i));
+    }
+
+    return GPOINTER_TO_UINT (g_hash_table_lookup (table->ranks, string));
+}
+
 static int
 compare_by_type (NautilusFile *file_1,
                  NautilusFile *file_2)
 {
     gboolean is_directory_1;
     gboolean is_directory_2;
-    const char *type_string_1;
-    const char *type_string_2;
-    int result;
+    guint rank_1;
+    guint rank_2;
 
     /* Directories go first. Then, if mime types are identical,
      * don't bother getting strings (for speed). This assumes
@@ -3365,51 +3714,68 @@ compare_by_type (NautilusFile *file_1,
         return 0;
     }
 
-    type_string_1 = nautilus_file_get_type_as_string_no_extra_text (file_1);
-    type_string_2 = nautilus_file_get_type_as_string_no_extra_text (file_2);
+    rank_1 = rank_table_lookup (&type_description_ranks,
+                                nautilus_file_get_type_as_string_no_extra_text (file_1));
+    rank_2 = rank_table_lookup (&type_description_ranks,
+                                nautilus_file_get_type_as_string_no_extra_text (file_2));
 
-    if (type_string_1 == NULL || type_string_2 == NULL)
+    if (rank_1 == rank_2 && rank_1 != G_MAXUINT)
     {
-        if (type_string_1 != NULL)
-        {
-            return -1;
-        }
+        /* Among files of the same (generic) type, sort them by mime type. */
+        rank_1 = rank_table_lookup (&mime_type_ranks, file_1->details->mime_type);
+        rank_2 = rank_table_lookup (&mime_type_ranks, file_2->details->mime_type);
+    }
 
-        if (type_string_2 != NULL)
-        {
-            return 1;
-        }
+    return (rank_1 > rank_2) - (rank_1 < rank_2);
+}
 
-        return 0;
-    }
+/**
+ * nautilus_file_invalidate_starred:
+ * @file: a #NautilusFile
+ *
+ * Called by the tag manager when @file gets starred or unstarred, and when
+ * the location of @file changes, for the cached state to be looked up again.
+ */
+void
+nautilus_file_invalidate_starred (NautilusFile *file)
+{
+    g_return_if_fail (NAUTILUS_IS_FILE (file));
 
-    result = g_utf8_collate (type_string_1, type_string_2);
-    if (result == 0)
+    file->details->starred_is_up_to_date = FALSE;
+}
+
+static gboolean
+get_is_starred (NautilusFile *file)
+{
+    if (!file->details->starred_is_up_to_date)
     {
-        /* Among files of the same (generic) type, sort them by mime type. */
-        result = g_utf8_collate (file_1->details->mime_type, file_2->details->mime_type);
+        NautilusTagManager *tag_manager = nautilus_tag_manager_get ();
+        g_autofree gchar *uri = nautilus_file_get_uri (file);
+
+        file->details->is_starred = nautilus_tag_manager_file_is_starred (tag_manager, uri);
+        file->details->starred_is_up_to_date = TRUE;
     }
 
-    return result;
+    return file->details->is_starred;
+}
+
+gboolean
+nautilus_file_is_starred (NautilusFile *file)
+{
+    g_return_val_if_fail (NAUTILUS_IS_FILE (file), FALSE);
+
+    return get_is_starred (file);
 }
 
 static int
 compare_by_starred (NautilusFile *file_1,
                     NautilusFile *file_2)
 {
-    NautilusTagManager *tag_manager = nautilus_tag_manager_get ();
-    g_autofree gchar *uri_1 = NULL;
-    g_autofree gchar *uri_2 = NULL;
     gboolean file_1_is_starred;
     gboolean file_2_is_starred;
 
-    uri_1 = nautilus_file_get_uri (file_1);
-    uri_2 = nautilus_file_get_uri (file_2);
-
-    file_1_is_starred = nautilus_tag_manager_file_is_starred (tag_manager,
-                                                              uri_1);
-    file_2_is_starred = nautilus_tag_manager_file_is_starred (tag_manager,
-                                                              uri_2);
+    file_1_is_starred = get_is_starred (file_1);
+    file_2_is_starred = get_is_starred (file_2);
     if (!!file_1_is_starred == !!file_2_is_starred)
     {
         return 0;
@@ -3859,6 +4225,108 @@ nautilus_file_compare_for_sort_by_attribute     (NautilusFile *file_1,
                                                           reversed);
 }
 
+static guint
+hash_time_for_sort (NautilusFile     *file,
+                    NautilusDateType  type)
+{
+    time_t time = 0;
+    gint64 time_64;
+    Knowledge known;
+
+    known = get_time (file, &time, type);
+    time_64 = time;
+
+    return known * 31 + g_int64_hash (&time_64);
+}
+
+/**
+ * nautilus_file_hash_for_sort_by_attribute_q:
+ * @file: a #NautilusFile
+ * @attribute: the attribute files are sorted by
+ *
+ * Hashes what nautilus_file_compare_for_sort_by_attribute_q() looks at to
+ * place @file, so that a change of @file which leaves the hash alone can't
+ * have moved it in a sorted list.
+ *
+ * Returns: the hash
+ */
+guint
+nautilus_file_hash_for_sort_by_attribute_q (NautilusFile *file,
+                                            GQuark        attribute)
+{
+    guint hash;
+
+    g_return_val_if_fail (NAUTILUS_IS_FILE (file), 0);
+
+    /* What every attribute falls back to, or breaks ties with */
+    hash = attribute;
+    hash = hash * 31 + nautilus_file_is_directory (file);
+    hash = hash * 31 + file->details->sort_order;
+    hash = hash * 31 + GPOINTER_TO_UINT (file->details->directory_name_collation_key);
+    hash = hash * 31 + g_str_hash (nautilus_file_peek_display_name (file));
+    hash = hash * 31 + g_str_hash (nautilus_file_peek_display_name_collation_key (file));
+    if (file->details->name != NULL)
+    {
+        hash = hash * 31 + g_str_hash (file->details->name);
+    }
+
+    if (attribute == 0 || attribute == attribute_name_q)
+    {
+        return hash;
+    }
+    else if (attribute == attribute_size_q)
+    {
+        guint count = 0;
+        goffset size = 0;
+        gint64 size_64;
+
+        hash = hash * 31 + get_item_count (file, &count);
+        hash = hash * 31 + count;
+        hash = hash * 31 + get_size (file, &size);
+        size_64 = size;
+        return hash * 31 + g_int64_hash (&size_64);
+    }
+    else if (attribute == attribute_type_q)
+    {
+        return hash * 31 + (file->details->mime_type != NULL ?
+                            g_str_hash (file->details->mime_type) : 0);
+    }
+    else if (attribute == attribute_starred_q)
+    {
+        return hash * 31 + get_is_starred (file);
+    }
+    else if (attribute == attribute_modification_date_q || attribute == attribute_date_modified_q || attribute == attribute_date_modified_full_q)
+    {
+        return hash * 31 + hash_time_for_sort (file, NAUTILUS_DATE_TYPE_MODIFIED);
+    }
+    else if (attribute == attribute_accessed_date_q || attribute == attribute_date_accessed_q || attribute == attribute_date_accessed_full_q)
+    {
+        return hash * 31 + hash_time_for_sort (file, NAUTILUS_DATE_TYPE_ACCESSED);
+    }
+    else if (attribute == attribute_date_created_q || attribute == attribute_date_created_full_q)
+    {
+        return hash * 31 + hash_time_for_sort (file, NAUTILUS_DATE_TYPE_CREATED);
+    }
+    else if (attribute == attribute_trashed_on_q || attribute == attribute_trashed_on_full_q)
+    {
+        return hash * 31 + hash_time_for_sort (file, NAUTILUS_DATE_TYPE_TRASHED);
+    }
+    else if (attribute == attribute_search_relevance_q)
+    {
+        return hash * 31 + g_double_hash (&file->details->search_relevance);
+    }
+    else if (attribute == attribute_recency_q)
+    {
+        return hash * 31 + hash_time_for_sort (file, NAUTILUS_DATE_TYPE_RECENCY);
+    }
+    else
+    {
+        g_autofree char *value = nautilus_file_get_string_attribute_q (file, attribute);
+
+        return hash * 31 + (value != NULL ? g_str_hash (value) : 0);
+    }
+}
+
 
 /**
  * nautilus_file_compare_name:
@@ -4644,8 +5112,12 @@ nautilus_file_get_keywords (NautilusFile *file)
 
     g_return_val_if_fail (NAUTILUS_IS_FILE (file), NULL);
 
-    keywords = g_list_copy_deep (file->details->extension_emblems, (GCopyFunc) g_strdup, NULL);
-    keywords = g_list_concat (keywords, g_list_copy_deep (file->details->pending_extension_emblems, (GCopyFunc) g_strdup, NULL));
+    keywords = NULL;
+    if (file->details->cold != NULL)
+    {
+        keywords = g_list_copy_deep (file->details->cold->extension_emblems, (GCopyFunc) g_strdup, NULL);
+        keywords = g_list_concat (keywords, g_list_copy_deep (file->details->cold->pending_extension_emblems, (GCopyFunc) g_strdup, NULL));
+    }
 
     metadata_strv = nautilus_file_get_metadata_list (file, NAUTILUS_METADATA_KEY_EMBLEMS);
     /* Convert array to list */
@@ -4715,6 +5187,49 @@ nautilus_file_get_emblem_icons (NautilusFile *file)
     return icons;
 }
 
+/**
+ * nautilus_file_get_emblems_key:
+ * @file: a #NautilusFile
+ *
+ * Returns a string identifying the emblems of @file, cheap to get while they
+ * don't change. The string is interned, so files with the same emblems have
+ * the same key.
+ *
+ * Returns: (nullable): the key of the emblems of @file, or %NULL if it has
+ *     none.
+ */
+const char *
+nautilus_file_get_emblems_key (NautilusFile *file)
+{
+    g_return_val_if_fail (NAUTILUS_IS_FILE (file), NULL);
+
+    if (!file->details->emblems_key_is_up_to_date)
+    {
+        g_autolist (GIcon) emblems = nautilus_file_get_emblem_icons (file);
+        g_autoptr (GString) key = NULL;
+
+        for (GList *l = emblems; l != NULL; l = l->next)
+        {
+            g_autofree char *icon_string = g_icon_to_string (l->data);
+
+            if (key == NULL)
+            {
+                key = g_string_new (icon_string);
+            }
+            else
+            {
+                g_string_append_c (key, '\n');
+                g_string_append (key, icon_string);
+            }
+        }
+
+        file->details->emblems_key = (key != NULL) ? g_intern_string (key->str) : NULL;
+        file->details->emblems_key_is_up_to_date = TRUE;
+    }
+
+    return file->details->emblems_key;
+}
+
 GIcon *
 nautilus_file_get_gicon (NautilusFile          *file,
                          NautilusFileIconFlags  flags)
@@ -4775,43 +5290,22 @@ nautilus_file_get_thumbnail_icon (NautilusFile          *file,
 
     if (file->details->thumbnail != NULL)
     {
-        GdkPixbuf *pixbuf = file->details->thumbnail;
-        double width = gdk_pixbuf_get_width (pixbuf) / scale;
-        double height = gdk_pixbuf_get_height (pixbuf) / scale;
-        g_autoptr (GdkTexture) texture = gdk_texture_new_for_pixbuf (pixbuf);
-        g_autoptr (GtkSnapshot) snapshot = gtk_snapshot_new ();
-        GskRoundedRect rounded_rect;
-
-        if (MAX (width, height) > size)
-        {
-            float scale_down_factor = MAX (width, height) / size;
-
-            width = width / scale_down_factor;
-            height = height / scale_down_factor;
-        }
-
-        gsk_rounded_rect_init_from_rect (&rounded_rect,
-                                         &GRAPHENE_RECT_INIT (0, 0, width, height),
-                                         2 /* radius*/);
-        gtk_snapshot_push_rounded_clip (snapshot, &rounded_rect);
-
-        gdk_paintable_snapshot (GDK_PAINTABLE (texture),
-                                GDK_SNAPSHOT (snapshot),
-                                width, height);
+        touch_thumbnail (file);
 
-        if (size >= NAUTILUS_GRID_ICON_SIZE_SMALL &&
-            nautilus_is_video_file (file))
-        {
-            nautilus_ui_frame_video (snapshot, width, height);
-        }
+        /* Thumbnails without a modification time can't be told apart from
+         * the next thumbnail of the same file, so they are not cached. */
+        const char *cache_path = file->details->thumbnail_mtime != 0 ?
+                                 file->details->thumbnail_path : NULL;
 
-        gtk_snapshot_pop (snapshot); /* End rounded clip */
-
-        g_debug ("Returning thumbnailed image, at size %d %d",
-                 (int) (width), (int) (height));
-        paintable = gtk_snapshot_to_paintable (snapshot, NULL);
+        paintable = nautilus_thumbnail_cache_get_paintable (cache_path,
+                                                            file->details->thumbnail_mtime,
+                                                            file->details->thumbnail,
+                                                            size, scale,
+                                                            size >= NAUTILUS_GRID_ICON_SIZE_SMALL &&
+                                                            nautilus_is_video_file (file));
     }
     else if (file->details->thumbnail_path == NULL &&
+             file->details->extra_info_is_up_to_date &&
              file->details->can_read &&
              !file->details->is_thumbnailing &&
              !file->details->thumbnailing_failed &&
@@ -5267,13 +5761,16 @@ void
 nautilus_file_set_search_fts_snippet (NautilusFile *file,
                                       const gchar  *fts_snippet)
 {
-    g_set_str (&file->details->fts_snippet, fts_snippet);
+    if (fts_snippet != NULL || file->details->cold != NULL)
+    {
+        g_set_str (&nautilus_file_get_cold_data (file)->fts_snippet, fts_snippet);
+    }
 }
 
 const gchar *
 nautilus_file_get_search_fts_snippet (NautilusFile *file)
 {
-    return file->details->fts_snippet;
+    return file->details->cold != NULL ? file->details->cold->fts_snippet : NULL;
 }
 
 /**
@@ -6622,15 +7119,20 @@ nautilus_file_get_string_attribute_q (NautilusFile *file,
 
     extension_attribute = NULL;
 
-    if (file->details->pending_extension_attributes)
+    if (file->details->cold == NULL)
     {
-        extension_attribute = g_hash_table_lookup (file->details->pending_extension_attributes,
+        return NULL;
+    }
+
+    if (file->details->cold->pending_extension_attributes)
+    {
+        extension_attribute = g_hash_table_lookup (file->details->cold->pending_extension_attributes,
                                                    GINT_TO_POINTER (attribute_q));
     }
 
-    if (extension_attribute == NULL && file->details->extension_attributes)
+    if (extension_attribute == NULL && file->details->cold->extension_attributes)
     {
-        extension_attribute = g_hash_table_lookup (file->details->extension_attributes,
+        extension_attribute = g_hash_table_lookup (file->details->cold->extension_attributes,
                                                    GINT_TO_POINTER (attribute_q));
     }
 
@@ -7046,6 +7548,8 @@ nautilus_file_set_mount (NautilusFile *file,
         g_signal_connect_object (mount, "unmounted",
                                  G_CALLBACK (file_mount_unmounted), file, 0);
     }
+
+    invalidate_emblems_key (file);
 }
 
 /**
@@ -7077,6 +7581,7 @@ get_fs_free_cb (GObject      *source_object,
                 gpointer      user_data)
 {
     NautilusFile *file;
+    NautilusFileColdData *cold;
     guint64 free_space;
     GFileInfo *info;
 
@@ -7094,9 +7599,10 @@ get_fs_free_cb (GObject      *source_object,
         g_object_unref (info);
     }
 
-    if (file->details->free_space != free_space)
+    cold = nautilus_file_get_cold_data (file);
+    if (cold->free_space != free_space)
     {
-        file->details->free_space = free_space;
+        cold->free_space = free_space;
         nautilus_file_emit_changed (file);
     }
 
@@ -7113,16 +7619,18 @@ get_fs_free_cb (GObject      *source_object,
 char *
 nautilus_file_get_volume_free_space (NautilusFile *file)
 {
+    NautilusFileColdData *cold;
     GFile *location;
     char *res;
     time_t now;
 
+    cold = nautilus_file_get_cold_data (file);
     now = time (NULL);
     /* Update first time and then every 2 seconds */
-    if (file->details->free_space_read == 0 ||
-        (now - file->details->free_space_read) > 2)
+    if (cold->free_space_read == 0 ||
+        (now - cold->free_space_read) > 2)
     {
-        file->details->free_space_read = now;
+        cold->free_space_read = now;
         location = nautilus_file_get_location (file);
         g_file_query_filesystem_info_async (location,
                                             G_FILE_ATTRIBUTE_FILESYSTEM_FREE,
@@ -7133,9 +7641,9 @@ nautilus_file_get_volume_free_space (NautilusFile *file)
     }
 
     res = NULL;
-    if (file->details->free_space != (guint64) - 1)
+    if (cold->free_space != (guint64) - 1)
     {
-        g_autofree gchar *size_string = g_format_size (file->details->free_space);
+        g_autofree gchar *size_string = g_format_size (cold->free_space);
 
         /* Translators: This refers to available space in a folder; e.g.: 100 MB Free */
         res = g_strdup_printf (_("%s Free"), size_string);
@@ -7177,7 +7685,7 @@ nautilus_file_get_symbolic_link_target_path (NautilusFile *file)
         g_warning ("File has symlink target, but  is not marked as symlink");
     }
 
-    return file->details->symlink_name;
+    return get_symlink_name (file);
 }
 
 /**
@@ -7200,7 +7708,7 @@ nautilus_file_get_symbolic_link_target_uri (NautilusFile *file)
         g_warning ("File has symlink target, but  is not marked as symlink");
     }
 
-    if (file->details->symlink_name == NULL)
+    if (get_symlink_name (file) == NULL)
     {
         return NULL;
     }
@@ -7213,7 +7721,7 @@ nautilus_file_get_symbolic_link_target_uri (NautilusFile *file)
         g_object_unref (location);
         if (parent)
         {
-            target = g_file_resolve_relative_path (parent, file->details->symlink_name);
+            target = g_file_resolve_relative_path (parent, get_symlink_name (file));
             g_object_unref (parent);
         }
 
@@ -7509,9 +8017,9 @@ nautilus_file_get_trash_original_file (NautilusFile *file)
 
     original_file = NULL;
 
-    if (file->details->trash_orig_path != NULL)
+    if (file->details->cold != NULL && file->details->cold->trash_orig_path != NULL)
     {
-        location = g_file_new_for_path (file->details->trash_orig_path);
+        location = g_file_new_for_path (file->details->cold->trash_orig_path);
         original_file = nautilus_file_get (location);
         g_object_unref (location);
     }
@@ -7774,6 +8282,12 @@ invalidate_file_info (NautilusFile *file)
     file->details->file_info_is_up_to_date = FALSE;
 }
 
+static void
+invalidate_extra_info (NautilusFile *file)
+{
+    file->details->extra_info_is_up_to_date = FALSE;
+}
+
 static void
 invalidate_thumbnail (NautilusFile *file)
 {
@@ -7823,6 +8337,10 @@ nautilus_file_invalidate_attributes_internal (NautilusFile           *file,
     {
         invalidate_file_info (file);
     }
+    if (REQUEST_WANTS_TYPE (request, REQUEST_EXTRA_INFO))
+    {
+        invalidate_extra_info (file);
+    }
     if (REQUEST_WANTS_TYPE (request, REQUEST_EXTENSION_INFO))
     {
         nautilus_file_invalidate_extension_info_internal (file);
@@ -7866,7 +8384,7 @@ nautilus_file_set_thumbnail (NautilusFile *file,
     g_return_val_if_fail (NAUTILUS_IS_FILE (file), FALSE);
 
     file->details->thumbnail_is_up_to_date = TRUE;
-    g_clear_object (&file->details->thumbnail);
+    clear_thumbnail (file);
 
     if (pixbuf != NULL)
     {
@@ -7879,7 +8397,7 @@ nautilus_file_set_thumbnail (NautilusFile *file,
         if (thumb_mtime == 0 ||
             thumb_mtime == file->details->mtime)
         {
-            file->details->thumbnail = g_object_ref (pixbuf);
+            take_thumbnail (file, g_object_ref (pixbuf));
             file->details->thumbnail_mtime = thumb_mtime;
         }
         else
@@ -7922,6 +8440,7 @@ NautilusFileAttributes
 nautilus_file_get_all_attributes (void)
 {
     return NAUTILUS_FILE_ATTRIBUTE_INFO |
+           NAUTILUS_FILE_ATTRIBUTE_EXTRA_INFO |
            NAUTILUS_FILE_ATTRIBUTE_DEEP_COUNTS |
            NAUTILUS_FILE_ATTRIBUTE_DIRECTORY_ITEM_COUNT |
            NAUTILUS_FILE_ATTRIBUTE_EXTENSION_INFO |
@@ -7950,7 +8469,7 @@ nautilus_file_invalidate_all_attributes (NautilusFile *file)
 void
 nautilus_file_dump (NautilusFile *file)
 {
-    long size = file->details->deep_size;
+    long size = file->details->cold != NULL ? file->details->cold->deep_size : 0;
     char *uri;
     const char *file_kind;
 
@@ -8003,7 +8522,7 @@ nautilus_file_dump (NautilusFile *file)
         g_print ("kind: %s \n", file_kind);
         if (file->details->type == G_FILE_TYPE_SYMBOLIC_LINK)
         {
-            g_print ("link to %s \n", file->details->symlink_name);
+            g_print ("link to %s \n", get_symlink_name (file));
             /* FIXME bugzilla.gnome.org 42430: add following of symlinks here */
         }
         /* FIXME bugzilla.gnome.org 42431: add permissions and other useful stuff here */
@@ -8443,21 +8962,24 @@ real_get_deep_counts (NautilusFile *file,
 
     if (file->details->deep_counts_status != NAUTILUS_REQUEST_NOT_STARTED)
     {
+        /* Allocated when the count started */
+        NautilusFileColdData *cold = nautilus_file_get_cold_data (file);
+
         if (directory_count != NULL)
         {
-            *directory_count = file->details->deep_directory_count;
+            *directory_count = cold->deep_directory_count;
         }
         if (file_count != NULL)
         {
-            *file_count = file->details->deep_file_count;
+            *file_count = cold->deep_file_count;
         }
         if (unreadable_directory_count != NULL)
         {
-            *unreadable_directory_count = file->details->deep_unreadable_count;
+            *unreadable_directory_count = cold->deep_unreadable_count;
         }
         if (total_size != NULL)
         {
-            *total_size = file->details->deep_size;
+            *total_size = cold->deep_size;
         }
         return file->details->deep_counts_status;
     }
@@ -8608,17 +9130,23 @@ nautilus_file_class_init (NautilusFileClass *class)
 void
 nautilus_file_info_providers_done (NautilusFile *file)
 {
-    g_list_free_full (file->details->extension_emblems, g_free);
-    file->details->extension_emblems = file->details->pending_extension_emblems;
-    file->details->pending_extension_emblems = NULL;
+    NautilusFileColdData *cold = file->details->cold;
 
-    if (file->details->extension_attributes)
+    if (cold != NULL)
     {
-        g_hash_table_destroy (file->details->extension_attributes);
-    }
+        g_list_free_full (cold->extension_emblems, g_free);
+        cold->extension_emblems = cold->pending_extension_emblems;
+        cold->pending_extension_emblems = NULL;
+        invalidate_emblems_key (file);
 
-    file->details->extension_attributes = file->details->pending_extension_attributes;
-    file->details->pending_extension_attributes = NULL;
+        if (cold->extension_attributes)
+        {
+            g_hash_table_destroy (cold->extension_attributes);
+        }
+
+        cold->extension_attributes = cold->pending_extension_attributes;
+        cold->pending_extension_attributes = NULL;
+    }
 
     nautilus_file_changed (file);
 }
@@ -8821,18 +9349,20 @@ add_emblem (NautilusFileInfo *file_info,
             const char       *emblem_name)
 {
     NautilusFile *file = NAUTILUS_FILE (file_info);
+    NautilusFileColdData *cold = nautilus_file_get_cold_data (file);
 
     if (file->details->pending_info_providers)
     {
-        file->details->pending_extension_emblems = g_list_prepend (file->details->pending_extension_emblems,
-                                                                   g_strdup (emblem_name));
+        cold->pending_extension_emblems = g_list_prepend (cold->pending_extension_emblems,
+                                                          g_strdup (emblem_name));
     }
     else
     {
-        file->details->extension_emblems = g_list_prepend (file->details->extension_emblems,
-                                                           g_strdup (emblem_name));
+        cold->extension_emblems = g_list_prepend (cold->extension_emblems,
+                                                  g_strdup (emblem_name));
     }
 
+    invalidate_emblems_key (file);
     nautilus_file_changed (file);
 }
 
@@ -8849,31 +9379,32 @@ add_string_attribute (NautilusFileInfo *file_info,
                       const char       *value)
 {
     NautilusFile *file = NAUTILUS_FILE (file_info);
+    NautilusFileColdData *cold = nautilus_file_get_cold_data (file);
 
     if (file->details->pending_info_providers != NULL)
     {
         /* Lazily create hashtable */
-        if (file->details->pending_extension_attributes == NULL)
+        if (cold->pending_extension_attributes == NULL)
         {
-            file->details->pending_extension_attributes =
+            cold->pending_extension_attributes =
                 g_hash_table_new_full (g_direct_hash, g_direct_equal,
                                        NULL,
                                        (GDestroyNotify) g_free);
         }
-        g_hash_table_insert (file->details->pending_extension_attributes,
+        g_hash_table_insert (cold->pending_extension_attributes,
                              GINT_TO_POINTER (g_quark_from_string (attribute_name)),
                              g_strdup (value));
     }
     else
     {
-        if (file->details->extension_attributes == NULL)
+        if (cold->extension_attributes == NULL)
         {
-            file->details->extension_attributes =
+            cold->extension_attributes =
                 g_hash_table_new_full (g_direct_hash, g_direct_equal,
                                        NULL,
                                        (GDestroyNotify) g_free);
         }
-        g_hash_table_insert (file->details->extension_attributes,
+        g_hash_table_insert (cold->extension_attributes,
                              GINT_TO_POINTER (g_quark_from_string (attribute_name)),
                              g_strdup (value));
     }
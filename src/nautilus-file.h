@@ -199,6 +199,7 @@ gboolean                nautilus_file_is_in_admin                       (Nautilu
 gboolean                nautilus_file_is_remote                         (NautilusFile                   *file);
 gboolean                nautilus_file_is_other_locations                (NautilusFile                   *file);
 gboolean                nautilus_file_is_starred_location              (NautilusFile                   *file);
+gboolean                nautilus_file_is_starred                        (NautilusFile                   *file);
 gboolean		nautilus_file_is_home				(NautilusFile                   *file);
 GError *                nautilus_file_get_file_info_error               (NautilusFile                   *file);
 gboolean                nautilus_file_get_directory_item_count          (NautilusFile                   *file,
@@ -398,6 +399,8 @@ int                     nautilus_file_compare_for_sort_by_attribute_q   (Nautilu
 									 GQuark                          attribute,
 									 gboolean                        directories_first,
 									 gboolean                        reversed);
+guint                   nautilus_file_hash_for_sort_by_attribute_q      (NautilusFile                   *file,
+									 GQuark                          attribute);
 gboolean                nautilus_file_is_date_sort_attribute_q          (GQuark                          attribute);
 
 int                     nautilus_file_compare_location                  (NautilusFile                    *file_1,
@@ -437,6 +440,7 @@ GdkPaintable *          nautilus_file_get_icon_paintable                (Nautilu
 									 NautilusFileIconFlags           flags);
 
 GList *                 nautilus_file_get_emblem_icons                  (NautilusFile                   *file);
+const char *            nautilus_file_get_emblems_key                   (NautilusFile                   *file);
 
 /* Whether the file should open inside a view */
 gboolean                nautilus_file_opens_in_view                     (NautilusFile                   *file);
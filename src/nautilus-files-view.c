@@ -46,6 +46,7 @@
 #include "nautilus-batch-rename-dialog.h"
 #include "nautilus-batch-rename-utilities.h"
 #include "nautilus-clipboard.h"
+#include "nautilus-column-utilities.h"
 #include "nautilus-compress-dialog.h"
 #include "nautilus-dbus-launcher.h"
 #include "nautilus-directory.h"
@@ -85,16 +86,13 @@
 #include "nautilus-window.h"
 #include "nautilus-tracker-utilities.h"
 
-/* Minimum starting update inverval */
-#define UPDATE_INTERVAL_MIN 100
-/* Maximum update interval */
-#define UPDATE_INTERVAL_MAX 2000
-/* Amount of miliseconds the update interval is increased */
-#define UPDATE_INTERVAL_INC 250
-/* Interval at which the update interval is increased */
-#define UPDATE_INTERVAL_TIMEOUT_INTERVAL 250
-/* Milliseconds that have to pass without a change to reset the update interval */
-#define UPDATE_INTERVAL_RESET 1000
+/* How long telling the view about changed files may take in a frame, the
+ * remaining changes are handled in the next frames */
+#define PENDING_CHANGES_FRAME_BUDGET_USEC 4000
+/* How often changes that moved files in the sort order may resort the view */
+#define RESORT_INTERVAL_MSEC 250
+/* Delay of the update of the menus after a change */
+#define UPDATE_CONTEXT_MENUS_INTERVAL 100
 
 #define SILENT_WINDOW_OPEN_LIMIT 5
 
@@ -184,11 +182,12 @@ typedef struct
     guint search_transition_timeout_id;
     gboolean begin_loading_delayed;
 
-    guint display_pending_source_id;
-    guint changes_timeout_id;
+    guint display_pending_tick_id;
+    guint display_pending_idle_id;
 
-    guint update_interval;
-    guint64 last_queued;
+    /* Changed files may have to move in the sort order */
+    gboolean needs_resort;
+    guint resort_timeout_id;
 
     gulong files_added_handler_id;
     gulong files_changed_handler_id;
@@ -199,6 +198,8 @@ typedef struct
     /* Containers with FileAndDirectory* elements */
     GList *new_added_files;
     GList *new_changed_files;
+    /* The FileAndDirectory* of new_changed_files, each one being there once */
+    GHashTable *pending_changed_files;
 
     GList *pending_selection;
     GHashTable *pending_reveal;
@@ -299,8 +300,7 @@ static void     schedule_update_context_menus (NautilusFilesView *view);
 static void     remove_update_context_menus_timeout_callback (NautilusFilesView *view);
 static void     schedule_update_status (NautilusFilesView *view);
 static void     remove_update_status_idle_callback (NautilusFilesView *view);
-static void     reset_update_interval (NautilusFilesView *view);
-static void     schedule_idle_display_of_pending_files (NautilusFilesView *view);
+static void     schedule_display_of_pending_files (NautilusFilesView *view);
 static void     unschedule_display_of_pending_files (NautilusFilesView *view);
 static void     disconnect_directory_handlers (NautilusFilesView *view);
 static void     metadata_for_directory_as_file_ready_callback (NautilusFile *file,
@@ -349,14 +349,14 @@ G_DEFINE_TYPE_WITH_CODE (NautilusFilesView,
                          G_IMPLEMENT_INTERFACE (NAUTILUS_TYPE_VIEW, nautilus_files_view_iface_init)
                          G_ADD_PRIVATE (NautilusFilesView));
 
-static inline NautilusViewItem *
-get_view_item (GListModel *model,
+static inline NautilusFile *
+get_view_file (GListModel *model,
                guint       position)
 {
     g_autoptr (GtkTreeListRow) row = g_list_model_get_item (model, position);
 
     g_return_val_if_fail (GTK_IS_TREE_LIST_ROW (row), NULL);
-    return NAUTILUS_VIEW_ITEM (gtk_tree_list_row_get_item (row));
+    return NAUTILUS_FILE (gtk_tree_list_row_get_item (row));
 }
 
 /*
@@ -599,6 +599,8 @@ escape_underscores (const char *to_escape)
     return g_string_free_and_steal (string);
 }
 
+static void update_directory_monitors (NautilusFilesView *view);
+
 static void
 on_sort_action_state_changed (GActionGroup *action_group,
                               gchar        *action_name,
@@ -619,6 +621,8 @@ on_sort_action_state_changed (GActionGroup *action_group,
     nautilus_file_set_boolean_metadata (priv->directory_as_file,
                                         NAUTILUS_METADATA_KEY_ICON_VIEW_SORT_REVERSED,
                                         reversed);
+
+    update_directory_monitors (self);
 }
 
 static const char *
@@ -811,9 +815,9 @@ nautilus_files_view_call_set_selection (NautilusFilesView *self,
     n_items = g_list_model_get_n_items (G_LIST_MODEL (priv->model));
     for (guint position = 0; position < n_items; position++)
     {
-        g_autoptr (NautilusViewItem) item = get_view_item (G_LIST_MODEL (priv->model), position);
+        g_autoptr (NautilusFile) file = get_view_file (G_LIST_MODEL (priv->model), position);
 
-        GList *link = g_list_find (files_to_find, nautilus_view_item_get_file (item));
+        GList *link = g_list_find (files_to_find, file);
         if (link != NULL)
         {
             /* Found item to select */
@@ -888,7 +892,6 @@ get_selection_internal (NautilusFilesView *self,
          gtk_bitset_iter_previous (&iter, &i))
     {
         g_autoptr (GtkTreeListRow) row = NULL;
-        g_autoptr (NautilusViewItem) item = NULL;
         NautilusFile *file;
 
         row = GTK_TREE_LIST_ROW (g_list_model_get_item (G_LIST_MODEL (priv->model), i));
@@ -900,10 +903,10 @@ get_selection_internal (NautilusFilesView *self,
             continue;
         }
 
-        item = NAUTILUS_VIEW_ITEM (gtk_tree_list_row_get_item (row));
-        file = nautilus_view_item_get_file (item);
+        /* The row holds the file, no need to make its item */
+        file = NAUTILUS_FILE (gtk_tree_list_row_get_item (row));
 
-        selected_files = g_list_prepend (selected_files, g_object_ref (file));
+        selected_files = g_list_prepend (selected_files, file);
     }
 
     return selected_files;
@@ -1180,6 +1183,24 @@ file_and_directory_free (gpointer data)
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (FileAndDirectory, file_and_directory_free)
 
+static guint
+file_and_directory_hash (gconstpointer data)
+{
+    const FileAndDirectory *fad = data;
+
+    return g_direct_hash (fad->file) ^ g_direct_hash (fad->directory);
+}
+
+static gboolean
+file_and_directory_equal (gconstpointer a,
+                          gconstpointer b)
+{
+    const FileAndDirectory *fad_a = a;
+    const FileAndDirectory *fad_b = b;
+
+    return fad_a->file == fad_b->file && fad_a->directory == fad_b->directory;
+}
+
 static ScriptLaunchParameters *
 script_launch_parameters_new (NautilusFile      *file,
                               NautilusFilesView *directory_view)
@@ -3414,6 +3435,7 @@ nautilus_files_view_dispose (GObject *object)
     remove_update_status_idle_callback (view);
 
     g_clear_handle_id (&priv->search_transition_timeout_id, g_source_remove);
+    g_clear_handle_id (&priv->resort_timeout_id, g_source_remove);
 
     if (priv->display_selection_idle_id != 0)
     {
@@ -3491,6 +3513,7 @@ nautilus_files_view_finalize (GObject *object)
     g_free (priv->toolbar_menu_sections);
 
     g_hash_table_destroy (priv->pending_reveal);
+    g_hash_table_destroy (priv->pending_changed_files);
 
     g_clear_object (&priv->clipboard_cancellable);
 
@@ -3897,7 +3920,6 @@ done_loading (NautilusFilesView *view,
         schedule_update_context_menus (view);
         schedule_update_status (view);
         nautilus_files_view_update_toolbar_menus (view);
-        reset_update_interval (view);
 
         if (nautilus_view_is_searching (NAUTILUS_VIEW (view)) &&
             all_files_seen && no_selection && priv->pending_selection == NULL)
@@ -4174,6 +4196,135 @@ still_should_show_file (NautilusFilesView *view,
            view_file_still_belongs (view, fad);
 }
 
+static gboolean
+resort_timeout_callback (gpointer user_data)
+{
+    NautilusFilesView *view = NAUTILUS_FILES_VIEW (user_data);
+    NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (view);
+
+    if (!priv->needs_resort)
+    {
+        priv->resort_timeout_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    priv->needs_resort = FALSE;
+    nautilus_view_model_sort (priv->model);
+
+    return G_SOURCE_CONTINUE;
+}
+
+/* Added files are inserted in order by the model, but changed files have
+ * to be moved by resorting it all. A stream of changes, as while copying
+ * into the directory, resorts at most every RESORT_INTERVAL_MSEC. */
+static void
+resort_changed_files (NautilusFilesView *view)
+{
+    NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (view);
+
+    if (!priv->needs_resort || priv->resort_timeout_id != 0)
+    {
+        return;
+    }
+
+    priv->needs_resort = FALSE;
+    nautilus_view_model_sort (priv->model);
+
+    priv->resort_timeout_id = g_timeout_add (RESORT_INTERVAL_MSEC,
+                                             resort_timeout_callback, view);
+}
+
+static GQuark
+get_sort_attribute (NautilusFilesView *view)
+{
+    NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (view);
+    g_autoptr (GVariant) state = NULL;
+    const char *attribute;
+
+    state = g_action_group_get_action_state (priv->view_action_group, "sort");
+    g_variant_get (state, "(&sb)", &attribute, NULL);
+
+    return g_quark_from_string (attribute);
+}
+
+/* Monitor the things needed to get the right icon. Also monitor a
+ * directory's item count because the "size" attribute is based on that,
+ * and the file's metadata and possible custom name.
+ *
+ * Thumbnails and extension info are expensive, so the cells load them only
+ * for the files on screen, see nautilus_view_cell_set_mapped_attributes().
+ * Sorting by a column of an extension needs its info for all the files
+ * though, or they would be sorted as they come into view. */
+static NautilusFileAttributes
+get_directory_monitor_attributes (NautilusFilesView *view)
+{
+    NautilusFileAttributes attributes;
+
+    attributes =
+        NAUTILUS_FILE_ATTRIBUTE_DIRECTORY_ITEM_COUNT |
+        NAUTILUS_FILE_ATTRIBUTE_INFO |
+        NAUTILUS_FILE_ATTRIBUTE_MOUNT;
+
+    if (nautilus_column_is_from_extension (g_quark_to_string (get_sort_attribute (view))))
+    {
+        attributes |= NAUTILUS_FILE_ATTRIBUTE_EXTENSION_INFO;
+    }
+
+    return attributes;
+}
+
+static NautilusFileAttributes
+get_subdirectory_monitor_attributes (NautilusFilesView *view)
+{
+    return get_directory_monitor_attributes (view) | NAUTILUS_FILE_ATTRIBUTE_EXTRA_INFO;
+}
+
+/* Replaces the monitors of the view, for the attributes they need to change */
+static void
+update_directory_monitors (NautilusFilesView *view)
+{
+    NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (view);
+
+    if (priv->files_added_handler_id != 0)
+    {
+        nautilus_directory_file_monitor_add (priv->directory,
+                                             &priv->directory,
+                                             priv->show_hidden_files,
+                                             get_directory_monitor_attributes (view),
+                                             NULL, NULL);
+    }
+
+    for (GList *l = priv->subdirectory_list; l != NULL; l = l->next)
+    {
+        nautilus_directory_file_monitor_add (l->data,
+                                             &priv->directory,
+                                             priv->show_hidden_files,
+                                             get_subdirectory_monitor_attributes (view),
+                                             NULL, NULL);
+    }
+}
+
+static void
+update_sort_hash (NautilusFilesView *view,
+                  NautilusFile      *file,
+                  GQuark             sort_attribute)
+{
+    NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (view);
+    guint sort_hash;
+
+    if (!nautilus_view_model_has_file (priv->model, file))
+    {
+        return;
+    }
+
+    sort_hash = nautilus_file_hash_for_sort_by_attribute_q (file, sort_attribute);
+    if (sort_hash != nautilus_view_model_get_sort_hash (priv->model, file))
+    {
+        nautilus_view_model_set_sort_hash (priv->model, file, sort_hash);
+        priv->needs_resort = TRUE;
+    }
+}
+
 static void
 real_end_file_changes (NautilusFilesView *view)
 {
@@ -4181,7 +4332,7 @@ real_end_file_changes (NautilusFilesView *view)
 
     priv = nautilus_files_view_get_instance_private (view);
 
-    nautilus_view_model_sort (priv->model);
+    resort_changed_files (view);
 
     /* Addition and removal of files modify the empty state */
     nautilus_files_view_check_empty_states (view);
@@ -4269,10 +4420,15 @@ real_add_files (NautilusFilesView *self,
                 GList             *files)
 {
     NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (self);
-    g_autolist (NautilusViewItem) items = NULL;
+    GQuark sort_attribute = get_sort_attribute (self);
 
-    items = g_list_copy_deep (files, (GCopyFunc) nautilus_view_item_new, NULL);
-    nautilus_view_model_add_items (priv->model, items);
+    /* The model makes the view items on demand, for the rows on screen. */
+    nautilus_view_model_add_files (priv->model, files);
+    for (GList *l = files; l != NULL; l = l->next)
+    {
+        nautilus_view_model_set_sort_hash (priv->model, l->data,
+                                           nautilus_file_hash_for_sort_by_attribute_q (l->data, sort_attribute));
+    }
 }
 
 static void
@@ -4281,22 +4437,19 @@ real_remove_files (NautilusFilesView *self,
                    NautilusDirectory *directory)
 {
     NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (self);
-    g_autoptr (GList) items = NULL;
+    g_autoptr (GList) model_files = NULL;
 
     for (GList *l = files; l != NULL; l = l->next)
     {
-        NautilusViewItem *item;
-
-        item = nautilus_view_model_get_item_for_file (priv->model, l->data);
-        if (item != NULL)
+        if (nautilus_view_model_has_file (priv->model, l->data))
         {
-            items = g_list_prepend (items, item);
+            model_files = g_list_prepend (model_files, l->data);
         }
     }
 
-    if (items != NULL)
+    if (model_files != NULL)
     {
-        nautilus_view_model_remove_items (priv->model, items, directory);
+        nautilus_view_model_remove_files (priv->model, model_files, directory);
     }
 }
 
@@ -4322,7 +4475,7 @@ real_file_changed (NautilusFilesView *self,
     {
         nautilus_view_item_file_changed (item);
     }
-    else
+    else if (!nautilus_view_model_has_file (priv->model, file))
     {
         /* When a file that was hidden is not hidden anymore (e.g. undoing the
          * rename operation which made it hidden), we get a change notification
@@ -4331,6 +4484,26 @@ real_file_changed (NautilusFilesView *self,
     }
 }
 
+/* Cells update from their file when they are bound to it, so the files of
+ * the items which are not shown can be left alone until they are. */
+static gboolean
+file_change_is_shown (NautilusFilesView *view,
+                      NautilusFile      *file)
+{
+    NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (view);
+    NautilusViewItem *item;
+
+    /* Files which are not in the model yet are added by the change */
+    if (!nautilus_view_model_has_file (priv->model, file))
+    {
+        return TRUE;
+    }
+
+    item = nautilus_view_model_get_item_for_file (priv->model, file);
+
+    return item != NULL && nautilus_view_item_get_item_ui (item) != NULL;
+}
+
 static void
 process_pending_files (NautilusFilesView *view)
 {
@@ -4340,11 +4513,14 @@ process_pending_files (NautilusFilesView *view)
     FileAndDirectory *pending;
     GList *files;
     g_autoptr (GList) pending_additions = NULL;
+    gint64 deadline;
+    GQuark sort_attribute;
 
     priv = nautilus_files_view_get_instance_private (view);
     files_added = g_steal_pointer (&priv->new_added_files);
     files_changed = g_steal_pointer (&priv->new_changed_files);
-
+    deadline = g_get_monotonic_time () + PENDING_CHANGES_FRAME_BUDGET_USEC;
+    sort_attribute = get_sort_attribute (view);
 
     if (files_added != NULL || files_changed != NULL)
     {
@@ -4394,12 +4570,29 @@ process_pending_files (NautilusFilesView *view)
         for (GList *node = files_changed; node != NULL; node = node->next)
         {
             gboolean should_show_file;
+
+            /* Leave the remaining changes for the next frame */
+            if (node != files_changed && g_get_monotonic_time () > deadline)
+            {
+                node->prev->next = NULL;
+                node->prev = NULL;
+                priv->new_changed_files = g_list_concat (priv->new_changed_files, node);
+                break;
+            }
+
             pending = node->data;
+            g_hash_table_remove (priv->pending_changed_files, pending);
             should_show_file = still_should_show_file (view, pending);
             if (should_show_file)
             {
-                g_signal_emit (view,
-                               signals[FILE_CHANGED], 0, pending->file, pending->directory);
+                /* Even the files which aren't shown may have to move */
+                update_sort_hash (view, pending->file, sort_attribute);
+
+                if (file_change_is_shown (view, pending->file))
+                {
+                    g_signal_emit (view,
+                                   signals[FILE_CHANGED], 0, pending->file, pending->directory);
+                }
             }
             else
             {
@@ -4483,6 +4676,7 @@ display_pending_files (NautilusFilesView *view)
     }
 
     if (priv->model != NULL
+        && priv->new_changed_files == NULL
         && nautilus_directory_are_all_files_seen (priv->directory))
     {
         done_loading (view, TRUE);
@@ -4555,59 +4749,72 @@ update_context_menus_timeout_callback (gpointer data)
 }
 
 static gboolean
-display_pending_callback (gpointer data)
+display_pending_tick (GtkWidget     *widget,
+                      GdkFrameClock *frame_clock,
+                      gpointer       user_data)
 {
-    NautilusFilesView *view;
-    NautilusFilesViewPrivate *priv;
-
-    view = NAUTILUS_FILES_VIEW (data);
-    priv = nautilus_files_view_get_instance_private (view);
+    NautilusFilesView *view = NAUTILUS_FILES_VIEW (widget);
+    NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (view);
 
     g_object_ref (G_OBJECT (view));
 
-    priv->display_pending_source_id = 0;
-
     display_pending_files (view);
 
+    if (priv->new_changed_files == NULL)
+    {
+        priv->display_pending_tick_id = 0;
+    }
+
     g_object_unref (G_OBJECT (view));
 
-    return FALSE;
+    return priv->display_pending_tick_id != 0 ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
 }
 
-static void
-schedule_idle_display_of_pending_files (NautilusFilesView *view)
+static gboolean
+display_pending_idle (gpointer user_data)
 {
-    NautilusFilesViewPrivate *priv;
+    NautilusFilesView *view = NAUTILUS_FILES_VIEW (user_data);
+    NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (view);
 
-    priv = nautilus_files_view_get_instance_private (view);
+    g_object_ref (G_OBJECT (view));
 
-    /* Get rid of a pending source as it might be a timeout */
-    unschedule_display_of_pending_files (view);
+    display_pending_files (view);
+
+    if (priv->new_changed_files == NULL)
+    {
+        priv->display_pending_idle_id = 0;
+    }
+
+    g_object_unref (G_OBJECT (view));
 
-    /* We want higher priority than the idle that handles the relayout
-     *  to avoid a resort on each add. But we still want to allow repaints
-     *  and other hight prio events while we have pending files to show. */
-    priv->display_pending_source_id =
-        g_idle_add_full (G_PRIORITY_DEFAULT_IDLE - 20,
-                         display_pending_callback, view, NULL);
+    return priv->display_pending_idle_id != 0 ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
 }
 
+/* Pending files are shown at the next frame, at most a frame budget of them
+ * per frame, so that a stream of changes doesn't make the view stutter.
+ * Unmapped views get no frames, so they catch up from an idle instead. */
 static void
-schedule_timeout_display_of_pending_files (NautilusFilesView *view,
-                                           guint              interval)
+schedule_display_of_pending_files (NautilusFilesView *view)
 {
     NautilusFilesViewPrivate *priv;
 
     priv = nautilus_files_view_get_instance_private (view);
 
     /* No need to schedule an update if there's already one pending. */
-    if (priv->display_pending_source_id != 0)
+    if (priv->display_pending_tick_id != 0 || priv->display_pending_idle_id != 0)
     {
         return;
     }
 
-    priv->display_pending_source_id =
-        g_timeout_add (interval, display_pending_callback, view);
+    if (gtk_widget_get_mapped (GTK_WIDGET (view)))
+    {
+        priv->display_pending_tick_id =
+            gtk_widget_add_tick_callback (GTK_WIDGET (view), display_pending_tick, NULL, NULL);
+    }
+    else
+    {
+        priv->display_pending_idle_id = g_idle_add (display_pending_idle, view);
+    }
 }
 
 static void
@@ -4617,11 +4824,26 @@ unschedule_display_of_pending_files (NautilusFilesView *view)
 
     priv = nautilus_files_view_get_instance_private (view);
 
-    /* Get rid of source if it's active. */
-    if (priv->display_pending_source_id != 0)
+    /* Get rid of the tick callback if it's active. */
+    if (priv->display_pending_tick_id != 0)
     {
-        g_source_remove (priv->display_pending_source_id);
-        priv->display_pending_source_id = 0;
+        gtk_widget_remove_tick_callback (GTK_WIDGET (view), priv->display_pending_tick_id);
+        priv->display_pending_tick_id = 0;
+    }
+
+    g_clear_handle_id (&priv->display_pending_idle_id, g_source_remove);
+}
+
+static void
+on_unmap (NautilusFilesView *view)
+{
+    NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (view);
+
+    /* The tick callback won't run anymore, so move the pending update to an idle. */
+    if (priv->display_pending_tick_id != 0)
+    {
+        unschedule_display_of_pending_files (view);
+        schedule_display_of_pending_files (view);
     }
 }
 
@@ -4652,97 +4874,8 @@ queue_pending_files (NautilusFilesView  *view,
         (nautilus_directory_are_all_files_seen (directory) ||
          nautilus_view_is_searching (NAUTILUS_VIEW (view))))
     {
-        schedule_timeout_display_of_pending_files (view, priv->update_interval);
-    }
-}
-
-static void
-remove_changes_timeout_callback (NautilusFilesView *view)
-{
-    NautilusFilesViewPrivate *priv;
-
-    priv = nautilus_files_view_get_instance_private (view);
-
-    if (priv->changes_timeout_id != 0)
-    {
-        g_source_remove (priv->changes_timeout_id);
-        priv->changes_timeout_id = 0;
-    }
-}
-
-static void
-reset_update_interval (NautilusFilesView *view)
-{
-    NautilusFilesViewPrivate *priv;
-
-    priv = nautilus_files_view_get_instance_private (view);
-
-    priv->update_interval = UPDATE_INTERVAL_MIN;
-    remove_changes_timeout_callback (view);
-    /* Reschedule a pending timeout to idle */
-    if (priv->display_pending_source_id != 0)
-    {
-        schedule_idle_display_of_pending_files (view);
-    }
-}
-
-static gboolean
-changes_timeout_callback (gpointer data)
-{
-    gint64 now;
-    gint64 time_delta;
-    gboolean ret;
-    NautilusFilesView *view;
-    NautilusFilesViewPrivate *priv;
-
-    view = NAUTILUS_FILES_VIEW (data);
-    priv = nautilus_files_view_get_instance_private (view);
-
-    g_object_ref (G_OBJECT (view));
-
-    now = g_get_monotonic_time ();
-    time_delta = now - priv->last_queued;
-
-    if (time_delta < UPDATE_INTERVAL_RESET * 1000)
-    {
-        if (priv->update_interval < UPDATE_INTERVAL_MAX &&
-            priv->loading)
-        {
-            /* Increase */
-            priv->update_interval += UPDATE_INTERVAL_INC;
-        }
-        ret = TRUE;
-    }
-    else
-    {
-        /* Reset */
-        reset_update_interval (view);
-        ret = FALSE;
-    }
-
-    g_object_unref (G_OBJECT (view));
-
-    return ret;
-}
-
-static void
-schedule_changes (NautilusFilesView *view)
-{
-    NautilusFilesViewPrivate *priv;
-
-    priv = nautilus_files_view_get_instance_private (view);
-    /* Remember when the change was queued */
-    priv->last_queued = g_get_monotonic_time ();
-
-    /* No need to schedule if there are already changes pending or during loading */
-    if (priv->changes_timeout_id != 0 ||
-        priv->loading)
-    {
-        return;
+        schedule_display_of_pending_files (view);
     }
-
-    priv->changes_timeout_id =
-        g_timeout_add (UPDATE_INTERVAL_TIMEOUT_INTERVAL, changes_timeout_callback, view);
 }
 
 static void
@@ -4766,8 +4899,6 @@ files_added_callback (NautilusDirectory *directory,
 
     g_free (uri);
 
-    schedule_changes (view);
-
     queue_pending_files (view, directory, files, &priv->new_added_files);
 
     /* The number of items could have changed */
@@ -4783,6 +4914,7 @@ files_changed_callback (NautilusDirectory *directory,
     NautilusFilesView *view;
     GtkWindow *window;
     char *uri;
+    g_autoptr (GList) new_changes = NULL;
 
     view = NAUTILUS_FILES_VIEW (callback_data);
     priv = nautilus_files_view_get_instance_private (view);
@@ -4794,9 +4926,22 @@ files_changed_callback (NautilusDirectory *directory,
 
     g_free (uri);
 
-    schedule_changes (view);
+    /* A file changing several times before the view is updated only needs
+     * to be updated once. */
+    for (GList *l = files; l != NULL; l = l->next)
+    {
+        FileAndDirectory key = { .file = l->data, .directory = directory };
+
+        if (!g_hash_table_contains (priv->pending_changed_files, &key))
+        {
+            g_hash_table_add (priv->pending_changed_files,
+                              file_and_directory_new (l->data, directory));
+            new_changes = g_list_prepend (new_changes, l->data);
+        }
+    }
+    new_changes = g_list_reverse (new_changes);
 
-    queue_pending_files (view, directory, files, &priv->new_changed_files);
+    queue_pending_files (view, directory, new_changes, &priv->new_changed_files);
 
     /* The free space or the number of items could have changed */
     schedule_update_status (view);
@@ -4815,12 +4960,7 @@ done_loading_callback (NautilusDirectory *directory,
 
     view = NAUTILUS_FILES_VIEW (callback_data);
 
-    /* Unschedule a pending update and schedule a new one with the minimal
-     * update interval. This gives the view a short chance at gathering the
-     * (cached) deep counts.
-     */
-    unschedule_display_of_pending_files (view);
-    schedule_timeout_display_of_pending_files (view, UPDATE_INTERVAL_MIN);
+    schedule_display_of_pending_files (view);
 
     remove_loading_floating_bar (view);
 }
@@ -4860,40 +5000,27 @@ subdirectory_done_loading (NautilusDirectory *directory,
     NautilusFilesView *view = user_data;
     NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (view);
     g_autoptr (NautilusFile) file = nautilus_directory_get_corresponding_file (directory);
-    NautilusViewItem *item = nautilus_view_model_get_item_for_file (priv->model, file);
 
     priv->subdirectories_loading = g_list_remove (priv->subdirectories_loading, directory);
 
-    if (item != NULL)
-    {
-        nautilus_view_item_set_loading (item, FALSE);
-    }
+    nautilus_view_model_set_loading (priv->model, file, FALSE);
 }
 
 void
 nautilus_files_view_add_subdirectory (NautilusFilesView *view,
                                       NautilusDirectory *directory)
 {
-    NautilusFileAttributes attributes;
     NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (view);
     g_autoptr (NautilusFile) file = nautilus_directory_get_corresponding_file (directory);
-    NautilusViewItem *item = nautilus_view_model_get_item_for_file (priv->model, file);
 
     g_return_if_fail (!g_list_find (priv->subdirectory_list, directory));
 
     nautilus_directory_ref (directory);
 
-    attributes =
-        NAUTILUS_FILE_ATTRIBUTES_FOR_ICON |
-        NAUTILUS_FILE_ATTRIBUTE_DIRECTORY_ITEM_COUNT |
-        NAUTILUS_FILE_ATTRIBUTE_INFO |
-        NAUTILUS_FILE_ATTRIBUTE_MOUNT |
-        NAUTILUS_FILE_ATTRIBUTE_EXTENSION_INFO;
-
     nautilus_directory_file_monitor_add (directory,
                                          &priv->directory,
                                          priv->show_hidden_files,
-                                         attributes,
+                                         get_subdirectory_monitor_attributes (view),
                                          files_added_callback, view);
 
     g_signal_connect
@@ -4909,10 +5036,10 @@ nautilus_files_view_add_subdirectory (NautilusFilesView *view,
     priv->subdirectory_list = g_list_prepend (priv->subdirectory_list, directory);
     priv->subdirectories_loading = g_list_prepend (priv->subdirectories_loading, directory);
 
-    if (item != NULL &&
+    if (nautilus_view_model_has_file (priv->model, file) &&
         !nautilus_directory_are_all_files_seen (directory))
     {
-        nautilus_view_item_set_loading (item, TRUE);
+        nautilus_view_model_set_loading (priv->model, file, TRUE);
     }
 }
 
@@ -4922,19 +5049,18 @@ nautilus_files_view_remove_subdirectory (NautilusFilesView *view,
 {
     NautilusFilesViewPrivate *priv = nautilus_files_view_get_instance_private (view);
     g_autoptr (NautilusFile) file = nautilus_directory_get_corresponding_file (directory);
-    NautilusViewItem *item = nautilus_view_model_get_item_for_file (priv->model, file);
 
     g_return_if_fail (g_list_find (priv->subdirectory_list, directory));
 
     priv->subdirectory_list = g_list_remove (priv->subdirectory_list, directory);
     priv->subdirectories_loading = g_list_remove (priv->subdirectories_loading, directory);
 
-    if (item != NULL)
+    if (nautilus_view_model_has_file (priv->model, file))
     {
-        nautilus_view_item_set_loading (item, FALSE);
+        nautilus_view_model_set_loading (priv->model, file, FALSE);
 
         /* The model holds a GListStore for every subdirectory. Empty it. */
-        nautilus_view_model_clear_subdirectory (priv->model, item);
+        nautilus_view_model_clear_subdirectory (priv->model, file);
     }
 
     g_signal_handlers_disconnect_by_func (directory,
@@ -8505,7 +8631,7 @@ schedule_update_context_menus (NautilusFilesView *view)
     if (priv->update_context_menus_timeout_id == 0)
     {
         priv->update_context_menus_timeout_id
-            = g_timeout_add (priv->update_interval, update_context_menus_timeout_callback, view);
+            = g_timeout_add (UPDATE_CONTEXT_MENUS_INTERVAL, update_context_menus_timeout_callback, view);
     }
 }
 
@@ -8603,8 +8729,6 @@ file_changed_callback (NautilusFile *file,
 {
     NautilusFilesView *view = NAUTILUS_FILES_VIEW (callback_data);
 
-    schedule_changes (view);
-
     schedule_update_context_menus (view);
     schedule_update_status (view);
 }
@@ -8770,6 +8894,7 @@ load_directory (NautilusFilesView *view,
      */
     attributes =
         NAUTILUS_FILE_ATTRIBUTE_INFO |
+        NAUTILUS_FILE_ATTRIBUTE_EXTRA_INFO |
         NAUTILUS_FILE_ATTRIBUTE_MOUNT |
         NAUTILUS_FILE_ATTRIBUTE_FILESYSTEM_INFO;
     priv->metadata_for_directory_as_file_pending = TRUE;
@@ -8802,7 +8927,6 @@ load_directory (NautilusFilesView *view,
 static void
 finish_loading (NautilusFilesView *view)
 {
-    NautilusFileAttributes attributes;
     NautilusFilesViewPrivate *priv;
 
     priv = nautilus_files_view_get_instance_private (view);
@@ -8813,12 +8937,7 @@ finish_loading (NautilusFilesView *view)
 
     if (nautilus_directory_are_all_files_seen (priv->directory))
     {
-        /* Unschedule a pending update and schedule a new one with the minimal
-         * update interval. This gives the view a short chance at gathering the
-         * (cached) deep counts.
-         */
-        unschedule_display_of_pending_files (view);
-        schedule_timeout_display_of_pending_files (view, UPDATE_INTERVAL_MIN);
+        schedule_display_of_pending_files (view);
     }
 
     /* Start loading. */
@@ -8829,18 +8948,6 @@ finish_loading (NautilusFilesView *view)
     priv->load_error_handler_id = g_signal_connect (priv->directory, "load-error",
                                                     G_CALLBACK (load_error_callback), view);
 
-    /* Monitor the things needed to get the right icon. Also
-     * monitor a directory's item count because the "size"
-     * attribute is based on that, and the file's metadata
-     * and possible custom name.
-     */
-    attributes =
-        NAUTILUS_FILE_ATTRIBUTES_FOR_ICON |
-        NAUTILUS_FILE_ATTRIBUTE_DIRECTORY_ITEM_COUNT |
-        NAUTILUS_FILE_ATTRIBUTE_INFO |
-        NAUTILUS_FILE_ATTRIBUTE_MOUNT |
-        NAUTILUS_FILE_ATTRIBUTE_EXTENSION_INFO;
-
     priv->files_added_handler_id = g_signal_connect
                                        (priv->directory, "files-added",
                                        G_CALLBACK (files_added_callback), view);
@@ -8851,9 +8958,12 @@ finish_loading (NautilusFilesView *view)
     nautilus_directory_file_monitor_add (priv->directory,
                                          &priv->directory,
                                          priv->show_hidden_files,
-                                         attributes,
+                                         get_directory_monitor_attributes (view),
                                          files_added_callback, view);
 
+    /* Make going back to it instant */
+    nautilus_directory_keep_loaded (priv->directory);
+
     /* If escaping search we can release the search directory now that the view
      * is now monitoring the base directory directly. */
     g_clear_object (&priv->outgoing_search);
@@ -8957,7 +9067,6 @@ nautilus_files_view_stop_loading (NautilusFilesView *view)
     priv = nautilus_files_view_get_instance_private (view);
 
     unschedule_display_of_pending_files (view);
-    reset_update_interval (view);
 
     /* Free extra undisplayed files */
     g_list_free_full (priv->new_added_files, file_and_directory_free);
@@ -8965,6 +9074,8 @@ nautilus_files_view_stop_loading (NautilusFilesView *view)
 
     g_list_free_full (priv->new_changed_files, file_and_directory_free);
     priv->new_changed_files = NULL;
+    g_hash_table_remove_all (priv->pending_changed_files);
+    priv->needs_resort = FALSE;
 
     g_list_free_full (priv->pending_selection, g_object_unref);
     priv->pending_selection = NULL;
@@ -9676,6 +9787,7 @@ nautilus_files_view_init (NautilusFilesView *view)
                       "notify::parent",
                       G_CALLBACK (on_parent_changed),
                       NULL);
+    g_signal_connect (view, "unmap", G_CALLBACK (on_unmap), NULL);
 
     g_object_unref (builder);
 
@@ -9688,6 +9800,10 @@ nautilus_files_view_init (NautilusFilesView *view)
                       view);
 
     priv->pending_reveal = g_hash_table_new (NULL, NULL);
+    priv->pending_changed_files = g_hash_table_new_full (file_and_directory_hash,
+                                                         file_and_directory_equal,
+                                                         file_and_directory_free,
+                                                         NULL);
 
     if (set_up_scripts_directory_global ())
     {
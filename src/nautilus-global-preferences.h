@@ -101,6 +101,7 @@ typedef enum
 #define NAUTILUS_PREFERENCES_SHOW_DIRECTORY_ITEM_COUNTS "show-directory-item-counts"
 #define NAUTILUS_PREFERENCES_SHOW_FILE_THUMBNAILS	"show-image-thumbnails"
 #define NAUTILUS_PREFERENCES_FILE_THUMBNAIL_LIMIT	"thumbnail-limit"
+#define NAUTILUS_PREFERENCES_CACHE_DIRECTORY_LISTINGS	"cache-directory-listings"
 
 typedef enum
 {
@@ -108,6 +109,9 @@ typedef enum
 	NAUTILUS_SIMPLE_SEARCH_BAR
 } NautilusSearchBarMode;
 
+/* File operations */
+#define NAUTILUS_PREFERENCES_FILE_OPERATIONS_PER_DEVICE "file-operations-per-device"
+
 /* Lockdown */
 #define NAUTILUS_PREFERENCES_LOCKDOWN_COMMAND_LINE         "disable-command-line"
 
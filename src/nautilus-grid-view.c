@@ -28,8 +28,9 @@ struct _NautilusGridView
 
 G_DEFINE_TYPE (NautilusGridView, nautilus_grid_view, NAUTILUS_TYPE_LIST_BASE)
 
-#define get_view_item(li) \
-        (NAUTILUS_VIEW_ITEM (gtk_tree_list_row_get_item (GTK_TREE_LIST_ROW (gtk_list_item_get_item (li)))))
+#define get_view_item(self, li) \
+        (nautilus_view_model_get_item_for_row (nautilus_list_base_get_model (NAUTILUS_LIST_BASE (self)), \
+                                               GTK_TREE_LIST_ROW (gtk_list_item_get_item (li))))
 
 static const NautilusViewInfo grid_view_info =
 {
@@ -51,11 +52,8 @@ nautilus_grid_view_sort (gconstpointer a,
                          gpointer      user_data)
 {
     NautilusGridView *self = user_data;
-    NautilusFile *file_a;
-    NautilusFile *file_b;
-
-    file_a = nautilus_view_item_get_file (NAUTILUS_VIEW_ITEM ((gpointer) a));
-    file_b = nautilus_view_item_get_file (NAUTILUS_VIEW_ITEM ((gpointer) b));
+    NautilusFile *file_a = NAUTILUS_FILE ((gpointer) a);
+    NautilusFile *file_b = NAUTILUS_FILE ((gpointer) b);
 
     return nautilus_file_compare_for_sort_by_attribute_q (file_a, file_b,
                                                           self->sort_attribute,
@@ -406,7 +404,7 @@ bind_cell (GtkSignalListItemFactory *factory,
     g_autoptr (NautilusViewItem) item = NULL;
 
     cell = gtk_list_item_get_child (listitem);
-    item = get_view_item (listitem);
+    item = get_view_item (user_data, listitem);
     g_return_if_fail (item != NULL);
 
     nautilus_view_item_set_item_ui (item, cell);
@@ -431,7 +429,7 @@ unbind_cell (GtkSignalListItemFactory *factory,
 {
     g_autoptr (NautilusViewItem) item = NULL;
 
-    item = get_view_item (listitem);
+    item = get_view_item (user_data, listitem);
 
     /* item may be NULL when row has just been destroyed. */
     if (item != NULL)
@@ -24,22 +24,31 @@ struct _NautilusIconInfo
     GObject parent;
 
     gboolean sole_owner;
-    guint64 last_use_time;
     GdkPaintable *paintable;
 
     char *icon_name;
+
+    /* Set while in one of the caches */
+    GHashTable *cache; /* Unowned */
+    gconstpointer cache_key; /* Owned by cache */
+    GList *cache_link;
+    gsize cost;
 };
 
-static void schedule_reap_cache (void);
+/* How much memory the icons in the caches which aren't used elsewhere may
+ * take, as estimated by get_icon_cost() */
+#define ICON_CACHE_BUDGET_BYTES (32 * 1024 * 1024)
 
 G_DEFINE_TYPE (NautilusIconInfo,
                nautilus_icon_info,
                G_TYPE_OBJECT);
 
+static void icon_cache_set_unused (NautilusIconInfo *icon,
+                                   gboolean          unused);
+
 static void
 nautilus_icon_info_init (NautilusIconInfo *icon)
 {
-    icon->last_use_time = g_get_monotonic_time ();
     icon->sole_owner = TRUE;
 }
 
@@ -59,11 +68,10 @@ paintable_toggle_notify (gpointer  info,
     if (is_last_ref)
     {
         icon->sole_owner = TRUE;
+        icon_cache_set_unused (icon, TRUE);
         g_object_remove_toggle_ref (object,
                                     paintable_toggle_notify,
                                     info);
-        icon->last_use_time = g_get_monotonic_time ();
-        schedule_reap_cache ();
     }
 }
 
@@ -160,82 +168,129 @@ typedef struct
     int size;
 } ThemedIconKey;
 
+/* The caches only hold icons which can be looked up again cheaply, like
+ * themed icons, or which are used over and over, like the icons of mounts.
+ *
+ * Icons are kept while the views use them, and the least recently looked up
+ * of the unused ones are dropped once they take more than
+ * ICON_CACHE_BUDGET_BYTES, so that returning to a folder shortly after
+ * leaving it finds its icons still loaded.
+ */
 static GHashTable *loadable_icon_cache = NULL;
 static GHashTable *themed_icon_cache = NULL;
-static guint reap_cache_timeout = 0;
-
-#define MICROSEC_PER_SEC ((guint64) 1000000L)
-
-static guint64 time_now;
-
-static gboolean
-reap_old_icon (gpointer key,
-               gpointer value,
-               gpointer user_info)
+/* Of both caches, most recently used first */
+static GQueue icon_lru = G_QUEUE_INIT;
+/* Of the unused icons only */
+static gsize icon_cache_cost = 0;
+static guint icon_cache_trim_id = 0;
+
+static gsize
+get_icon_cost (int size,
+               int scale)
 {
-    NautilusIconInfo *icon = value;
-    gboolean *reapable_icons_left = user_info;
+    /* The texture it is rendered to, in the end */
+    return (gsize) (size * scale) * (gsize) (size * scale) * 4;
+}
 
+static void
+icon_cache_remove (NautilusIconInfo *icon)
+{
+    g_queue_delete_link (&icon_lru, icon->cache_link);
     if (icon->sole_owner)
     {
-        if (time_now - icon->last_use_time > 30 * MICROSEC_PER_SEC)
-        {
-            /* This went unused 30 secs ago. reap */
-            return TRUE;
-        }
-        else
-        {
-            /* We can reap this soon */
-            *reapable_icons_left = TRUE;
-        }
+        icon_cache_cost -= icon->cost;
     }
 
-    return FALSE;
+    icon->cache = NULL;
+    icon->cache_key = NULL;
+    icon->cache_link = NULL;
+
+    g_object_unref (icon);
 }
 
-static gboolean
-reap_cache (gpointer data)
+static void
+icon_cache_trim (void)
 {
-    gboolean reapable_icons_left;
+    GList *link = icon_lru.tail;
 
-    reapable_icons_left = TRUE;
+    /* Icons still in use would not be freed, so keep them. The head is the
+     * icon being looked up, not referenced by its caller yet. */
+    while (icon_cache_cost > ICON_CACHE_BUDGET_BYTES &&
+           link != NULL && link != icon_lru.head)
+    {
+        NautilusIconInfo *icon = link->data;
+        GList *prev = link->prev;
 
-    time_now = g_get_monotonic_time ();
+        if (icon->sole_owner)
+        {
+            g_hash_table_remove (icon->cache, icon->cache_key);
+        }
 
-    if (loadable_icon_cache)
-    {
-        g_hash_table_foreach_remove (loadable_icon_cache,
-                                     reap_old_icon,
-                                     &reapable_icons_left);
+        link = prev;
     }
+}
 
-    if (themed_icon_cache)
+static void
+icon_cache_trim_idle (gpointer user_data)
+{
+    icon_cache_trim_id = 0;
+    icon_cache_trim ();
+}
+
+/* Only the icons which are not used elsewhere count against the budget, as
+ * the others would not be freed by dropping them from the cache. */
+static void
+icon_cache_set_unused (NautilusIconInfo *icon,
+                       gboolean          unused)
+{
+    if (icon->cache == NULL)
     {
-        g_hash_table_foreach_remove (themed_icon_cache,
-                                     reap_old_icon,
-                                     &reapable_icons_left);
+        return;
     }
 
-    if (reapable_icons_left)
+    if (!unused)
     {
-        return TRUE;
+        icon_cache_cost -= icon->cost;
     }
     else
     {
-        reap_cache_timeout = 0;
-        return FALSE;
+        icon_cache_cost += icon->cost;
+
+        /* Not from here, as the paintable is being unreffed */
+        if (icon_cache_cost > ICON_CACHE_BUDGET_BYTES && icon_cache_trim_id == 0)
+        {
+            icon_cache_trim_id = g_idle_add_once (icon_cache_trim_idle, NULL);
+        }
     }
 }
 
 static void
-schedule_reap_cache (void)
+icon_cache_insert (GHashTable       *cache,
+                   gpointer          key,
+                   NautilusIconInfo *icon,
+                   gsize             cost)
 {
-    if (reap_cache_timeout == 0)
+    icon->cache = cache;
+    icon->cache_key = key;
+    icon->cost = cost;
+
+    g_queue_push_head (&icon_lru, icon);
+    icon->cache_link = icon_lru.head;
+    if (icon->sole_owner)
     {
-        reap_cache_timeout = g_timeout_add_seconds_full (0, 5,
-                                                         reap_cache,
-                                                         NULL, NULL);
+        icon_cache_cost += cost;
     }
+
+    g_hash_table_insert (cache, key, icon);
+
+    icon_cache_trim ();
+}
+
+static void
+icon_cache_touch (NautilusIconInfo *icon)
+{
+    g_queue_unlink (&icon_lru, icon->cache_link);
+    g_queue_push_head_link (&icon_lru, icon->cache_link);
 }
 
 void
@@ -326,6 +381,22 @@ themed_icon_key_free (ThemedIconKey *key)
     g_slice_free (ThemedIconKey, key);
 }
 
+/* Draws @texture, made for a display of @scale, at its logical size */
+static GdkPaintable *
+paintable_new_for_texture (GdkTexture *texture,
+                           int         scale)
+{
+    double width = gdk_texture_get_width (texture) / (double) scale;
+    double height = gdk_texture_get_height (texture) / (double) scale;
+    g_autoptr (GtkSnapshot) snapshot = gtk_snapshot_new ();
+
+    gdk_paintable_snapshot (GDK_PAINTABLE (texture),
+                            GDK_SNAPSHOT (snapshot),
+                            width, height);
+
+    return gtk_snapshot_to_paintable (snapshot, NULL);
+}
+
 NautilusIconInfo *
 nautilus_icon_info_lookup (GIcon *icon,
                            int    size,
@@ -348,7 +419,7 @@ nautilus_icon_info_lookup (GIcon *icon,
                 g_hash_table_new_full ((GHashFunc) loadable_icon_key_hash,
                                        (GEqualFunc) loadable_icon_key_equal,
                                        (GDestroyNotify) loadable_icon_key_free,
-                                       (GDestroyNotify) g_object_unref);
+                                       (GDestroyNotify) icon_cache_remove);
         }
 
         lookup_key.icon = icon;
@@ -358,6 +429,7 @@ nautilus_icon_info_lookup (GIcon *icon,
         icon_info = g_hash_table_lookup (loadable_icon_cache, &lookup_key);
         if (icon_info)
         {
+            icon_cache_touch (icon_info);
             return g_object_ref (icon_info);
         }
 
@@ -376,21 +448,15 @@ nautilus_icon_info_lookup (GIcon *icon,
 
         if (pixbuf != NULL)
         {
-            double width = gdk_pixbuf_get_width (pixbuf) / scale;
-            double height = gdk_pixbuf_get_height (pixbuf) / scale;
             g_autoptr (GdkTexture) texture = gdk_texture_new_for_pixbuf (pixbuf);
-            g_autoptr (GtkSnapshot) snapshot = gtk_snapshot_new ();
 
-            gdk_paintable_snapshot (GDK_PAINTABLE (texture),
-                                    GDK_SNAPSHOT (snapshot),
-                                    width, height);
-            paintable = gtk_snapshot_to_paintable (snapshot, NULL);
+            paintable = paintable_new_for_texture (texture, scale);
         }
 
         icon_info = nautilus_icon_info_new_for_paintable (paintable, scale);
 
         key = loadable_icon_key_new (icon, scale, size);
-        g_hash_table_insert (loadable_icon_cache, key, icon_info);
+        icon_cache_insert (loadable_icon_cache, key, icon_info, get_icon_cost (size, scale));
 
         return g_object_ref (icon_info);
     }
@@ -415,7 +481,7 @@ nautilus_icon_info_lookup (GIcon *icon,
                 g_hash_table_new_full ((GHashFunc) themed_icon_key_hash,
                                        (GEqualFunc) themed_icon_key_equal,
                                        (GDestroyNotify) themed_icon_key_free,
-                                       (GDestroyNotify) g_object_unref);
+                                       (GDestroyNotify) icon_cache_remove);
         }
 
         icon_name = gtk_icon_paintable_get_icon_name (icon_paintable);
@@ -425,12 +491,16 @@ nautilus_icon_info_lookup (GIcon *icon,
         lookup_key.size = size;
 
         icon_info = g_hash_table_lookup (themed_icon_cache, &lookup_key);
-        if (!icon_info)
+        if (icon_info)
+        {
+            icon_cache_touch (icon_info);
+        }
+        else
         {
             icon_info = nautilus_icon_info_new_for_icon_paintable (icon_paintable, scale);
 
             key = themed_icon_key_new (icon_name, scale, size);
-            g_hash_table_insert (themed_icon_cache, key, icon_info);
+            icon_cache_insert (themed_icon_cache, key, icon_info, get_icon_cost (size, scale));
         }
 
         return g_object_ref (icon_info);
@@ -457,6 +527,7 @@ nautilus_icon_info_get_paintable_nodefault (NautilusIconInfo *icon)
         if (icon->sole_owner)
         {
             icon->sole_owner = FALSE;
+            icon_cache_set_unused (icon, FALSE);
             g_object_add_toggle_ref (G_OBJECT (res),
                                      paintable_toggle_notify,
                                      icon);
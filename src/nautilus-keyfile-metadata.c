@@ -34,14 +34,25 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
+/* Changes made within this delay are saved together */
+#define SAVE_DELAY_MS 500
+
 typedef struct
 {
     GKeyFile *keyfile;
-    guint save_in_idle_id;
+    guint save_timeout_id;
+    /* A save is running in a thread, and another one is needed after it */
+    gboolean saving;
+    gboolean needs_save;
 } KeyfileMetadataData;
 
 static GHashTable *data_hash = NULL;
 
+/* Lets nautilus_keyfile_metadata_flush() wait for the saves running in threads */
+static GMutex saves_mutex;
+static GCond saves_cond;
+static guint saves_in_flight = 0;
+
 static KeyfileMetadataData *
 keyfile_metadata_data_new (const char *keyfile_filename)
 {
@@ -80,9 +91,9 @@ keyfile_metadata_data_free (KeyfileMetadataData *data)
 {
     g_key_file_unref (data->keyfile);
 
-    if (data->save_in_idle_id != 0)
+    if (data->save_timeout_id != 0)
     {
-        g_source_remove (data->save_in_idle_id);
+        g_source_remove (data->save_timeout_id);
     }
 
     g_slice_free (KeyfileMetadataData, data);
@@ -115,39 +126,123 @@ get_keyfile (const char *keyfile_filename)
     return data->keyfile;
 }
 
+typedef struct
+{
+    char *keyfile_filename;
+    char *contents;
+    gsize length;
+} SaveData;
+
+static void
+save_data_free (SaveData *save_data)
+{
+    g_free (save_data->keyfile_filename);
+    g_free (save_data->contents);
+    g_free (save_data);
+}
+
+static void save_soon (const char *keyfile_filename);
+
+static void
+save_thread (GTask        *task,
+             gpointer      source_object,
+             gpointer      task_data,
+             GCancellable *cancellable)
+{
+    SaveData *save_data = task_data;
+    GError *error = NULL;
+
+    /* Written to a temporary file, then renamed over the old one, so the
+     * file is never left half written */
+    if (g_file_set_contents (save_data->keyfile_filename,
+                             save_data->contents,
+                             save_data->length,
+                             &error))
+    {
+        g_task_return_boolean (task, TRUE);
+    }
+    else
+    {
+        g_task_return_error (task, error);
+    }
+
+    g_mutex_lock (&saves_mutex);
+    saves_in_flight--;
+    g_cond_broadcast (&saves_cond);
+    g_mutex_unlock (&saves_mutex);
+}
+
+static void
+save_callback (GObject      *source_object,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+    SaveData *save_data = g_task_get_task_data (G_TASK (result));
+    const char *keyfile_filename = save_data->keyfile_filename;
+    KeyfileMetadataData *data;
+    g_autoptr (GError) error = NULL;
+
+    if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+        g_warning ("Couldn't save the desktop metadata keyfile to disk: %s",
+                   error->message);
+    }
+
+    data = g_hash_table_lookup (data_hash, keyfile_filename);
+    data->saving = FALSE;
+
+    if (data->needs_save)
+    {
+        data->needs_save = FALSE;
+        save_soon (keyfile_filename);
+    }
+}
+
 static gboolean
-save_in_idle_cb (const gchar *keyfile_filename)
+save_timeout_cb (const gchar *keyfile_filename)
 {
     KeyfileMetadataData *data;
+    g_autoptr (GTask) task = NULL;
+    SaveData *save_data;
     gchar *contents;
     gsize length;
-    GError *error = NULL;
 
     data = g_hash_table_lookup (data_hash, keyfile_filename);
-    data->save_in_idle_id = 0;
-
-    contents = g_key_file_to_data (data->keyfile, &length, NULL);
+    data->save_timeout_id = 0;
 
-    if (contents != NULL)
+    /* Don't let an older save finish after this one */
+    if (data->saving)
     {
-        g_file_set_contents (keyfile_filename,
-                             contents, length,
-                             &error);
-        g_free (contents);
+        data->needs_save = TRUE;
+        return G_SOURCE_REMOVE;
     }
 
-    if (error != NULL)
+    contents = g_key_file_to_data (data->keyfile, &length, NULL);
+    if (contents == NULL)
     {
-        g_warning ("Couldn't save the desktop metadata keyfile to disk: %s",
-                   error->message);
-        g_error_free (error);
+        return G_SOURCE_REMOVE;
     }
 
-    return FALSE;
+    data->saving = TRUE;
+
+    save_data = g_new0 (SaveData, 1);
+    save_data->keyfile_filename = g_strdup (keyfile_filename);
+    save_data->contents = contents;
+    save_data->length = length;
+
+    g_mutex_lock (&saves_mutex);
+    saves_in_flight++;
+    g_mutex_unlock (&saves_mutex);
+
+    task = g_task_new (NULL, NULL, save_callback, NULL);
+    g_task_set_task_data (task, save_data, (GDestroyNotify) save_data_free);
+    g_task_run_in_thread (task, save_thread);
+
+    return G_SOURCE_REMOVE;
 }
 
 static void
-save_in_idle (const char *keyfile_filename)
+save_soon (const char *keyfile_filename)
 {
     KeyfileMetadataData *data;
 
@@ -156,15 +251,67 @@ save_in_idle (const char *keyfile_filename)
     data = g_hash_table_lookup (data_hash, keyfile_filename);
     g_return_if_fail (data != NULL);
 
-    if (data->save_in_idle_id != 0)
+    if (data->save_timeout_id != 0)
+    {
+        return;
+    }
+
+    data->save_timeout_id = g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE,
+                                                SAVE_DELAY_MS,
+                                                (GSourceFunc) save_timeout_cb,
+                                                g_strdup (keyfile_filename),
+                                                g_free);
+}
+
+/**
+ * nautilus_keyfile_metadata_flush:
+ *
+ * Saves the changes which are still waiting for their delay, after waiting
+ * for the saves already running. To be called before exiting.
+ */
+void
+nautilus_keyfile_metadata_flush (void)
+{
+    GHashTableIter iter;
+    const char *keyfile_filename;
+    KeyfileMetadataData *data;
+
+    if (data_hash == NULL)
     {
         return;
     }
 
-    data->save_in_idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
-                                             (GSourceFunc) save_in_idle_cb,
-                                             g_strdup (keyfile_filename),
-                                             g_free);
+    /* A running save must not finish after the newer one done here */
+    g_mutex_lock (&saves_mutex);
+    while (saves_in_flight > 0)
+    {
+        g_cond_wait (&saves_cond, &saves_mutex);
+    }
+    g_mutex_unlock (&saves_mutex);
+
+    g_hash_table_iter_init (&iter, data_hash);
+    while (g_hash_table_iter_next (&iter, (gpointer *) &keyfile_filename, (gpointer *) &data))
+    {
+        g_autofree gchar *contents = NULL;
+        gsize length;
+        g_autoptr (GError) error = NULL;
+
+        if (data->save_timeout_id == 0 && !data->needs_save)
+        {
+            continue;
+        }
+
+        g_clear_handle_id (&data->save_timeout_id, g_source_remove);
+        data->needs_save = FALSE;
+
+        contents = g_key_file_to_data (data->keyfile, &length, NULL);
+        if (contents != NULL &&
+            !g_file_set_contents (keyfile_filename, contents, length, &error))
+        {
+            g_warning ("Couldn't save the desktop metadata keyfile to disk: %s",
+                       error->message);
+        }
+    }
 }
 
 void
@@ -175,6 +322,8 @@ nautilus_keyfile_metadata_set_string (NautilusFile *file,
                                       const gchar  *string)
 {
     GKeyFile *keyfile;
+    g_autoptr (GFileInfo) info = g_file_info_new ();
+    g_autofree gchar *gio_key = g_strconcat ("metadata::", key, NULL);
 
     keyfile = get_keyfile (keyfile_filename);
 
@@ -183,9 +332,11 @@ nautilus_keyfile_metadata_set_string (NautilusFile *file,
                            key,
                            string);
 
-    save_in_idle (keyfile_filename);
+    save_soon (keyfile_filename);
 
-    if (nautilus_keyfile_metadata_update_from_keyfile (file, keyfile_filename, name))
+    /* Only the key which changed needs to be updated */
+    g_file_info_set_attribute_string (info, gio_key, string);
+    if (nautilus_file_merge_metadata_from_info (file, info))
     {
         nautilus_file_changed (file);
     }
@@ -204,6 +355,8 @@ nautilus_keyfile_metadata_set_stringv (NautilusFile       *file,
     guint length;
     gchar **actual_stringv = NULL;
     gboolean free_strv = FALSE;
+    g_autoptr (GFileInfo) info = g_file_info_new ();
+    g_autofree gchar *gio_key = g_strconcat ("metadata::", key, NULL);
 
     keyfile = get_keyfile (keyfile_filename);
 
@@ -234,9 +387,18 @@ nautilus_keyfile_metadata_set_stringv (NautilusFile       *file,
                                 (const gchar **) actual_stringv,
                                 length);
 
-    save_in_idle (keyfile_filename);
+    save_soon (keyfile_filename);
 
-    if (nautilus_keyfile_metadata_update_from_keyfile (file, keyfile_filename, name))
+    /* Empty lists are skipped when the keyfile is read, so unset the key */
+    if (stringv[0] == NULL)
+    {
+        g_file_info_set_attribute (info, gio_key, G_FILE_ATTRIBUTE_TYPE_INVALID, NULL);
+    }
+    else
+    {
+        g_file_info_set_attribute_stringv (info, gio_key, (gchar **) stringv);
+    }
+    if (nautilus_file_merge_metadata_from_info (file, info))
     {
         nautilus_file_changed (file);
     }
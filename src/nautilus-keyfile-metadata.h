@@ -38,6 +38,8 @@ void nautilus_keyfile_metadata_set_stringv (NautilusFile *file,
                                             const char *key,
                                             const char * const *stringv);
 
+void nautilus_keyfile_metadata_flush (void);
+
 gboolean nautilus_keyfile_metadata_update_from_keyfile (NautilusFile *file,
                                                         const char *keyfile_filename,
                                                         const gchar *name);
@@ -80,13 +80,23 @@ enum
 static GParamSpec *properties[N_PROPS] = { NULL, };
 
 static inline NautilusViewItem *
-get_view_item (GListModel *model,
+get_view_item (NautilusViewModel *model,
+               guint              position)
+{
+    g_autoptr (GtkTreeListRow) row = g_list_model_get_item (G_LIST_MODEL (model), position);
+
+    g_return_val_if_fail (GTK_IS_TREE_LIST_ROW (row), NULL);
+    return nautilus_view_model_get_item_for_row (model, row);
+}
+
+static inline NautilusFile *
+get_view_file (GListModel *model,
                guint       position)
 {
     g_autoptr (GtkTreeListRow) row = g_list_model_get_item (model, position);
 
     g_return_val_if_fail (GTK_IS_TREE_LIST_ROW (row), NULL);
-    return NAUTILUS_VIEW_ITEM (gtk_tree_list_row_get_item (row));
+    return NAUTILUS_FILE (gtk_tree_list_row_get_item (row));
 }
 
 static inline void
@@ -438,10 +448,9 @@ on_item_drag_prepare (GtkDragSource *source,
          gtk_bitset_iter_is_valid (&iter);
          gtk_bitset_iter_previous (&iter, &i))
     {
-        g_autoptr (NautilusViewItem) item = get_view_item (G_LIST_MODEL (priv->model), i);
-        NautilusFile *file = nautilus_view_item_get_file (item);
+        NautilusFile *file = get_view_file (G_LIST_MODEL (priv->model), i);
 
-        selected_files = g_list_prepend (selected_files, g_object_ref (file));
+        selected_files = g_list_prepend (selected_files, file);
 
         /* Convert to GTK_TYPE_FILE_LIST, which is assumed to be a GSList<GFile>. */
         file_list = g_slist_prepend (file_list, nautilus_file_get_activation_location (file));
@@ -817,6 +826,24 @@ on_view_drop (GtkDropTarget *target,
     return accepted;
 }
 
+static NautilusViewItem *
+get_item_for_row (GObject          *listitem,
+                  GtkTreeListRow   *row,
+                  NautilusViewCell *cell)
+{
+    NautilusListBase *self = nautilus_view_cell_get_view (cell);
+    NautilusViewModel *model;
+
+    if (row == NULL || self == NULL)
+    {
+        return NULL;
+    }
+
+    model = nautilus_list_base_get_model (self);
+
+    return model != NULL ? nautilus_view_model_get_item_for_row (model, row) : NULL;
+}
+
 void
 setup_cell_common (GObject          *listitem,
                    NautilusViewCell *cell)
@@ -825,8 +852,12 @@ setup_cell_common (GObject          *listitem,
     GtkEventController *controller;
     GtkDropTarget *drop_target;
 
+    /* The rows hold files, their view items are made as cells get bound. */
     expression = gtk_property_expression_new (GTK_TYPE_LIST_ITEM, NULL, "item");
-    expression = gtk_property_expression_new (GTK_TYPE_TREE_LIST_ROW, expression, "item");
+    expression = gtk_cclosure_expression_new (NAUTILUS_TYPE_VIEW_ITEM, NULL,
+                                              1, &expression,
+                                              G_CALLBACK (get_item_for_row),
+                                              cell, NULL);
     gtk_expression_bind (expression, cell, "item", listitem);
     g_object_bind_property (listitem, "position", cell, "position", G_BINDING_SYNC_CREATE);
 
@@ -989,7 +1020,7 @@ nautilus_list_base_get_selected_item_ui (NautilusListBase *self)
     /* Make sure the whole item is visible for the popover to point to. */
     nautilus_list_base_scroll_to_item (self, i);
 
-    item = get_view_item (G_LIST_MODEL (priv->model), i);
+    item = get_view_item (priv->model, i);
     return nautilus_view_item_get_item_ui (item);
 }
 
@@ -65,8 +65,17 @@ enum
 
 static guint signals[LAST_SIGNAL];
 
-#define get_view_item(cell) \
-        (NAUTILUS_VIEW_ITEM (gtk_tree_list_row_get_item (GTK_TREE_LIST_ROW (gtk_column_view_cell_get_item (cell)))))
+#define get_view_item(self, cell) \
+        (get_row_item (self, GTK_TREE_LIST_ROW (gtk_column_view_cell_get_item (cell))))
+
+static inline NautilusViewItem *
+get_row_item (NautilusListView *self,
+              GtkTreeListRow   *row)
+{
+    NautilusViewModel *model = nautilus_list_base_get_model (NAUTILUS_LIST_BASE (self));
+
+    return model != NULL ? nautilus_view_model_get_item_for_row (model, row) : NULL;
+}
 
 static const NautilusViewInfo list_view_info =
 {
@@ -265,8 +274,8 @@ nautilus_list_view_sort (gconstpointer a,
                          gpointer      user_data)
 {
     GQuark attribute_q = GPOINTER_TO_UINT (user_data);
-    NautilusFile *file_a = nautilus_view_item_get_file (NAUTILUS_VIEW_ITEM ((gpointer) a));
-    NautilusFile *file_b = nautilus_view_item_get_file (NAUTILUS_VIEW_ITEM ((gpointer) b));
+    NautilusFile *file_a = NAUTILUS_FILE ((gpointer) a);
+    NautilusFile *file_b = NAUTILUS_FILE ((gpointer) b);
 
     /* The reversed argument is FALSE because the columnview sorter handles that
      * itself and if we don't want to reverse the reverse. The directories_first
@@ -288,8 +297,8 @@ sort_directories_func (gconstpointer a,
 
     if (*directories_first)
     {
-        NautilusFile *file_a = nautilus_view_item_get_file (NAUTILUS_VIEW_ITEM ((gpointer) a));
-        NautilusFile *file_b = nautilus_view_item_get_file (NAUTILUS_VIEW_ITEM ((gpointer) b));
+        NautilusFile *file_a = NAUTILUS_FILE ((gpointer) a);
+        NautilusFile *file_b = NAUTILUS_FILE ((gpointer) b);
         gboolean a_is_directory = nautilus_file_is_directory (file_a);
         gboolean b_is_directory = nautilus_file_is_directory (file_b);
 
@@ -668,7 +677,7 @@ real_get_backing_item (NautilusListBase *list_base)
 
     if (common_parent != NULL)
     {
-        return gtk_tree_list_row_get_item (common_parent);
+        return nautilus_view_model_get_item_for_row (model, common_parent);
     }
 
     return NULL;
@@ -721,9 +730,9 @@ unload_file_timeout (gpointer data)
         return;
     }
 
-    g_autoptr (NautilusViewItem) item = gtk_tree_list_row_get_item (unload_data->row);
+    g_autoptr (NautilusViewItem) item = get_row_item (self, unload_data->row);
 
-    if (nautilus_file_is_gone (nautilus_view_item_get_file (item)))
+    if (item == NULL || nautilus_file_is_gone (nautilus_view_item_get_file (item)))
     {
         /* It's been removed in the meantime. */
         return;
@@ -739,7 +748,12 @@ on_row_expanded_changed (GObject    *gobject,
 {
     GtkTreeListRow *row = GTK_TREE_LIST_ROW (gobject);
     NautilusListView *self = NAUTILUS_LIST_VIEW (user_data);
-    g_autoptr (NautilusViewItem) item = NAUTILUS_VIEW_ITEM (gtk_tree_list_row_get_item (row));
+    g_autoptr (NautilusViewItem) item = get_row_item (self, row);
+
+    if (item == NULL)
+    {
+        return;
+    }
 
     if (gtk_tree_list_row_get_expanded (row))
     {
@@ -747,7 +761,8 @@ on_row_expanded_changed (GObject    *gobject,
     }
     else
     {
-        nautilus_view_item_set_loading (item, FALSE);
+        nautilus_view_model_set_loading (nautilus_list_base_get_model (NAUTILUS_LIST_BASE (self)),
+                                         nautilus_view_item_get_file (item), FALSE);
         g_timeout_add_seconds_once (COLLAPSE_TO_UNLOAD_DELAY,
                                     unload_file_timeout,
                                     unload_delay_data_new (self, row));
@@ -902,7 +917,7 @@ bind_name_cell (GtkSignalListItemFactory *factory,
     g_autoptr (NautilusViewItem) item = NULL;
 
     cell = gtk_column_view_cell_get_child (listitem);
-    item = get_view_item (listitem);
+    item = get_view_item (self, listitem);
 
     nautilus_view_item_set_item_ui (item, gtk_column_view_cell_get_child (listitem));
 
@@ -930,7 +945,7 @@ unbind_name_cell (GtkSignalListItemFactory *factory,
     NautilusListView *self = user_data;
     g_autoptr (NautilusViewItem) item = NULL;
 
-    item = get_view_item (listitem);
+    item = get_view_item (self, listitem);
     if (item == NULL)
     {
         /* The row is gone */
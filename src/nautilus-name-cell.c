@@ -7,8 +7,8 @@
 #include "nautilus-name-cell.h"
 
 #include "nautilus-directory.h"
+#include "nautilus-emblems-paintable.h"
 #include "nautilus-file-utilities.h"
-#include "nautilus-thumbnails.h"
 
 #define SPINNER_DELAY_MS 200
 
@@ -26,7 +26,7 @@ struct _NautilusNameCell
     GtkWidget *fixed_height_box;
     GtkWidget *spinner;
     GtkWidget *icon;
-    GtkWidget *emblems_box;
+    GtkWidget *emblems;
     GtkWidget *snippet_button;
     GtkWidget *snippet;
     GtkWidget *path;
@@ -181,35 +181,28 @@ update_emblems (NautilusNameCell *self)
 {
     g_autoptr (NautilusViewItem) item = NULL;
     NautilusFile *file;
-    GtkWidget *child;
-    GtkIconTheme *theme;
-    g_autolist (GIcon) emblems = NULL;
+    g_autoptr (GdkPaintable) paintable = NULL;
 
     item = nautilus_view_cell_get_item (NAUTILUS_VIEW_CELL (self));
     g_return_if_fail (item != NULL);
     file = nautilus_view_item_get_file (item);
 
-    /* Remove old emblems. */
-    while ((child = gtk_widget_get_first_child (self->emblems_box)) != NULL)
+    paintable = nautilus_emblems_paintable_lookup_for_file (file, FALSE, GTK_ORIENTATION_HORIZONTAL,
+                                                            gtk_widget_get_scale_factor (GTK_WIDGET (self)));
+
+    /* Most changes of a file don't change its emblems */
+    if (gtk_image_get_paintable (GTK_IMAGE (self->emblems)) == paintable)
     {
-        gtk_box_remove (GTK_BOX (self->emblems_box), child);
+        return;
     }
 
-    theme = gtk_icon_theme_get_for_display (gdk_display_get_default ());
-    emblems = nautilus_file_get_emblem_icons (file);
-    for (GList *l = emblems; l != NULL; l = l->next)
+    gtk_image_set_from_paintable (GTK_IMAGE (self->emblems), paintable);
+    if (paintable != NULL)
     {
-        if (!gtk_icon_theme_has_gicon (theme, l->data))
-        {
-            g_autofree gchar *icon_string = g_icon_to_string (l->data);
-            g_warning ("Failed to add emblem. “%s” not found in the icon theme",
-                       icon_string);
-            continue;
-        }
-
-        gtk_box_append (GTK_BOX (self->emblems_box),
-                        gtk_image_new_from_gicon (l->data));
+        gtk_image_set_pixel_size (GTK_IMAGE (self->emblems),
+                                  nautilus_emblems_paintable_get_length (NAUTILUS_EMBLEMS_PAINTABLE (paintable)));
     }
+    gtk_widget_set_visible (self->emblems, paintable != NULL);
 }
 
 static void
@@ -220,6 +213,21 @@ on_file_changed (NautilusNameCell *self)
     update_emblems (self);
 }
 
+static void
+on_scale_factor_changed (NautilusNameCell *self)
+{
+    g_autoptr (NautilusViewItem) item = nautilus_view_cell_get_item (NAUTILUS_VIEW_CELL (self));
+
+    if (item == NULL)
+    {
+        /* Cell is not bound to an item yet. Do nothing. */
+        return;
+    }
+
+    /* The emblems are rendered for the scale factor */
+    update_emblems (self);
+}
+
 static void
 on_icon_size_changed (NautilusNameCell *self)
 {
@@ -315,41 +323,18 @@ on_item_is_loading_changed (NautilusNameCell *self)
     }
 }
 
-static void
-on_map_changed (GtkWidget *widget,
-                gpointer   user_data)
-{
-    NautilusViewCell *cell = NAUTILUS_VIEW_CELL (widget);
-    gboolean is_mapped = GPOINTER_TO_INT (user_data);
-    g_autoptr (NautilusViewItem) item = nautilus_view_cell_get_item (cell);
-
-    g_return_if_fail (item != NULL);
-
-    NautilusFile *file = nautilus_view_item_get_file (item);
-
-    if (nautilus_file_is_thumbnailing (file))
-    {
-        g_autofree char *uri = nautilus_file_get_uri (file);
-        if (is_mapped)
-        {
-            nautilus_thumbnail_prioritize (uri);
-        }
-        else
-        {
-            nautilus_thumbnail_deprioritize (uri);
-        }
-    }
-}
-
 static void
 nautilus_name_cell_init (NautilusNameCell *self)
 {
     gtk_widget_init_template (GTK_WIDGET (self));
 
-    g_signal_connect (self, "map", G_CALLBACK (on_map_changed), GINT_TO_POINTER (TRUE));
-    g_signal_connect (self, "unmap", G_CALLBACK (on_map_changed), GINT_TO_POINTER (FALSE));
+    nautilus_view_cell_set_mapped_attributes (NAUTILUS_VIEW_CELL (self),
+                                              NAUTILUS_FILE_ATTRIBUTE_THUMBNAIL |
+                                              NAUTILUS_FILE_ATTRIBUTE_EXTENSION_INFO);
     g_signal_connect (self, "notify::icon-size",
                       G_CALLBACK (on_icon_size_changed), NULL);
+    g_signal_connect (self, "notify::scale-factor",
+                      G_CALLBACK (on_scale_factor_changed), NULL);
 
     /* Connect automatically to an item. */
     self->item_signal_group = g_signal_group_new (NAUTILUS_TYPE_VIEW_ITEM);
@@ -407,7 +392,7 @@ nautilus_name_cell_class_init (NautilusNameCellClass *klass)
     gtk_widget_class_bind_template_child (widget_class, NautilusNameCell, fixed_height_box);
     gtk_widget_class_bind_template_child (widget_class, NautilusNameCell, spinner);
     gtk_widget_class_bind_template_child (widget_class, NautilusNameCell, icon);
-    gtk_widget_class_bind_template_child (widget_class, NautilusNameCell, emblems_box);
+    gtk_widget_class_bind_template_child (widget_class, NautilusNameCell, emblems);
     gtk_widget_class_bind_template_child (widget_class, NautilusNameCell, snippet_button);
     gtk_widget_class_bind_template_child (widget_class, NautilusNameCell, snippet);
     gtk_widget_class_bind_template_child (widget_class, NautilusNameCell, path);
@@ -24,14 +24,48 @@
 
 #include "nautilus-progress-info-manager.h"
 
+#include <glib/gi18n.h>
+
+/* Jobs smaller than this are never held back behind a large transfer to the
+ * same device. */
+#define SMALL_JOB_THRESHOLD_BYTES (16 * 1024 * 1024)
+#define DEFAULT_MAX_JOBS_PER_DEVICE 1
+
+typedef struct
+{
+    NautilusProgressInfo *info;
+    char *device_id;
+    goffset size;
+    gboolean running;
+    GCancellable *cancellable;
+    gulong cancelled_id;
+    GSourceOnceFunc callback;
+    gpointer user_data;
+} QueuedJob;
+
 struct _NautilusProgressInfoManager
 {
     GObject parent_instance;
 
     GList *progress_infos;
     GList *current_viewers;
+
+    /* Device scheduler. The job cancellables may be cancelled from any
+     * thread, so everything below is protected by queue_mutex. */
+    GMutex queue_mutex;
+    GQueue job_queue;
+    guint max_jobs_per_device;
 };
 
+enum
+{
+    PROP_0,
+    PROP_MAX_JOBS_PER_DEVICE,
+    N_PROPS
+};
+
+static GParamSpec *properties[N_PROPS] = { NULL, };
+
 enum
 {
     NEW_PROGRESS_INFO,
@@ -48,6 +82,15 @@ G_DEFINE_TYPE (NautilusProgressInfoManager, nautilus_progress_info_manager,
 
 static void remove_viewer (NautilusProgressInfoManager *self,
                            GObject                     *viewer);
+static void start_waiting_jobs (NautilusProgressInfoManager *self);
+
+static void
+queued_job_free (QueuedJob *job)
+{
+    g_free (job->device_id);
+    g_clear_object (&job->cancellable);
+    g_free (job);
+}
 
 static void
 nautilus_progress_info_manager_finalize (GObject *obj)
@@ -66,6 +109,9 @@ nautilus_progress_info_manager_finalize (GObject *obj)
     }
     g_list_free (self->current_viewers);
 
+    g_queue_clear_full (&self->job_queue, (GDestroyNotify) queued_job_free);
+    g_mutex_clear (&self->queue_mutex);
+
     G_OBJECT_CLASS (nautilus_progress_info_manager_parent_class)->finalize (obj);
 }
 
@@ -90,9 +136,64 @@ nautilus_progress_info_manager_constructor (GType                  type,
     return retval;
 }
 
+static void
+nautilus_progress_info_manager_get_property (GObject    *object,
+                                             guint       prop_id,
+                                             GValue     *value,
+                                             GParamSpec *pspec)
+{
+    NautilusProgressInfoManager *self = NAUTILUS_PROGRESS_INFO_MANAGER (object);
+
+    switch (prop_id)
+    {
+        case PROP_MAX_JOBS_PER_DEVICE:
+        {
+            g_mutex_lock (&self->queue_mutex);
+            g_value_set_uint (value, self->max_jobs_per_device);
+            g_mutex_unlock (&self->queue_mutex);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        }
+    }
+}
+
+static void
+nautilus_progress_info_manager_set_property (GObject      *object,
+                                             guint         prop_id,
+                                             const GValue *value,
+                                             GParamSpec   *pspec)
+{
+    NautilusProgressInfoManager *self = NAUTILUS_PROGRESS_INFO_MANAGER (object);
+
+    switch (prop_id)
+    {
+        case PROP_MAX_JOBS_PER_DEVICE:
+        {
+            g_mutex_lock (&self->queue_mutex);
+            self->max_jobs_per_device = g_value_get_uint (value);
+            /* A raised limit may let queued jobs start right away. */
+            start_waiting_jobs (self);
+            g_mutex_unlock (&self->queue_mutex);
+        }
+        break;
+
+        default:
+        {
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        }
+    }
+}
+
 static void
 nautilus_progress_info_manager_init (NautilusProgressInfoManager *self)
 {
+    g_mutex_init (&self->queue_mutex);
+    g_queue_init (&self->job_queue);
+    self->max_jobs_per_device = DEFAULT_MAX_JOBS_PER_DEVICE;
 }
 
 static void
@@ -103,6 +204,14 @@ nautilus_progress_info_manager_class_init (NautilusProgressInfoManagerClass *kla
     oclass = G_OBJECT_CLASS (klass);
     oclass->constructor = nautilus_progress_info_manager_constructor;
     oclass->finalize = nautilus_progress_info_manager_finalize;
+    oclass->get_property = nautilus_progress_info_manager_get_property;
+    oclass->set_property = nautilus_progress_info_manager_set_property;
+
+    properties[PROP_MAX_JOBS_PER_DEVICE] =
+        g_param_spec_uint ("max-jobs-per-device", NULL, NULL,
+                           1, G_MAXUINT, DEFAULT_MAX_JOBS_PER_DEVICE,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+    g_object_class_install_properties (oclass, N_PROPS, properties);
 
     signals[NEW_PROGRESS_INFO] =
         g_signal_new ("new-progress-info",
@@ -238,3 +347,213 @@ nautilus_progress_manager_has_viewers (NautilusProgressInfoManager *self)
 {
     return self->current_viewers != NULL;
 }
+
+static gboolean
+is_small_job (QueuedJob *job)
+{
+    return job->size >= 0 && job->size < SMALL_JOB_THRESHOLD_BYTES;
+}
+
+/* Called with queue_mutex held */
+static QueuedJob *
+find_queued_job (NautilusProgressInfoManager  *self,
+                 NautilusProgressInfo         *info,
+                 GList                       **link)
+{
+    for (GList *l = self->job_queue.head; l != NULL; l = l->next)
+    {
+        QueuedJob *job = l->data;
+
+        if (job->info == info)
+        {
+            if (link != NULL)
+            {
+                *link = l;
+            }
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+/* Called with queue_mutex held */
+static gboolean
+can_start_job (NautilusProgressInfoManager *self,
+               QueuedJob                   *job)
+{
+    guint running = 0;
+    gboolean ahead = TRUE;
+
+    /* Small jobs bypass the limit, so that they aren't stuck behind a long
+     * transfer, and don't count against it either. Jobs whose device is
+     * unknown can't be told to be on the same device as any other. */
+    if (is_small_job (job) || job->device_id == NULL)
+    {
+        return TRUE;
+    }
+
+    for (GList *l = self->job_queue.head; l != NULL; l = l->next)
+    {
+        QueuedJob *other = l->data;
+
+        if (other == job)
+        {
+            ahead = FALSE;
+            continue;
+        }
+
+        if (is_small_job (other) ||
+            g_strcmp0 (other->device_id, job->device_id) != 0)
+        {
+            continue;
+        }
+
+        if (other->running)
+        {
+            running++;
+        }
+        else if (ahead)
+        {
+            /* Someone ahead of us in the queue is waiting for the same device */
+            return FALSE;
+        }
+    }
+
+    return running < self->max_jobs_per_device;
+}
+
+/* Called with queue_mutex held */
+static void
+start_waiting_jobs (NautilusProgressInfoManager *self)
+{
+    for (GList *l = self->job_queue.head; l != NULL; l = l->next)
+    {
+        QueuedJob *job = l->data;
+
+        if (job->running)
+        {
+            continue;
+        }
+
+        /* Cancelled jobs are let go as well, so that they can clean up */
+        if (g_cancellable_is_cancelled (job->cancellable) ||
+            can_start_job (self, job))
+        {
+            job->running = TRUE;
+            g_idle_add_once (job->callback, job->user_data);
+        }
+    }
+}
+
+static void
+on_waiting_job_cancelled (GCancellable                *cancellable,
+                          NautilusProgressInfoManager *self)
+{
+    g_mutex_lock (&self->queue_mutex);
+    start_waiting_jobs (self);
+    g_mutex_unlock (&self->queue_mutex);
+}
+
+/**
+ * nautilus_progress_info_manager_queue_for_device:
+ * @self: the manager
+ * @info: the progress info of the job
+ * @device_id: the filesystem id of the destination, or %NULL if unknown
+ * @size: the number of bytes the job is going to write, or -1 if unknown
+ * @cancellable: the job cancellable
+ * @callback: called from the main loop once the job may start
+ * @user_data: data for @callback
+ *
+ * Queues the job until it is allowed to write to @device_id, i.e. until fewer
+ * than #NautilusProgressInfoManager:max-jobs-per-device jobs are running on it
+ * and no job queued before this one is waiting for it. Jobs smaller than a few
+ * megabytes, and jobs whose @device_id is %NULL, are let through right away. @callback is also called if
+ * @cancellable is cancelled while the job is waiting, so callers must check
+ * for cancellation before starting the transfer.
+ *
+ * Nothing blocks while the job is waiting: callers are expected to start their
+ * job thread from @callback.
+ *
+ * Must be balanced with nautilus_progress_info_manager_release_device().
+ */
+void
+nautilus_progress_info_manager_queue_for_device (NautilusProgressInfoManager *self,
+                                                 NautilusProgressInfo        *info,
+                                                 const char                  *device_id,
+                                                 goffset                      size,
+                                                 GCancellable                *cancellable,
+                                                 GSourceOnceFunc              callback,
+                                                 gpointer                     user_data)
+{
+    QueuedJob *job;
+    gboolean waiting;
+
+    g_return_if_fail (NAUTILUS_IS_PROGRESS_INFO_MANAGER (self));
+    g_return_if_fail (NAUTILUS_IS_PROGRESS_INFO (info));
+    g_return_if_fail (G_IS_CANCELLABLE (cancellable));
+    g_return_if_fail (callback != NULL);
+
+    job = g_new0 (QueuedJob, 1);
+    job->info = info;
+    job->device_id = g_strdup (device_id);
+    job->size = size;
+    job->cancellable = g_object_ref (cancellable);
+    job->callback = callback;
+    job->user_data = user_data;
+
+    g_mutex_lock (&self->queue_mutex);
+    g_queue_push_tail (&self->job_queue, job);
+    start_waiting_jobs (self);
+    waiting = !job->running;
+    g_mutex_unlock (&self->queue_mutex);
+
+    if (waiting)
+    {
+        nautilus_progress_info_set_details (info,
+                                            _("Waiting for other operations on the same drive"));
+    }
+
+    /* Connect outside of the lock, the handler runs immediately if the job
+     * is already cancelled. The job can't go away before this returns, as
+     * it is only released from the main loop. */
+    job->cancelled_id = g_cancellable_connect (cancellable,
+                                               G_CALLBACK (on_waiting_job_cancelled),
+                                               self, NULL);
+}
+
+/**
+ * nautilus_progress_info_manager_release_device:
+ * @self: the manager
+ * @info: the progress info passed to nautilus_progress_info_manager_queue_for_device()
+ *
+ * Gives back the device slot of the job so that queued jobs can start. Does
+ * nothing if the job was never queued.
+ */
+void
+nautilus_progress_info_manager_release_device (NautilusProgressInfoManager *self,
+                                               NautilusProgressInfo        *info)
+{
+    QueuedJob *job;
+    GList *link = NULL;
+
+    g_return_if_fail (NAUTILUS_IS_PROGRESS_INFO_MANAGER (self));
+
+    g_mutex_lock (&self->queue_mutex);
+
+    job = find_queued_job (self, info, &link);
+    if (job != NULL)
+    {
+        g_queue_delete_link (&self->job_queue, link);
+        start_waiting_jobs (self);
+    }
+
+    g_mutex_unlock (&self->queue_mutex);
+
+    if (job != NULL)
+    {
+        /* Not under the lock, this waits for a running cancelled handler */
+        g_cancellable_disconnect (job->cancellable, job->cancelled_id);
+        queued_job_free (job);
+    }
+}
@@ -41,4 +41,14 @@ void nautilus_progress_manager_add_viewer (NautilusProgressInfoManager *self, GO
 void nautilus_progress_manager_remove_viewer (NautilusProgressInfoManager *self, GObject *viewer);
 gboolean nautilus_progress_manager_has_viewers (NautilusProgressInfoManager *self);
 
+void nautilus_progress_info_manager_queue_for_device (NautilusProgressInfoManager *self,
+                                                      NautilusProgressInfo        *info,
+                                                      const char                  *device_id,
+                                                      goffset                      size,
+                                                      GCancellable                *cancellable,
+                                                      GSourceOnceFunc              callback,
+                                                      gpointer                     user_data);
+void nautilus_progress_info_manager_release_device (NautilusProgressInfoManager *self,
+                                                    NautilusProgressInfo        *info);
+
 G_END_DECLS
@@ -79,6 +79,19 @@ struct _NautilusProgressInfo
     gboolean changed_at_idle;
     gboolean progress_at_idle;
 
+    /* Published by the job thread, and only turned into strings on the main
+     * thread when someone asks for the details. The progress fraction comes
+     * from the counters as long as they are published, whatever the format
+     * of the details. */
+    gboolean has_counters;
+    gint64 file_index;
+    gint64 files_done;
+    gint64 files_total;
+    gint64 bytes_done;
+    gint64 bytes_total;
+    gdouble rate;
+    NautilusProgressDetailsFormat details_format;
+
     GFile *destination;
 };
 
@@ -91,6 +104,7 @@ static void set_details (NautilusProgressInfo *info,
 static void set_status (NautilusProgressInfo *info,
                         const char           *status);
 static const char * get_icon_name (NautilusProgressInfo *info);
+static double get_counters_progress (NautilusProgressInfo *info);
 
 static void
 nautilus_progress_info_finalize (GObject *object)
@@ -156,7 +170,14 @@ nautilus_progress_info_get_property (GObject    *object,
              * in that we don't want to ever return -1, which would be the case when
              * activity mode is true
              */
-            g_value_set_double (value, self->progress);
+            if (self->has_counters)
+            {
+                g_value_set_double (value, get_counters_progress (self));
+            }
+            else
+            {
+                g_value_set_double (value, self->progress);
+            }
             G_UNLOCK (progress_info);
         }
         break;
@@ -427,6 +448,221 @@ nautilus_progress_info_get_status (NautilusProgressInfo *info)
     return res;
 }
 
+/* keep in time with nautilus_progress_info_format_time ()
+ *
+ * This counts and outputs the number of “time units”
+ * formatted and displayed by nautilus_progress_info_format_time ().
+ * For instance, if it outputs “3 hours, 4 minutes”
+ * it yields 7.
+ */
+int
+nautilus_progress_info_count_time_units (int seconds)
+{
+    int minutes;
+    int hours;
+
+    if (seconds < 0)
+    {
+        /* Just to make sure... */
+        seconds = 0;
+    }
+
+    if (seconds < 60)
+    {
+        /* seconds */
+        return seconds;
+    }
+
+    if (seconds < 60 * 60)
+    {
+        /* minutes */
+        minutes = seconds / 60;
+        return minutes;
+    }
+
+    hours = seconds / (60 * 60);
+
+    if (seconds < 60 * 60 * 4)
+    {
+        /* minutes + hours */
+        minutes = (seconds - hours * 60 * 60) / 60;
+        return minutes + hours;
+    }
+
+    return hours;
+}
+
+char *
+nautilus_progress_info_format_time (int seconds)
+{
+    int minutes;
+    int hours;
+    gchar *res;
+
+    if (seconds < 0)
+    {
+        /* Just to make sure... */
+        seconds = 0;
+    }
+
+    if (seconds < 60)
+    {
+        return g_strdup_printf (ngettext ("%'d second", "%'d seconds", (int) seconds), (int) seconds);
+    }
+
+    if (seconds < 60 * 60)
+    {
+        minutes = seconds / 60;
+        return g_strdup_printf (ngettext ("%'d minute", "%'d minutes", minutes), minutes);
+    }
+
+    hours = seconds / (60 * 60);
+
+    if (seconds < 60 * 60 * 4)
+    {
+        gchar *h, *m;
+
+        minutes = (seconds - hours * 60 * 60) / 60;
+
+        h = g_strdup_printf (ngettext ("%'d hour", "%'d hours", hours), hours);
+        m = g_strdup_printf (ngettext ("%'d minute", "%'d minutes", minutes), minutes);
+        res = g_strconcat (h, ", ", m, NULL);
+        g_free (h);
+        g_free (m);
+        return res;
+    }
+
+    return g_strdup_printf (ngettext ("%'d hour",
+                                      "%'d hours",
+                                      hours), hours);
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+/* Called with lock held */
+static char *
+format_counters (NautilusProgressInfo *info)
+{
+    gint64 file_index = info->file_index;
+    gint64 files_total = info->files_total;
+    gint64 bytes_done = info->bytes_done;
+    gint64 bytes_total = info->bytes_total;
+    gdouble rate = info->rate;
+    int remaining_time = (int) info->remaining_time;
+
+    switch (info->details_format)
+    {
+        case NAUTILUS_PROGRESS_DETAILS_FILES:
+        {
+            /* To translators: %'d is the number of files completed for the operation,
+             * so it will be something like 2/14. */
+            return g_strdup_printf (_("%'d / %'d"), (int) file_index, (int) files_total);
+        }
+
+        case NAUTILUS_PROGRESS_DETAILS_BYTES:
+        {
+            g_autofree gchar *formatted_size_num_bytes = g_format_size (bytes_done);
+            g_autofree gchar *formatted_size_total_size = g_format_size (bytes_total);
+
+            /* To translators: %s will expand to a size like "2 bytes" or "3 MB", so something like "4 kB / 4 MB" */
+            return g_strdup_printf (_("%s / %s"),
+                                    formatted_size_num_bytes,
+                                    formatted_size_total_size);
+        }
+
+        case NAUTILUS_PROGRESS_DETAILS_BYTES_RATE:
+        {
+            g_autofree gchar *formatted_time = nautilus_progress_info_format_time (remaining_time);
+            g_autofree gchar *formatted_size_num_bytes = g_format_size (bytes_done);
+            g_autofree gchar *formatted_size_total_size = g_format_size (bytes_total);
+            g_autofree gchar *formatted_size_transfer_rate = g_format_size ((goffset) rate);
+
+            /* To translators: %s will expand to a size like "2 bytes" or "3 MB", %s to a time duration like
+             * "2 minutes". So the whole thing will be something like "2 kB / 4 MB -- 2 hours left (4 kB/s)"
+             *
+             * The singular/plural form will be used depending on the remaining time (i.e. the %s argument).
+             */
+            return g_strdup_printf (ngettext ("%s / %s \xE2\x80\x94 %s left (%s/s)",
+                                              "%s / %s \xE2\x80\x94 %s left (%s/s)",
+                                              nautilus_progress_info_count_time_units (remaining_time)),
+                                    formatted_size_num_bytes,
+                                    formatted_size_total_size,
+                                    formatted_time,
+                                    formatted_size_transfer_rate);
+        }
+
+        case NAUTILUS_PROGRESS_DETAILS_FILES_RATE:
+        {
+            g_autofree gchar *formatted_time = nautilus_progress_info_format_time (remaining_time);
+            g_autofree gchar *formatted_size = g_format_size ((goffset) rate);
+
+            /* To translators: %s will expand to a time duration like "2 minutes".
+             * So the whole thing will be something like "1 / 5 -- 2 hours left (4 kB/s)"
+             *
+             * The singular/plural form will be used depending on the remaining time (i.e. the %s argument).
+             */
+            return g_strdup_printf (ngettext ("%'d / %'d \xE2\x80\x94 %s left (%s/s)",
+                                              "%'d / %'d \xE2\x80\x94 %s left (%s/s)",
+                                              nautilus_progress_info_count_time_units (remaining_time)),
+                                    (int) file_index, (int) files_total,
+                                    formatted_time,
+                                    formatted_size);
+        }
+
+        case NAUTILUS_PROGRESS_DETAILS_FILES_PER_SECOND:
+        {
+            g_autofree gchar *formatted_time = nautilus_progress_info_format_time (remaining_time);
+            g_autofree gchar *concat_detail = NULL;
+            gchar *time_left_message;
+            gchar *files_per_second_message;
+            int files_per_second = (int) (rate + 0.5);
+
+            /* To translators: %s will expand to a time duration like "2 minutes".
+             * So the whole thing will be something like "1 / 5 -- 2 hours left (4 files/s)"
+             *
+             * The singular/plural form will be used depending on the remaining time (i.e. the %s argument).
+             */
+            time_left_message = ngettext ("%'d / %'d \xE2\x80\x94 %s left",
+                                          "%'d / %'d \xE2\x80\x94 %s left",
+                                          nautilus_progress_info_count_time_units (remaining_time));
+            files_per_second_message = ngettext ("(%d file/s)",
+                                                 "(%d files/s)",
+                                                 files_per_second);
+            concat_detail = g_strconcat (time_left_message, " ", files_per_second_message, NULL);
+
+            return g_strdup_printf (concat_detail,
+                                    (int) file_index, (int) files_total,
+                                    formatted_time,
+                                    files_per_second);
+        }
+
+        case NAUTILUS_PROGRESS_DETAILS_TEXT:
+        default:
+        {
+            g_assert_not_reached ();
+        }
+    }
+
+    return NULL;
+}
+#pragma GCC diagnostic pop
+
+/* Called with lock held */
+static double
+get_counters_progress (NautilusProgressInfo *info)
+{
+    if (info->bytes_total > 0)
+    {
+        return CLAMP ((double) info->bytes_done / info->bytes_total, 0.0, 1.0);
+    }
+    else if (info->files_total > 0)
+    {
+        return CLAMP ((double) info->files_done / info->files_total, 0.0, 1.0);
+    }
+
+    return 1.0;
+}
+
 char *
 nautilus_progress_info_get_details (NautilusProgressInfo *info)
 {
@@ -434,7 +670,11 @@ nautilus_progress_info_get_details (NautilusProgressInfo *info)
 
     G_LOCK (progress_info);
 
-    if (info->details)
+    if (info->details_format != NAUTILUS_PROGRESS_DETAILS_TEXT)
+    {
+        res = format_counters (info);
+    }
+    else if (info->details)
     {
         res = g_strdup (info->details);
     }
@@ -455,7 +695,11 @@ nautilus_progress_info_get_progress (NautilusProgressInfo *info)
 
     G_LOCK (progress_info);
 
-    if (info->activity_mode)
+    if (info->has_counters)
+    {
+        res = get_counters_progress (info);
+    }
+    else if (info->activity_mode)
     {
         res = -1.0;
     }
@@ -673,6 +917,7 @@ set_details (NautilusProgressInfo *info,
 {
     g_free (info->details);
     info->details = g_strdup (details);
+    info->details_format = NAUTILUS_PROGRESS_DETAILS_TEXT;
 
     info->changed_at_idle = TRUE;
     queue_idle (info, FALSE);
@@ -715,6 +960,7 @@ nautilus_progress_info_pulse_progress (NautilusProgressInfo *info)
 {
     G_LOCK (progress_info);
 
+    info->has_counters = FALSE;
     info->activity_mode = TRUE;
     info->progress = 0.0;
     info->progress_at_idle = TRUE;
@@ -752,9 +998,11 @@ nautilus_progress_info_set_progress (NautilusProgressInfo *info,
     G_LOCK (progress_info);
 
     if ((info->activity_mode ||     /* emit on switch from activity mode */
+         info->has_counters ||
          fabs (current_percent - info->progress) > 0.005) &&    /* Emit on change of 0.5 percent */
         !g_cancellable_is_cancelled (info->cancellable))
     {
+        info->has_counters = FALSE;
         info->activity_mode = FALSE;
         info->progress = current_percent;
         info->progress_at_idle = TRUE;
@@ -764,6 +1012,66 @@ nautilus_progress_info_set_progress (NautilusProgressInfo *info,
     G_UNLOCK (progress_info);
 }
 
+/**
+ * nautilus_progress_info_publish_counters:
+ * @info: the progress info
+ * @format: how to present the counters as details
+ * @file_index: the number of the file being worked on, as shown in the details
+ * @files_done: the number of files done
+ * @files_total: the total number of files
+ * @bytes_done: the number of bytes done
+ * @bytes_total: the total number of bytes, or 0 to track progress by files
+ * @rate: bytes per second, or files per second for
+ *     %NAUTILUS_PROGRESS_DETAILS_FILES_PER_SECOND
+ *
+ * Cheaper alternative to formatting the details and setting the progress on
+ * the job thread: the counters are only formatted on the main thread when
+ * the details are asked for. The main thread is woken up at most once per
+ * update interval.
+ *
+ * The counters give the progress fraction until the next call to
+ * nautilus_progress_info_set_progress() or
+ * nautilus_progress_info_pulse_progress(), even if text details are set in
+ * the meantime.
+ *
+ * The remaining time set with nautilus_progress_info_set_remaining_time() is
+ * used for the formats with a rate.
+ */
+void
+nautilus_progress_info_publish_counters (NautilusProgressInfo          *info,
+                                         NautilusProgressDetailsFormat  format,
+                                         gint64                         file_index,
+                                         gint64                         files_done,
+                                         gint64                         files_total,
+                                         gint64                         bytes_done,
+                                         gint64                         bytes_total,
+                                         gdouble                        rate)
+{
+    g_return_if_fail (format != NAUTILUS_PROGRESS_DETAILS_TEXT);
+
+    G_LOCK (progress_info);
+
+    /* Keep showing “Canceled”, which is set under the lock too */
+    if (!g_cancellable_is_cancelled (info->cancellable))
+    {
+        info->has_counters = TRUE;
+        info->file_index = file_index;
+        info->files_done = files_done;
+        info->files_total = files_total;
+        info->bytes_done = bytes_done;
+        info->bytes_total = bytes_total;
+        info->rate = rate;
+        info->details_format = format;
+
+        info->activity_mode = FALSE;
+        info->changed_at_idle = TRUE;
+        info->progress_at_idle = TRUE;
+        queue_idle (info, FALSE);
+    }
+
+    G_UNLOCK (progress_info);
+}
+
 void
 nautilus_progress_info_set_remaining_time (NautilusProgressInfo *info,
                                            gdouble               time)
@@ -776,7 +1084,7 @@ nautilus_progress_info_set_remaining_time (NautilusProgressInfo *info,
 gdouble
 nautilus_progress_info_get_remaining_time (NautilusProgressInfo *info)
 {
-    gint remaining_time;
+    gdouble remaining_time;
 
     G_LOCK (progress_info);
     remaining_time = info->remaining_time;
@@ -797,7 +1105,7 @@ nautilus_progress_info_set_elapsed_time (NautilusProgressInfo *info,
 gdouble
 nautilus_progress_info_get_elapsed_time (NautilusProgressInfo *info)
 {
-    gint elapsed_time;
+    gdouble elapsed_time;
 
     G_LOCK (progress_info);
     elapsed_time = info->elapsed_time;
@@ -38,6 +38,18 @@ G_DECLARE_FINAL_TYPE (NautilusProgressInfo, nautilus_progress_info, NAUTILUS, PR
    All methods are threadsafe.
  */
 
+/* How to present the counters published with
+ * nautilus_progress_info_publish_counters() as details. */
+typedef enum
+{
+    NAUTILUS_PROGRESS_DETAILS_TEXT,             /* the details string */
+    NAUTILUS_PROGRESS_DETAILS_FILES,            /* “2 / 14” */
+    NAUTILUS_PROGRESS_DETAILS_BYTES,            /* “4 kB / 4 MB” */
+    NAUTILUS_PROGRESS_DETAILS_FILES_RATE,       /* “2 / 14 — 2 minutes left (4 kB/s)” */
+    NAUTILUS_PROGRESS_DETAILS_BYTES_RATE,       /* “4 kB / 4 MB — 2 minutes left (4 kB/s)” */
+    NAUTILUS_PROGRESS_DETAILS_FILES_PER_SECOND, /* “2 / 14 — 2 minutes left (4 files/s)” */
+} NautilusProgressDetailsFormat;
+
 NautilusProgressInfo *nautilus_progress_info_new (void);
 
 GList *       nautilus_get_all_progress_info (void);
@@ -68,6 +80,17 @@ void          nautilus_progress_info_set_progress    (NautilusProgressInfo *info
 						      double                current,
 						      double                total);
 void          nautilus_progress_info_pulse_progress  (NautilusProgressInfo *info);
+void          nautilus_progress_info_publish_counters (NautilusProgressInfo          *info,
+                                                       NautilusProgressDetailsFormat  format,
+                                                       gint64                         file_index,
+                                                       gint64                         files_done,
+                                                       gint64                         files_total,
+                                                       gint64                         bytes_done,
+                                                       gint64                         bytes_total,
+                                                       gdouble                        rate);
+
+char *        nautilus_progress_info_format_time          (int seconds);
+int           nautilus_progress_info_count_time_units     (int seconds);
 
 void          nautilus_progress_info_set_remaining_time (NautilusProgressInfo *info,
                                                          gdouble               time);
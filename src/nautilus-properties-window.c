@@ -3963,7 +3963,8 @@ nautilus_properties_window_present (GList                            *files,
         next = l->next;
         nautilus_file_call_when_ready
             (NAUTILUS_FILE (l->data),
-            NAUTILUS_FILE_ATTRIBUTE_INFO,
+            NAUTILUS_FILE_ATTRIBUTE_INFO |
+            NAUTILUS_FILE_ATTRIBUTE_EXTRA_INFO,
             is_directory_ready_callback,
             startup_data);
     }
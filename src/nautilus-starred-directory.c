@@ -28,6 +28,8 @@ struct _NautilusFavoriteDirectory
     NautilusDirectory parent_slot;
 
     GList *files;
+    /* NautilusFile -> its link in files */
+    GHashTable *file_links;
 
     GList *monitor_list;
     GList *callback_list;
@@ -100,37 +102,27 @@ nautilus_starred_directory_update_files (NautilusFavoriteDirectory *self,
     NautilusTagManager *tag_manager = nautilus_tag_manager_get ();
     GList *monitor_list;
     FavoriteMonitor *monitor;
-    g_autoptr (GHashTable) uri_table = NULL;
-    GList *next;
     g_autolist (NautilusFile) files_added = NULL;
     g_autolist (NautilusFile) files_removed = NULL;
 
-    uri_table = g_hash_table_new_full (g_str_hash,
-                                       g_str_equal,
-                                       (GDestroyNotify) g_free,
-                                       NULL);
-
-    for (GList *l = self->files; l != NULL; l = l->next)
-    {
-        g_hash_table_add (uri_table, nautilus_file_get_uri (NAUTILUS_FILE (l->data)));
-    }
-
-    for (GList *l = changed_files; l != NULL; l = next)
+    /* Files are unique per location, so a file which was moved after being
+     * starred is still found here. */
+    for (GList *l = changed_files; l != NULL; l = l->next)
     {
         NautilusFile *file = l->data;
         g_autofree char *uri = nautilus_file_get_uri (file);
+        GList *link = g_hash_table_lookup (self->file_links, file);
+        gboolean is_starred = nautilus_tag_manager_file_is_starred (tag_manager, uri);
 
-        next = l->next;
-        if (g_hash_table_contains (uri_table, uri) &&
-            !nautilus_tag_manager_file_is_starred (tag_manager, uri))
+        if (link != NULL && !is_starred)
         {
             disconnect_and_unmonitor_file (file, self);
-            nautilus_file_unref (file);
-            files_removed = g_list_prepend (files_removed, nautilus_file_ref (file));
-            self->files = g_list_remove (self->files, file);
+            g_hash_table_remove (self->file_links, file);
+            self->files = g_list_delete_link (self->files, link);
+            /* Hand the directory's reference over to the list */
+            files_removed = g_list_prepend (files_removed, file);
         }
-        else if (!g_hash_table_contains (uri_table, uri) &&
-                 nautilus_tag_manager_file_is_starred (tag_manager, uri))
+        else if (link == NULL && is_starred)
         {
             for (monitor_list = self->monitor_list; monitor_list; monitor_list = monitor_list->next)
             {
@@ -144,6 +136,7 @@ nautilus_starred_directory_update_files (NautilusFavoriteDirectory *self,
 
             files_added = g_list_prepend (files_added, nautilus_file_ref (file));
             self->files = g_list_prepend (self->files, nautilus_file_ref (file));
+            g_hash_table_insert (self->file_links, file, self->files);
         }
         else
         {
@@ -427,6 +420,7 @@ nautilus_starred_directory_set_files (NautilusFavoriteDirectory *self)
         }
 
         file_list = g_list_prepend (file_list, nautilus_file_ref (file));
+        g_hash_table_insert (self->file_links, file, file_list);
     }
 
     self->files = file_list;
@@ -439,6 +433,7 @@ real_force_reload (NautilusDirectory *directory)
 
     /* Unset current file list */
     g_list_foreach (self->files, (GFunc) disconnect_and_unmonitor_file, self);
+    g_hash_table_remove_all (self->file_links);
     g_clear_list (&self->files, g_object_unref);
 
     /* Set a fresh file list  */
@@ -456,6 +451,7 @@ nautilus_starred_directory_finalize (GObject *object)
                                           on_starred_files_changed,
                                           self);
 
+    g_hash_table_destroy (self->file_links);
     nautilus_file_list_free (self->files);
 
     G_OBJECT_CLASS (nautilus_starred_directory_parent_class)->finalize (object);
@@ -524,6 +520,8 @@ nautilus_starred_directory_new (void)
 static void
 nautilus_starred_directory_init (NautilusFavoriteDirectory *self)
 {
+    self->file_links = g_hash_table_new (NULL, NULL);
+
     g_signal_connect (nautilus_tag_manager_get (),
                       "starred-changed",
                       (GCallback) on_starred_files_changed,
@@ -20,6 +20,7 @@
 
 #include "nautilus-tag-manager.h"
 #include "nautilus-file.h"
+#include "nautilus-file-private.h"
 #include "nautilus-file-undo-operations.h"
 #include "nautilus-file-undo-manager.h"
 #include "nautilus-tracker-utilities.h"
@@ -88,6 +89,19 @@ static guint signals[LAST_SIGNAL];
 /* Limit to 10MB output from Tracker -- surely, nobody has over a million starred files. */
 #define TRACKER2_MAX_IMPORT_BYTES 10 * 1024 * 1024
 
+static void
+emit_starred_changed (NautilusTagManager *self,
+                      GList              *changed_files)
+{
+    /* Before anyone gets to look at them */
+    for (GList *l = changed_files; l != NULL; l = l->next)
+    {
+        nautilus_file_invalidate_starred (l->data);
+    }
+
+    g_signal_emit_by_name (self, "starred-changed", changed_files);
+}
+
 static gchar *
 tracker2_migration_stamp (void)
 {
@@ -187,18 +201,20 @@ nautilus_tag_manager_get_starred_files (NautilusTagManager *self)
     GHashTableIter starred_iter;
     gchar *starred_uri;
     GList *starred_files = NULL;
+    g_autofree gchar *home_uri = g_file_get_uri (self->home);
+    gsize home_uri_length = strlen (home_uri);
 
     g_hash_table_iter_init (&starred_iter, self->starred_file_uris);
     while (g_hash_table_iter_next (&starred_iter, (gpointer *) &starred_uri, NULL))
     {
-        g_autoptr (GFile) location = g_file_new_for_uri (starred_uri);
-        NautilusFile *file = nautilus_file_get (location);
-
         /* Skip files outside $HOME, because we don't support starring these yet.
          * See comment on nautilus_tag_manager_can_star_contents() */
-        if (g_file_has_prefix (location, self->home))
+        if (g_str_has_prefix (starred_uri, home_uri) &&
+            starred_uri[home_uri_length] == '/' &&
+            starred_uri[home_uri_length + 1] != '\0')
         {
-            starred_files = g_list_prepend (starred_files, file);
+            starred_files = g_list_prepend (starred_files,
+                                            nautilus_file_get_by_uri (starred_uri));
         }
     }
 
@@ -232,7 +248,7 @@ on_get_starred_files_cursor_callback (GObject      *object,
 
         if (self->pending_changed_files != NULL)
         {
-            g_signal_emit_by_name (self, "starred-changed", self->pending_changed_files);
+            emit_starred_changed (self, self->pending_changed_files);
             g_clear_pointer (&self->pending_changed_files, nautilus_file_list_free);
         }
 
@@ -454,7 +470,7 @@ on_tracker_notifier_events (TrackerNotifier *notifier,
     TrackerSparqlCursor *cursor;
     gboolean query_has_results = FALSE;
     gboolean starred;
-    GList *changed_files;
+    g_autolist (NautilusFile) changed_files = NULL;
     NautilusFile *changed_file;
 
     self = NAUTILUS_TAG_MANAGER (user_data);
@@ -465,27 +481,38 @@ on_tracker_notifier_events (TrackerNotifier *notifier,
 
         file_url = tracker_notifier_event_get_urn (event);
         changed_file = NULL;
+        cursor = NULL;
 
         g_debug ("Got event for file %s", file_url);
 
-        tracker_sparql_statement_bind_string (self->query_file_is_starred, "file", file_url);
-        cursor = tracker_sparql_statement_execute (self->query_file_is_starred,
-                                                   NULL,
-                                                   &error);
-
-        if (cursor)
+        if (tracker_notifier_event_get_event_type (event) == TRACKER_NOTIFIER_EVENT_DELETE)
         {
-            query_has_results = tracker_sparql_cursor_next (cursor, NULL, &error);
+            /* The file is gone from the database, so it is not starred anymore */
+            starred = FALSE;
         }
-
-        if (error || !cursor || !query_has_results)
+        else
         {
-            g_warning ("Couldn't query the starred files database: '%s'", error ? error->message : "(null error)");
-            g_clear_error (&error);
-            return;
+            tracker_sparql_statement_bind_string (self->query_file_is_starred, "file", file_url);
+            cursor = tracker_sparql_statement_execute (self->query_file_is_starred,
+                                                       NULL,
+                                                       &error);
+
+            if (cursor)
+            {
+                query_has_results = tracker_sparql_cursor_next (cursor, NULL, &error);
+            }
+
+            if (error || !cursor || !query_has_results)
+            {
+                g_warning ("Couldn't query the starred files database: '%s'", error ? error->message : "(null error)");
+                g_clear_error (&error);
+                g_clear_object (&cursor);
+                break;
+            }
+
+            starred = tracker_sparql_cursor_get_boolean (cursor, 0);
         }
 
-        starred = tracker_sparql_cursor_get_boolean (cursor, 0);
         if (starred)
         {
             gboolean inserted = g_hash_table_add (self->starred_file_uris, g_strdup (file_url));
@@ -509,14 +536,16 @@ on_tracker_notifier_events (TrackerNotifier *notifier,
 
         if (changed_file)
         {
-            changed_files = g_list_prepend (NULL, changed_file);
-
-            g_signal_emit_by_name (self, "starred-changed", changed_files);
-
-            nautilus_file_list_free (changed_files);
+            changed_files = g_list_prepend (changed_files, changed_file);
         }
 
-        g_object_unref (cursor);
+        g_clear_object (&cursor);
+    }
+
+    /* Once for the whole batch, so that listeners only update once */
+    if (changed_files != NULL)
+    {
+        emit_starred_changed (self, changed_files);
     }
 }
 
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2026 The GNOME project contributors
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <config.h>
+#include "nautilus-thumbnail-cache.h"
+
+#include "nautilus-ui-utilities.h"
+
+/**
+ * The thumbnail cache keeps the paintables built for thumbnails, ready to be
+ * rendered: the texture, clipped to rounded corners and framed if it is a
+ * video. Returning the same paintable (and so the same texture) every time
+ * a cell updates its icon lets the renderer reuse the texture it already
+ * uploaded, instead of uploading a new one.
+ *
+ * Entries are keyed by the thumbnail and the size they are rendered at. Cells
+ * only ask for the few icon sizes of the zoom levels, so each thumbnail ends
+ * up in a handful of size buckets at most. The least recently used entries
+ * are dropped once the textures take more than
+ * %NAUTILUS_THUMBNAIL_CACHE_BUDGET_BYTES.
+ *
+ * A texture shares the pixels of the pixbuf it is built from, and so keeps
+ * it alive. When a file drops its thumbnail, the paintables built from it
+ * are dropped as well, see nautilus_thumbnail_cache_forget_pixbuf(), so that
+ * the memory budget of the loaded thumbnails holds for their pixels.
+ *
+ * This is only used from the main thread.
+ */
+
+typedef struct
+{
+    char *path;
+    gint64 mtime;
+    int size;
+    int scale;
+    gboolean frame_video;
+} ThumbnailKey;
+
+typedef struct
+{
+    ThumbnailKey key;
+    GdkPaintable *paintable;
+    GdkPixbuf *pixbuf; /* unowned, the texture keeps it alive */
+    gsize cost;
+    GList *link;
+} CacheEntry;
+
+static GHashTable *cache = NULL;
+/* Most recently used first */
+static GQueue lru = G_QUEUE_INIT;
+static gsize cache_cost = 0;
+/* The entries built from each pixbuf */
+static GHashTable *pixbuf_entries = NULL;
+
+static guint
+thumbnail_key_hash (gconstpointer data)
+{
+    const ThumbnailKey *key = data;
+
+    return g_str_hash (key->path) ^ g_int64_hash (&key->mtime) ^
+           (key->size << 8) ^ (key->scale << 4) ^ key->frame_video;
+}
+
+static gboolean
+thumbnail_key_equal (gconstpointer a,
+                     gconstpointer b)
+{
+    const ThumbnailKey *key_a = a;
+    const ThumbnailKey *key_b = b;
+
+    return key_a->mtime == key_b->mtime &&
+           key_a->size == key_b->size &&
+           key_a->scale == key_b->scale &&
+           key_a->frame_video == key_b->frame_video &&
+           g_str_equal (key_a->path, key_b->path);
+}
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+    GList *entries;
+
+    g_queue_delete_link (&lru, entry->link);
+    cache_cost -= entry->cost;
+
+    entries = g_list_remove (g_hash_table_lookup (pixbuf_entries, entry->pixbuf), entry);
+    if (entries == NULL)
+    {
+        g_hash_table_remove (pixbuf_entries, entry->pixbuf);
+    }
+    else
+    {
+        g_hash_table_insert (pixbuf_entries, entry->pixbuf, entries);
+    }
+
+    g_free (entry->key.path);
+    g_object_unref (entry->paintable);
+    g_free (entry);
+}
+
+static GdkPaintable *
+build_paintable (GdkPixbuf *pixbuf,
+                 int        size,
+                 int        scale,
+                 gboolean   frame_video)
+{
+    double width = gdk_pixbuf_get_width (pixbuf) / scale;
+    double height = gdk_pixbuf_get_height (pixbuf) / scale;
+    g_autoptr (GdkTexture) texture = gdk_texture_new_for_pixbuf (pixbuf);
+    g_autoptr (GtkSnapshot) snapshot = gtk_snapshot_new ();
+    GskRoundedRect rounded_rect;
+
+    if (MAX (width, height) > size)
+    {
+        float scale_down_factor = MAX (width, height) / size;
+
+        width = width / scale_down_factor;
+        height = height / scale_down_factor;
+    }
+
+    gsk_rounded_rect_init_from_rect (&rounded_rect,
+                                     &GRAPHENE_RECT_INIT (0, 0, width, height),
+                                     2 /* radius*/);
+    gtk_snapshot_push_rounded_clip (snapshot, &rounded_rect);
+
+    gdk_paintable_snapshot (GDK_PAINTABLE (texture),
+                            GDK_SNAPSHOT (snapshot),
+                            width, height);
+
+    if (frame_video)
+    {
+        nautilus_ui_frame_video (snapshot, width, height);
+    }
+
+    gtk_snapshot_pop (snapshot); /* End rounded clip */
+
+    g_debug ("Built thumbnail paintable, at size %d %d",
+             (int) (width), (int) (height));
+
+    return gtk_snapshot_to_paintable (snapshot, NULL);
+}
+
+/**
+ * nautilus_thumbnail_cache_get_paintable:
+ * @thumbnail_path: (nullable): the path the thumbnail was loaded from, or
+ *     %NULL if it can't be cached
+ * @mtime: the modification time of the thumbnailed file
+ * @pixbuf: the thumbnail
+ * @size: the icon size to render the thumbnail at
+ * @scale: the scale factor of the display
+ * @frame_video: whether to draw a video frame around the thumbnail
+ *
+ * Returns: (transfer full): a paintable for @pixbuf, from the cache if it
+ *     was requested before.
+ */
+GdkPaintable *
+nautilus_thumbnail_cache_get_paintable (const char *thumbnail_path,
+                                        time_t      mtime,
+                                        GdkPixbuf  *pixbuf,
+                                        int         size,
+                                        int         scale,
+                                        gboolean    frame_video)
+{
+    ThumbnailKey lookup_key;
+    CacheEntry *entry;
+    GdkPaintable *paintable;
+    gsize cost;
+
+    if (thumbnail_path == NULL)
+    {
+        return build_paintable (pixbuf, size, scale, frame_video);
+    }
+
+    if (cache == NULL)
+    {
+        cache = g_hash_table_new_full (thumbnail_key_hash, thumbnail_key_equal,
+                                       NULL, (GDestroyNotify) cache_entry_free);
+        pixbuf_entries = g_hash_table_new (NULL, NULL);
+    }
+
+    lookup_key.path = (char *) thumbnail_path;
+    lookup_key.mtime = mtime;
+    lookup_key.size = size;
+    lookup_key.scale = scale;
+    lookup_key.frame_video = frame_video;
+
+    entry = g_hash_table_lookup (cache, &lookup_key);
+    if (entry != NULL)
+    {
+        g_queue_unlink (&lru, entry->link);
+        g_queue_push_head_link (&lru, entry->link);
+
+        return g_object_ref (entry->paintable);
+    }
+
+    paintable = build_paintable (pixbuf, size, scale, frame_video);
+    cost = gdk_pixbuf_get_byte_length (pixbuf);
+    if (cost > NAUTILUS_THUMBNAIL_CACHE_BUDGET_BYTES)
+    {
+        return paintable;
+    }
+
+    entry = g_new0 (CacheEntry, 1);
+    entry->key = lookup_key;
+    entry->key.path = g_strdup (thumbnail_path);
+    entry->paintable = g_object_ref (paintable);
+    entry->pixbuf = pixbuf;
+    entry->cost = cost;
+
+    g_hash_table_insert (pixbuf_entries, pixbuf,
+                         g_list_prepend (g_hash_table_lookup (pixbuf_entries, pixbuf), entry));
+
+    g_queue_push_head (&lru, entry);
+    entry->link = lru.head;
+    cache_cost += cost;
+
+    g_hash_table_add (cache, entry);
+
+    while (cache_cost > NAUTILUS_THUMBNAIL_CACHE_BUDGET_BYTES)
+    {
+        CacheEntry *oldest = g_queue_peek_tail (&lru);
+
+        g_hash_table_remove (cache, &oldest->key);
+    }
+
+    return paintable;
+}
+
+/**
+ * nautilus_thumbnail_cache_forget_pixbuf:
+ * @pixbuf: a thumbnail which is being dropped
+ *
+ * Drops the paintables built from @pixbuf, which would keep its pixels alive.
+ */
+void
+nautilus_thumbnail_cache_forget_pixbuf (GdkPixbuf *pixbuf)
+{
+    GList *entries;
+
+    if (cache == NULL)
+    {
+        return;
+    }
+
+    /* Removing an entry updates the list */
+    while ((entries = g_hash_table_lookup (pixbuf_entries, pixbuf)) != NULL)
+    {
+        CacheEntry *entry = entries->data;
+
+        g_hash_table_remove (cache, &entry->key);
+    }
+}
+
+void
+nautilus_thumbnail_cache_clear (void)
+{
+    if (cache != NULL)
+    {
+        g_hash_table_remove_all (cache);
+    }
+}
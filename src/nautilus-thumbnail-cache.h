@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2026 The GNOME project contributors
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* How much texture memory the cached thumbnails may take */
+#define NAUTILUS_THUMBNAIL_CACHE_BUDGET_BYTES (128 * 1024 * 1024)
+
+GdkPaintable *nautilus_thumbnail_cache_get_paintable (const char *thumbnail_path,
+                                                      time_t      mtime,
+                                                      GdkPixbuf  *pixbuf,
+                                                      int         size,
+                                                      int         scale,
+                                                      gboolean    frame_video);
+void          nautilus_thumbnail_cache_forget_pixbuf (GdkPixbuf  *pixbuf);
+void          nautilus_thumbnail_cache_clear         (void);
+
+G_END_DECLS
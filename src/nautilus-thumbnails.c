@@ -39,6 +39,9 @@
 #include <unistd.h>
 #include <signal.h>
 #include <libgnome-desktop/gnome-desktop-thumbnail.h>
+#ifdef HAVE_GEXIV2
+#include <gexiv2/gexiv2.h>
+#endif
 
 #include "nautilus-file-private.h"
 
@@ -48,13 +51,29 @@
 /* Cool-off period between last file modification time and thumbnail creation */
 #define THUMBNAIL_CREATION_DELAY_SECS 3
 
-/* This specific number of processors seems to work ok even on relatively slow
- * computers. However, this might not be the effective number of processors
- * used simultaneously because of main thread load and I/O bounds. */
-#define MAX_THUMBNAILING_THREADS ceil (g_get_num_processors () / 2);
+/* The generation of thumbnails is mostly CPU bound, so there is no point in
+ * running more of them than there are processors. How many of them to run at
+ * once is tuned by measuring how long they take, starting from half the
+ * processors, which works ok even on relatively slow computers. */
+#define MAX_THUMBNAILING_THREADS (g_get_num_processors ())
+#define INITIAL_THUMBNAILING_THREADS ((guint) ceil (g_get_num_processors () / 2.0))
+
+/* How many thumbnails are generated before deciding whether running more or
+ * less of them at once is faster */
+#define CONCURRENCY_SAMPLES 8
 
 static gboolean thumbnail_starter_cb (gpointer data);
 
+/* Thumbnails are generated for the files in mapped cells first, then for
+ * those in unmapped cells, then for any other file. */
+typedef enum
+{
+    THUMBNAIL_PRIORITY_VISIBLE,
+    THUMBNAIL_PRIORITY_PREFETCH,
+    THUMBNAIL_PRIORITY_BACKGROUND,
+    N_THUMBNAIL_PRIORITIES
+} ThumbnailPriority;
+
 /* structure used for making thumbnails, associating a uri with where the thumbnail is to be stored */
 
 typedef struct
@@ -64,9 +83,23 @@ typedef struct
     time_t original_file_mtime;
     time_t updated_file_mtime;
 
+    ThumbnailPriority priority;
+    /* Whether the thumbnail is being generated, as opposed to saved */
+    gboolean generating;
+    /* When the thumbnailer was started, 0 if it wasn't, see tune_max_threads() */
+    gint64 start_time;
+    guint concurrency;
+
     GCancellable *cancellable;
 } NautilusThumbnailInfo;
 
+/* How many cells are bound to a file, and how many of them are mapped */
+typedef struct
+{
+    guint n_visible;
+    guint n_bound;
+} ThumbnailInterest;
+
 /*
  * Thumbnail thread state.
  */
@@ -75,19 +108,30 @@ typedef struct
  *  idle handler is currently registered. */
 static guint thumbnail_thread_starter_id = 0;
 
-/* The list of NautilusThumbnailInfo structs containing information about the
- *  thumbnails we are making. */
-static NautilusHashQueue *thumbnails_to_make = NULL;
+/* The lists of NautilusThumbnailInfo structs containing information about the
+ *  thumbnails we are making, one per priority. */
+static NautilusHashQueue *thumbnails_to_make[N_THUMBNAIL_PRIORITIES] = { NULL };
 
 /* The icons being currently thumbnailed. */
 static GHashTable *currently_thumbnailing_hash = NULL;
 
+/* The ThumbnailInterest of the files shown in cells. */
+static GHashTable *interests = NULL;
+
 /* The number of currently running threads. */
 static guint running_threads = 0;
 
-/* The maximum number of threads allowed. */
+/* The number of threads allowed, tuned by tune_max_threads(). */
 static guint max_threads = 0;
 
+/* The measurements of the current max_threads */
+static guint n_concurrency_samples = 0;
+static gdouble concurrency_throughput_sum = 0;
+/* The throughput measured with the previous max_threads, and whether it was
+ * smaller or larger than the current one */
+static gdouble last_throughput = 0;
+static gint max_threads_step = 1;
+
 static gboolean
 get_file_mtime (const char *file_uri,
                 time_t     *mtime)
@@ -133,6 +177,9 @@ create_info_key (gpointer item)
     return info->image_uri;
 }
 
+/* The size in pixels of the thumbnails made by the factory */
+static int thumbnail_pixel_size = 0;
+
 static GnomeDesktopThumbnailFactory *
 get_thumbnail_factory (void)
 {
@@ -155,14 +202,17 @@ get_thumbnail_factory (void)
         if (max_scale <= 1)
         {
             size = GNOME_DESKTOP_THUMBNAIL_SIZE_LARGE;
+            thumbnail_pixel_size = 256;
         }
         else if (max_scale <= 2)
         {
             size = GNOME_DESKTOP_THUMBNAIL_SIZE_XLARGE;
+            thumbnail_pixel_size = 512;
         }
         else
         {
             size = GNOME_DESKTOP_THUMBNAIL_SIZE_XXLARGE;
+            thumbnail_pixel_size = 1024;
         }
 
         thumbnail_factory = gnome_desktop_thumbnail_factory_new (size);
@@ -171,17 +221,101 @@ get_thumbnail_factory (void)
     return thumbnail_factory;
 }
 
+#ifdef HAVE_GEXIV2
+static int
+get_thumbnail_pixel_size (void)
+{
+    get_thumbnail_factory ();
+
+    return thumbnail_pixel_size;
+}
+#endif
+
+static void
+ensure_queues (void)
+{
+    if (G_UNLIKELY (currently_thumbnailing_hash == NULL))
+    {
+        for (guint i = 0; i < N_THUMBNAIL_PRIORITIES; i++)
+        {
+            thumbnails_to_make[i] = nautilus_hash_queue_new (g_str_hash, g_str_equal,
+                                                             create_info_key, NULL);
+        }
+        currently_thumbnailing_hash = g_hash_table_new (g_str_hash,
+                                                        g_str_equal);
+    }
+}
+
+static NautilusThumbnailInfo *
+find_queued_info (const char *file_uri)
+{
+    for (guint i = 0; i < N_THUMBNAIL_PRIORITIES; i++)
+    {
+        NautilusThumbnailInfo *info = nautilus_hash_queue_find_item (thumbnails_to_make[i], file_uri);
+
+        if (info != NULL)
+        {
+            return info;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+enqueue_info (NautilusThumbnailInfo *info)
+{
+    nautilus_hash_queue_enqueue (thumbnails_to_make[info->priority], info);
+}
+
+static gboolean
+queues_are_empty (void)
+{
+    for (guint i = 0; i < N_THUMBNAIL_PRIORITIES; i++)
+    {
+        if (!nautilus_hash_queue_is_empty (thumbnails_to_make[i]))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static ThumbnailPriority
+get_file_priority (NautilusFile *file)
+{
+    ThumbnailInterest *interest = NULL;
+
+    if (interests != NULL)
+    {
+        interest = g_hash_table_lookup (interests, file);
+    }
+
+    if (interest == NULL)
+    {
+        return THUMBNAIL_PRIORITY_BACKGROUND;
+    }
+
+    return interest->n_visible > 0 ? THUMBNAIL_PRIORITY_VISIBLE : THUMBNAIL_PRIORITY_PREFETCH;
+}
+
 void
 nautilus_thumbnail_remove_from_queue (const char *file_uri)
 {
     NautilusThumbnailInfo *info;
 
-    if (G_UNLIKELY (thumbnails_to_make == NULL))
+    if (G_UNLIKELY (currently_thumbnailing_hash == NULL))
     {
         return;
     }
 
-    nautilus_hash_queue_remove (thumbnails_to_make, file_uri);
+    info = find_queued_info (file_uri);
+    if (info != NULL)
+    {
+        nautilus_hash_queue_remove (thumbnails_to_make[info->priority], file_uri);
+        free_thumbnail_info (info);
+    }
 
     info = g_hash_table_lookup (currently_thumbnailing_hash, file_uri);
     if (info != NULL)
@@ -190,26 +324,131 @@ nautilus_thumbnail_remove_from_queue (const char *file_uri)
     }
 }
 
-void
-nautilus_thumbnail_prioritize (const char *file_uri)
+static void
+reschedule_thumbnail (NautilusFile *file,
+                      gboolean      was_bound)
 {
-    if (G_UNLIKELY (thumbnails_to_make == NULL))
+    NautilusThumbnailInfo *info;
+    ThumbnailPriority priority;
+    g_autofree char *uri = NULL;
+
+    if (currently_thumbnailing_hash == NULL ||
+        !nautilus_file_is_thumbnailing (file))
+    {
+        return;
+    }
+
+    uri = nautilus_file_get_uri (file);
+    priority = get_file_priority (file);
+
+    if (was_bound && priority == THUMBNAIL_PRIORITY_BACKGROUND)
     {
+        /* It was scrolled far away, or its view was closed. It is requested
+         * again if it is shown again. */
+        info = find_queued_info (uri);
+        if (info != NULL)
+        {
+            g_debug ("(Main Thread) Dropping thumbnail: %s", uri);
+
+            nautilus_hash_queue_remove (thumbnails_to_make[info->priority], uri);
+            free_thumbnail_info (info);
+            nautilus_file_set_is_thumbnailing (file, FALSE);
+            return;
+        }
+
+        info = g_hash_table_lookup (currently_thumbnailing_hash, uri);
+        if (info != NULL && info->generating)
+        {
+            g_debug ("(Main Thread) Cancelling thumbnail: %s", uri);
+
+            g_cancellable_cancel (info->cancellable);
+        }
+
         return;
     }
 
-    nautilus_hash_queue_move_existing_to_head (thumbnails_to_make, file_uri);
+    info = find_queued_info (uri);
+    if (info != NULL && info->priority != priority)
+    {
+        nautilus_hash_queue_remove (thumbnails_to_make[info->priority], uri);
+        info->priority = priority;
+        enqueue_info (info);
+
+        /* The last files shown are the ones the user is looking at */
+        if (priority == THUMBNAIL_PRIORITY_VISIBLE)
+        {
+            nautilus_hash_queue_move_existing_to_head (thumbnails_to_make[priority], uri);
+        }
+    }
 }
 
+/**
+ * nautilus_thumbnail_add_interest:
+ * @file: a #NautilusFile
+ * @visible: whether @file is shown, or only close to be shown
+ *
+ * Tells that a view shows the thumbnail of @file, so that it is generated
+ * before the thumbnails of other files. Every call must be balanced by a call
+ * to nautilus_thumbnail_remove_interest() with the same @visible.
+ */
 void
-nautilus_thumbnail_deprioritize (const char *file_uri)
+nautilus_thumbnail_add_interest (NautilusFile *file,
+                                 gboolean      visible)
 {
-    if (G_UNLIKELY (thumbnails_to_make == NULL))
+    ThumbnailInterest *interest;
+
+    if (G_UNLIKELY (interests == NULL))
     {
-        return;
+        interests = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+    }
+
+    interest = g_hash_table_lookup (interests, file);
+    if (interest == NULL)
+    {
+        interest = g_new0 (ThumbnailInterest, 1);
+        g_hash_table_insert (interests, file, interest);
+    }
+
+    interest->n_bound += 1;
+    if (visible)
+    {
+        interest->n_visible += 1;
+    }
+
+    reschedule_thumbnail (file, FALSE);
+}
+
+/**
+ * nautilus_thumbnail_remove_interest:
+ * @file: a #NautilusFile
+ * @visible: the value passed to nautilus_thumbnail_add_interest()
+ *
+ * Once no view shows @file any longer, its thumbnail is not generated, or
+ * its generation is cancelled.
+ */
+void
+nautilus_thumbnail_remove_interest (NautilusFile *file,
+                                    gboolean      visible)
+{
+    ThumbnailInterest *interest;
+
+    g_return_if_fail (interests != NULL);
+
+    interest = g_hash_table_lookup (interests, file);
+    g_return_if_fail (interest != NULL);
+
+    interest->n_bound -= 1;
+    if (visible)
+    {
+        interest->n_visible -= 1;
     }
 
-    nautilus_hash_queue_move_existing_to_tail (thumbnails_to_make, file_uri);
+    if (interest->n_bound == 0)
+    {
+        g_hash_table_remove (interests, file);
+    }
+
+    reschedule_thumbnail (file, TRUE);
 }
 
 /***************************************************************************
@@ -321,12 +560,9 @@ nautilus_create_thumbnail (NautilusFile *file)
     info->original_file_mtime = file_mtime;
     info->updated_file_mtime = file_mtime;
 
-    if (G_UNLIKELY (thumbnails_to_make == NULL))
-    {
-        thumbnails_to_make = nautilus_hash_queue_new (g_str_hash, g_str_equal, create_info_key, NULL);
-        currently_thumbnailing_hash = g_hash_table_new (g_str_hash,
-                                                        g_str_equal);
-    }
+    info->priority = get_file_priority (file);
+
+    ensure_queues ();
 
     /* Check if it is already in the list of thumbnails to make or
      *  currently being made. */
@@ -334,7 +570,7 @@ nautilus_create_thumbnail (NautilusFile *file)
 
     if (existing_info == NULL)
     {
-        existing_info = nautilus_hash_queue_find_item (thumbnails_to_make, info->image_uri);
+        existing_info = find_queued_info (info->image_uri);
     }
 
     if (existing_info == NULL)
@@ -342,7 +578,7 @@ nautilus_create_thumbnail (NautilusFile *file)
         /* Add the thumbnail to the list. */
         g_debug ("(Main Thread) Adding thumbnail: %s",
                  info->image_uri);
-        nautilus_hash_queue_enqueue (thumbnails_to_make, g_steal_pointer (&info));
+        enqueue_info (g_steal_pointer (&info));
 
         /* If we didn't schedule the thumbnail function to start on idle, do
          *  that now. We don't want to start it until all the other work is
@@ -381,11 +617,13 @@ thumbnail_finalize (NautilusThumbnailInfo *info)
     else
     {
         info->original_file_mtime = info->updated_file_mtime;
+        info->priority = get_file_priority (file);
 
-        nautilus_hash_queue_enqueue (thumbnails_to_make, info);
+        nautilus_file_set_is_thumbnailing (file, TRUE);
+        enqueue_info (info);
     }
 
-    if (nautilus_hash_queue_is_empty (thumbnails_to_make))
+    if (queues_are_empty ())
     {
         g_debug ("(Thumbnail Async Thread) Exiting");
     }
@@ -437,20 +675,57 @@ thumbnail_saved_cb (GObject      *source_object,
     thumbnail_finalize (info);
 }
 
+/* Hill climbing on the throughput: keep changing the number of threads in
+ * the same direction while it makes thumbnailing faster, and turn around when
+ * it makes it slower. */
 static void
-thumbnail_generated_cb (GObject      *source_object,
-                        GAsyncResult *result,
-                        gpointer      data)
+tune_max_threads (NautilusThumbnailInfo *info)
 {
-    GnomeDesktopThumbnailFactory *thumbnail_factory = GNOME_DESKTOP_THUMBNAIL_FACTORY (source_object);
-    NautilusThumbnailInfo *info = data;
-    g_autoptr (GError) error = NULL;
-    g_autoptr (GdkPixbuf) pixbuf = NULL;
+    gdouble latency;
+    gdouble throughput;
+
+    /* Only thumbnails generated by the thumbnailer while all the threads
+     * were busy tell how fast the current number of threads is. Embedded
+     * previews are much faster to load, and would make it look like more
+     * threads keep helping. */
+    if (info->start_time == 0 || info->concurrency != max_threads)
+    {
+        return;
+    }
+
+    latency = (g_get_monotonic_time () - info->start_time) / (gdouble) G_USEC_PER_SEC;
+    concurrency_throughput_sum += info->concurrency / MAX (latency, 0.001);
+    n_concurrency_samples += 1;
+
+    if (n_concurrency_samples < CONCURRENCY_SAMPLES)
+    {
+        return;
+    }
+
+    throughput = concurrency_throughput_sum / n_concurrency_samples;
+    if (throughput < last_throughput)
+    {
+        max_threads_step = -max_threads_step;
+    }
+
+    last_throughput = throughput;
+    n_concurrency_samples = 0;
+    concurrency_throughput_sum = 0;
+    max_threads = CLAMP ((gint) max_threads + max_threads_step, 1, (gint) MAX_THUMBNAILING_THREADS);
+
+    g_debug ("(Main Thread) %.1f thumbnails per second, now using %u threads",
+             throughput, max_threads);
+}
+
+static void
+thumbnail_generated (NautilusThumbnailInfo *info,
+                     GdkPixbuf             *pixbuf,
+                     GError                *error)
+{
+    GnomeDesktopThumbnailFactory *thumbnail_factory = get_thumbnail_factory ();
     g_autoptr (NautilusFile) file = NULL;
 
-    pixbuf = gnome_desktop_thumbnail_factory_generate_thumbnail_finish (thumbnail_factory,
-                                                                        result,
-                                                                        &error);
+    info->generating = FALSE;
 
     if (g_cancellable_is_cancelled (info->cancellable))
     {
@@ -461,6 +736,8 @@ thumbnail_generated_cb (GObject      *source_object,
         return;
     }
 
+    tune_max_threads (info);
+
     file = nautilus_file_get_by_uri (info->image_uri);
 
     if (pixbuf != NULL)
@@ -501,6 +778,270 @@ thumbnail_generated_cb (GObject      *source_object,
     nautilus_file_changed (file);
 }
 
+static void
+thumbnail_generated_cb (GObject      *source_object,
+                        GAsyncResult *result,
+                        gpointer      data)
+{
+    GnomeDesktopThumbnailFactory *thumbnail_factory = GNOME_DESKTOP_THUMBNAIL_FACTORY (source_object);
+    g_autoptr (GError) error = NULL;
+    g_autoptr (GdkPixbuf) pixbuf = NULL;
+
+    pixbuf = gnome_desktop_thumbnail_factory_generate_thumbnail_finish (thumbnail_factory,
+                                                                        result,
+                                                                        &error);
+
+    thumbnail_generated (data, pixbuf, error);
+}
+
+static void
+generate_with_factory (NautilusThumbnailInfo *info)
+{
+    info->start_time = g_get_monotonic_time ();
+    info->concurrency = running_threads;
+
+    gnome_desktop_thumbnail_factory_generate_thumbnail_async (get_thumbnail_factory (),
+                                                              info->image_uri,
+                                                              info->mime_type,
+                                                              info->cancellable,
+                                                              thumbnail_generated_cb,
+                                                              info);
+}
+
+#ifdef HAVE_GEXIV2
+/*
+ * Camera images embed previews, either as the EXIF thumbnail of JPEG images,
+ * or as a full JPEG image in RAW files. Decoding and scaling down a preview
+ * is much faster than decoding the whole image, let alone developing a RAW
+ * file, so they are used when they are at least as large as the thumbnail.
+ */
+
+typedef struct
+{
+    char *path;
+    int size;
+} EmbeddedPreviewRequest;
+
+static void
+embedded_preview_request_free (EmbeddedPreviewRequest *request)
+{
+    g_free (request->path);
+    g_free (request);
+}
+
+static gboolean
+may_have_embedded_preview (NautilusThumbnailInfo *info)
+{
+    return g_str_has_prefix (info->image_uri, "file:") &&
+           (g_content_type_equals (info->mime_type, "image/jpeg") ||
+            g_content_type_is_a (info->mime_type, "image/x-dcraw"));
+}
+
+static GdkPixbuf *
+load_embedded_preview (const char *path,
+                       int         size)
+{
+    GExiv2Metadata *metadata = gexiv2_metadata_new ();
+    GExiv2PreviewProperties **previews;
+    GExiv2PreviewProperties *best = NULL;
+    guint32 best_size = G_MAXUINT32;
+    GExiv2PreviewImage *image = NULL;
+    g_autoptr (GdkPixbufLoader) loader = NULL;
+    g_autoptr (GdkPixbuf) pixbuf = NULL;
+    GExiv2Orientation orientation = GEXIV2_ORIENTATION_UNSPECIFIED;
+    const guint8 *data;
+    guint32 length;
+
+    if (!gexiv2_metadata_open_path (metadata, path, NULL))
+    {
+        g_object_unref (metadata);
+        return NULL;
+    }
+
+    /* The smallest preview which doesn't need to be scaled up */
+    previews = gexiv2_metadata_get_preview_properties (metadata);
+    for (guint i = 0; previews != NULL && previews[i] != NULL; i++)
+    {
+        guint32 preview_size = MAX (gexiv2_preview_properties_get_width (previews[i]),
+                                    gexiv2_preview_properties_get_height (previews[i]));
+
+        if (preview_size >= (guint32) size && preview_size < best_size)
+        {
+            best = previews[i];
+            best_size = preview_size;
+        }
+    }
+
+    if (best != NULL)
+    {
+        image = gexiv2_metadata_try_get_preview_image (metadata, best, NULL);
+        orientation = gexiv2_metadata_try_get_orientation (metadata, NULL);
+    }
+
+    if (image != NULL)
+    {
+        data = gexiv2_preview_image_get_data (image, &length);
+        loader = gdk_pixbuf_loader_new ();
+        if (gdk_pixbuf_loader_write (loader, data, length, NULL) &&
+            gdk_pixbuf_loader_close (loader, NULL))
+        {
+            pixbuf = g_object_ref (gdk_pixbuf_loader_get_pixbuf (loader));
+        }
+        else
+        {
+            gdk_pixbuf_loader_close (loader, NULL);
+        }
+
+        g_object_unref (image);
+    }
+
+    g_object_unref (metadata);
+
+    if (pixbuf == NULL)
+    {
+        return NULL;
+    }
+
+    if (MAX (gdk_pixbuf_get_width (pixbuf), gdk_pixbuf_get_height (pixbuf)) > size)
+    {
+        int width = gdk_pixbuf_get_width (pixbuf);
+        int height = gdk_pixbuf_get_height (pixbuf);
+        double scale = (double) size / MAX (width, height);
+
+        GdkPixbuf *scaled = gdk_pixbuf_scale_simple (pixbuf,
+                                                     MAX (1, width * scale),
+                                                     MAX (1, height * scale),
+                                                     GDK_INTERP_BILINEAR);
+
+        g_object_unref (pixbuf);
+        pixbuf = scaled;
+    }
+
+    /* The orientation is a property of the image, not of its preview */
+    if (orientation > GEXIV2_ORIENTATION_NORMAL &&
+        orientation <= GEXIV2_ORIENTATION_ROT_270)
+    {
+        g_autofree char *value = g_strdup_printf ("%d", orientation);
+
+        gdk_pixbuf_remove_option (pixbuf, "orientation");
+        gdk_pixbuf_set_option (pixbuf, "orientation", value);
+
+        return gdk_pixbuf_apply_embedded_orientation (pixbuf);
+    }
+
+    return g_steal_pointer (&pixbuf);
+}
+
+static void
+embedded_preview_thread (GTask        *task,
+                         gpointer      source_object,
+                         gpointer      task_data,
+                         GCancellable *cancellable)
+{
+    EmbeddedPreviewRequest *request = task_data;
+    GdkPixbuf *pixbuf;
+
+    pixbuf = load_embedded_preview (request->path, request->size);
+    if (pixbuf == NULL)
+    {
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                                 "No embedded preview of at least %d pixels",
+                                 request->size);
+        return;
+    }
+
+    g_task_return_pointer (task, pixbuf, g_object_unref);
+}
+
+static void
+embedded_preview_cb (GObject      *source_object,
+                     GAsyncResult *result,
+                     gpointer      data)
+{
+    NautilusThumbnailInfo *info = data;
+    g_autoptr (GError) error = NULL;
+    g_autoptr (GdkPixbuf) pixbuf = NULL;
+
+    pixbuf = g_task_propagate_pointer (G_TASK (result), &error);
+
+    if (pixbuf == NULL && !g_cancellable_is_cancelled (info->cancellable))
+    {
+        g_debug ("(Thumbnail Async Thread) Falling back to the thumbnailer: %s (%s)",
+                 info->image_uri, error->message);
+
+        generate_with_factory (info);
+        return;
+    }
+
+    thumbnail_generated (info, pixbuf, error);
+}
+
+static gboolean
+ensure_gexiv2_initialized (void)
+{
+    static gsize initialized = 0;
+    static gboolean initialized_ok = FALSE;
+
+    /* Must happen before using it from several threads */
+    if (g_once_init_enter (&initialized))
+    {
+        initialized_ok = gexiv2_initialize ();
+        if (!initialized_ok)
+        {
+            g_warning ("Failed to initialize gexiv2, embedded previews are not used");
+        }
+        g_once_init_leave (&initialized, 1);
+    }
+
+    return initialized_ok;
+}
+#endif
+
+static void
+generate_thumbnail (NautilusThumbnailInfo *info)
+{
+#ifdef HAVE_GEXIV2
+    if (may_have_embedded_preview (info) && ensure_gexiv2_initialized ())
+    {
+        g_autoptr (GTask) task = NULL;
+        EmbeddedPreviewRequest *request;
+
+        request = g_new0 (EmbeddedPreviewRequest, 1);
+        request->path = g_filename_from_uri (info->image_uri, NULL, NULL);
+        request->size = get_thumbnail_pixel_size ();
+
+        if (request->path != NULL)
+        {
+            task = g_task_new (NULL, info->cancellable, embedded_preview_cb, info);
+            g_task_set_task_data (task, request, (GDestroyNotify) embedded_preview_request_free);
+            g_task_run_in_thread (task, embedded_preview_thread);
+            return;
+        }
+
+        embedded_preview_request_free (request);
+    }
+#endif
+
+    generate_with_factory (info);
+}
+
+static NautilusThumbnailInfo *
+pop_next_info (void)
+{
+    for (guint i = 0; i < N_THUMBNAIL_PRIORITIES; i++)
+    {
+        NautilusThumbnailInfo *info = nautilus_hash_queue_peek_head (thumbnails_to_make[i]);
+
+        if (info != NULL)
+        {
+            nautilus_hash_queue_remove (thumbnails_to_make[i], info->image_uri);
+            return info;
+        }
+    }
+
+    return NULL;
+}
+
 /* This function is added as a very low priority idle function to start the
  *  async threads to create any needed thumbnails. It is added with a very
  *  low priority so that it doesn't delay showing the directory in the
@@ -509,9 +1050,8 @@ thumbnail_generated_cb (GObject      *source_object,
 static gboolean
 thumbnail_starter_cb (gpointer data)
 {
-    GnomeDesktopThumbnailFactory *thumbnail_factory;
     NautilusThumbnailInfo *info = NULL;
-    guint ignored_thumbnails = 0;
+    g_autoptr (GList) ignored_thumbnails = NULL;
     time_t current_orig_mtime = 0;
     time_t current_time;
     guint backoff_time;
@@ -519,21 +1059,17 @@ thumbnail_starter_cb (gpointer data)
 
     g_debug ("(Main Thread) Creating thumbnails thread");
 
-    thumbnail_factory = get_thumbnail_factory ();
     thumbnail_thread_starter_id = 0;
 
     if (G_UNLIKELY (max_threads == 0))
     {
-        max_threads = MAX_THUMBNAILING_THREADS
+        max_threads = INITIAL_THUMBNAILING_THREADS;
     }
 
-    /* We loop until the queue is empty, or we reach the thread limit. */
-    while (ignored_thumbnails < nautilus_hash_queue_get_length (thumbnails_to_make) &&
-           running_threads <= max_threads)
+    /* We loop until the queues are empty, or we reach the thread limit. */
+    while (running_threads < max_threads &&
+           (info = pop_next_info ()) != NULL)
     {
-        info = nautilus_hash_queue_peek_head (thumbnails_to_make);
-        nautilus_hash_queue_remove (thumbnails_to_make, info->image_uri);
-
         current_orig_mtime = info->updated_file_mtime;
         time (&current_time);
 
@@ -549,8 +1085,7 @@ thumbnail_starter_cb (gpointer data)
             backoff_time = THUMBNAIL_CREATION_DELAY_SECS - (current_time - current_orig_mtime);
             backoff_time_min = MIN (backoff_time, backoff_time_min);
 
-            nautilus_hash_queue_enqueue (thumbnails_to_make, info);
-            ignored_thumbnails += 1;
+            ignored_thumbnails = g_list_prepend (ignored_thumbnails, info);
             continue;
         }
 
@@ -559,19 +1094,24 @@ thumbnail_starter_cb (gpointer data)
                  info->image_uri);
 
         running_threads += 1;
+        info->generating = TRUE;
         g_hash_table_insert (currently_thumbnailing_hash, info->image_uri, info);
 
-        gnome_desktop_thumbnail_factory_generate_thumbnail_async (thumbnail_factory,
-                                                                  info->image_uri,
-                                                                  info->mime_type,
-                                                                  info->cancellable,
-                                                                  thumbnail_generated_cb,
-                                                                  info);
+        generate_thumbnail (info);
+    }
+
+    /* Put them back in their original order */
+    for (GList *l = ignored_thumbnails; l != NULL; l = l->next)
+    {
+        info = l->data;
+        nautilus_hash_queue_enqueue (thumbnails_to_make[info->priority], info);
+        nautilus_hash_queue_move_existing_to_head (thumbnails_to_make[info->priority],
+                                                   info->image_uri);
     }
 
     /* Reschedule thumbnailing via a change notification */
     if (thumbnail_thread_starter_id == 0 &&
-        ignored_thumbnails > 0)
+        ignored_thumbnails != NULL)
     {
         thumbnail_thread_starter_id = g_timeout_add_seconds (backoff_time_min,
                                                              thumbnail_starter_cb, NULL);
@@ -0,0 +1,339 @@
+/*
+ * Copyright (C) 2026 The GNOME project contributors
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <config.h>
+#include "nautilus-transfer-estimator.h"
+
+#include <math.h>
+
+/**
+ * `NautilusTransferEstimator` predicts the remaining time of a copy from the
+ * progress made so far.
+ *
+ * Copying a file costs a fixed amount of time (creating it, copying its
+ * attributes, closing it) on top of the time needed to write its bytes, so
+ * both are tracked separately: a tree of tiny files is limited by the former,
+ * a few large files by the latter. Both are exponentially weighted moving
+ * averages over the samples, so that the estimate follows the device when its
+ * throughput changes mid-copy, e.g. when its write cache fills up.
+ *
+ * The estimates are remembered per device in the user cache directory, so the
+ * next operation on the same device shows a realistic remaining time from the
+ * start instead of after the first seconds of measurements.
+ */
+struct NautilusTransferEstimator
+{
+    char *device_id;
+
+    gdouble bytes_per_second;
+    gdouble seconds_per_file;
+    gboolean has_seconds_per_file;
+    gboolean has_history;
+
+    gboolean started;
+    gdouble last_elapsed;
+    goffset last_bytes;
+    gint64 last_files;
+    gdouble sampled_time;
+};
+
+/* Shorter samples are dominated by the granularity of the progress reports */
+#define MIN_SAMPLE_SECONDS 0.5
+/* How fast older samples stop mattering */
+#define SMOOTHING_SECONDS 5.0
+/* Don't remember estimates made from too little data */
+#define MIN_HISTORY_SECONDS 5.0
+
+#define HISTORY_BYTES_PER_SECOND_KEY "bytes-per-second"
+#define HISTORY_SECONDS_PER_FILE_KEY "seconds-per-file"
+
+G_LOCK_DEFINE_STATIC (history);
+
+static char *
+get_history_path (void)
+{
+    return g_build_filename (g_get_user_cache_dir (), "nautilus", "transfer-rates", NULL);
+}
+
+static char *
+get_history_group (const char *device_id)
+{
+    /* Brackets would end the group name */
+    return g_strdelimit (g_strdup (device_id), "[]", '_');
+}
+
+static void
+load_history (NautilusTransferEstimator *estimator)
+{
+    g_autoptr (GKeyFile) key_file = g_key_file_new ();
+    g_autofree char *path = get_history_path ();
+    g_autofree char *group = get_history_group (estimator->device_id);
+    gdouble bytes_per_second;
+    gdouble seconds_per_file;
+
+    G_LOCK (history);
+    if (!g_key_file_load_from_file (key_file, path, G_KEY_FILE_NONE, NULL))
+    {
+        G_UNLOCK (history);
+        return;
+    }
+    G_UNLOCK (history);
+
+    bytes_per_second = g_key_file_get_double (key_file, group, HISTORY_BYTES_PER_SECOND_KEY, NULL);
+    seconds_per_file = g_key_file_get_double (key_file, group, HISTORY_SECONDS_PER_FILE_KEY, NULL);
+    if (bytes_per_second > 0 && seconds_per_file >= 0)
+    {
+        estimator->bytes_per_second = bytes_per_second;
+        estimator->seconds_per_file = seconds_per_file;
+        estimator->has_seconds_per_file = TRUE;
+        estimator->has_history = TRUE;
+    }
+}
+
+/**
+ * nautilus_transfer_estimator_new:
+ * @device_id: (nullable): the filesystem id of the destination, or %NULL if
+ *     it is not known, in which case no history is used
+ *
+ * Returns: (transfer full): a new estimator, primed with the throughput
+ *     previously measured for @device_id, if any.
+ */
+NautilusTransferEstimator *
+nautilus_transfer_estimator_new (const char *device_id)
+{
+    NautilusTransferEstimator *estimator;
+
+    estimator = g_new0 (NautilusTransferEstimator, 1);
+    estimator->device_id = g_strdup (device_id);
+
+    if (device_id != NULL)
+    {
+        load_history (estimator);
+    }
+
+    return estimator;
+}
+
+void
+nautilus_transfer_estimator_free (NautilusTransferEstimator *estimator)
+{
+    g_free (estimator->device_id);
+    g_free (estimator);
+}
+
+/**
+ * nautilus_transfer_estimator_update:
+ * @estimator: the estimator
+ * @elapsed: the seconds since the transfer started
+ * @bytes_done: the bytes transferred so far
+ * @files_done: the files completely transferred so far
+ *
+ * Feeds the progress of the transfer to the estimator. It can be called as
+ * often as wanted; samples too close to each other are merged.
+ */
+void
+nautilus_transfer_estimator_update (NautilusTransferEstimator *estimator,
+                                    gdouble                    elapsed,
+                                    goffset                    bytes_done,
+                                    gint64                     files_done)
+{
+    gdouble duration;
+    gdouble weight;
+    goffset bytes;
+    gint64 files;
+
+    /* The job may have been busy with other things before, e.g. scanning
+     * the sources, so only measure from the first progress onwards */
+    if (!estimator->started)
+    {
+        estimator->started = TRUE;
+        estimator->last_elapsed = elapsed;
+        estimator->last_bytes = bytes_done;
+        estimator->last_files = files_done;
+        return;
+    }
+
+    duration = elapsed - estimator->last_elapsed;
+    if (duration < MIN_SAMPLE_SECONDS)
+    {
+        return;
+    }
+
+    bytes = MAX (bytes_done - estimator->last_bytes, 0);
+    files = MAX (files_done - estimator->last_files, 0);
+    estimator->last_elapsed = elapsed;
+    estimator->last_bytes = bytes_done;
+    estimator->last_files = files_done;
+
+    weight = 1.0 - exp (-duration / SMOOTHING_SECONDS);
+    estimator->sampled_time += duration;
+
+    /* Whatever time writing the bytes doesn't explain went into the files.
+     * Until the rate is known, there is no telling them apart, so the bytes
+     * get all of it. */
+    if (files > 0 && (bytes == 0 || estimator->bytes_per_second > 0))
+    {
+        gdouble bytes_time = 0;
+        gdouble sample;
+
+        if (estimator->bytes_per_second > 0)
+        {
+            bytes_time = bytes / estimator->bytes_per_second;
+        }
+        sample = CLAMP (duration - bytes_time, 0, duration) / files;
+
+        /* Without history, the first sample is all we know */
+        estimator->seconds_per_file += (estimator->has_seconds_per_file ? weight : 1.0) *
+                                       (sample - estimator->seconds_per_file);
+        estimator->has_seconds_per_file = TRUE;
+    }
+
+    if (bytes > 0)
+    {
+        gdouble files_time;
+        gdouble sample;
+
+        /* Never let the per-file estimate claim the whole sample, or a single
+         * sample could make the rate arbitrarily large */
+        files_time = MIN (files * estimator->seconds_per_file, duration * 0.9);
+        sample = bytes / (duration - files_time);
+
+        estimator->bytes_per_second += (estimator->bytes_per_second > 0 ? weight : 1.0) *
+                                       (sample - estimator->bytes_per_second);
+    }
+    else if (files == 0)
+    {
+        /* A stall, the device is busy with something */
+        estimator->bytes_per_second -= weight * estimator->bytes_per_second;
+    }
+}
+
+/**
+ * nautilus_transfer_estimator_skip:
+ * @estimator: the estimator
+ * @bytes: the bytes counted as done without being transferred
+ * @files: the files counted as done without being transferred
+ *
+ * Tells the estimator that the next progress includes work which took no
+ * time, such as files which an earlier attempt already copied, so that it
+ * doesn't show up as a burst of throughput.
+ */
+void
+nautilus_transfer_estimator_skip (NautilusTransferEstimator *estimator,
+                                  goffset                    bytes,
+                                  gint64                     files)
+{
+    /* Before the first progress, the base isn't taken yet and will include
+     * them anyway */
+    estimator->last_bytes += bytes;
+    estimator->last_files += files;
+}
+
+/**
+ * nautilus_transfer_estimator_get_rate:
+ * @estimator: the estimator
+ *
+ * Returns: the current estimate of the bytes transferred per second, not
+ *     counting the per file overhead, or 0 if unknown
+ */
+gdouble
+nautilus_transfer_estimator_get_rate (NautilusTransferEstimator *estimator)
+{
+    return estimator->bytes_per_second;
+}
+
+/**
+ * nautilus_transfer_estimator_get_remaining_time:
+ * @estimator: the estimator
+ * @bytes_left: the bytes which are still to be transferred
+ * @files_left: the files which are still to be transferred
+ *
+ * Returns: the estimated seconds until the transfer finishes, or a negative
+ *     value if no estimate is available yet
+ */
+gdouble
+nautilus_transfer_estimator_get_remaining_time (NautilusTransferEstimator *estimator,
+                                                goffset                    bytes_left,
+                                                gint64                     files_left)
+{
+    gdouble remaining;
+
+    if (!estimator->has_seconds_per_file && estimator->bytes_per_second <= 0)
+    {
+        return -1;
+    }
+
+    remaining = MAX (files_left, 0) * estimator->seconds_per_file;
+    if (bytes_left > 0)
+    {
+        if (estimator->bytes_per_second <= 0)
+        {
+            return -1;
+        }
+
+        remaining += bytes_left / estimator->bytes_per_second;
+    }
+
+    return remaining;
+}
+
+/**
+ * nautilus_transfer_estimator_has_history:
+ * @estimator: the estimator
+ *
+ * Returns: whether the estimates are based on previous transfers to the same
+ *     device, and can be trusted before this transfer has been measured.
+ */
+gboolean
+nautilus_transfer_estimator_has_history (NautilusTransferEstimator *estimator)
+{
+    return estimator->has_history;
+}
+
+/**
+ * nautilus_transfer_estimator_save_history:
+ * @estimator: the estimator
+ *
+ * Remembers the current estimates for the device, for the next transfers to
+ * start from. Does nothing if the transfer was too short to measure it.
+ *
+ * This does blocking I/O, so call it from the job thread.
+ */
+void
+nautilus_transfer_estimator_save_history (NautilusTransferEstimator *estimator)
+{
+    g_autoptr (GKeyFile) key_file = NULL;
+    g_autofree char *path = NULL;
+    g_autofree char *dirname = NULL;
+    g_autofree char *group = NULL;
+
+    if (estimator->device_id == NULL ||
+        estimator->sampled_time < MIN_HISTORY_SECONDS ||
+        estimator->bytes_per_second <= 0)
+    {
+        return;
+    }
+
+    key_file = g_key_file_new ();
+    path = get_history_path ();
+    dirname = g_path_get_dirname (path);
+    group = get_history_group (estimator->device_id);
+
+    G_LOCK (history);
+
+    g_key_file_load_from_file (key_file, path, G_KEY_FILE_NONE, NULL);
+    g_key_file_set_double (key_file, group, HISTORY_BYTES_PER_SECOND_KEY,
+                           estimator->bytes_per_second);
+    g_key_file_set_double (key_file, group, HISTORY_SECONDS_PER_FILE_KEY,
+                           estimator->seconds_per_file);
+
+    if (g_mkdir_with_parents (dirname, 0700) == 0)
+    {
+        g_key_file_save_to_file (key_file, path, NULL);
+    }
+
+    G_UNLOCK (history);
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2026 The GNOME project contributors
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct NautilusTransferEstimator NautilusTransferEstimator;
+
+NautilusTransferEstimator *nautilus_transfer_estimator_new                (const char                *device_id);
+void                       nautilus_transfer_estimator_free               (NautilusTransferEstimator *estimator);
+
+void                       nautilus_transfer_estimator_update             (NautilusTransferEstimator *estimator,
+                                                                           gdouble                    elapsed,
+                                                                           goffset                    bytes_done,
+                                                                           gint64                     files_done);
+void                       nautilus_transfer_estimator_skip               (NautilusTransferEstimator *estimator,
+                                                                           goffset                    bytes,
+                                                                           gint64                     files);
+gdouble                    nautilus_transfer_estimator_get_rate           (NautilusTransferEstimator *estimator);
+gdouble                    nautilus_transfer_estimator_get_remaining_time (NautilusTransferEstimator *estimator,
+                                                                           goffset                    bytes_left,
+                                                                           gint64                     files_left);
+gboolean                   nautilus_transfer_estimator_has_history        (NautilusTransferEstimator *estimator);
+void                       nautilus_transfer_estimator_save_history       (NautilusTransferEstimator *estimator);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (NautilusTransferEstimator, nautilus_transfer_estimator_free)
+
+G_END_DECLS
@@ -0,0 +1,550 @@
+/*
+ * Copyright (C) 2026 The GNOME project contributors
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <config.h>
+#include "nautilus-transfer-journal.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+/**
+ * `NautilusTransferJournal` is an append-only log of the progress of a copy
+ * operation, stored in the user cache directory. It is identified by the
+ * sources and the destination of the operation, so restarting the same copy
+ * after it was interrupted finds the journal of the previous attempt and can
+ * skip the files which were already copied, and continue partially copied
+ * files from their last checkpoint.
+ *
+ * Entries are only trusted when the source still has the size and
+ * modification time it had when the entry was written, and the destination
+ * looks like what we left behind: a checkpoint records the size and
+ * modification time of the destination, which must not have changed since.
+ * The copy writes a last checkpoint when it is interrupted, so a copy that
+ * is killed outright starts over rather than trusting whatever was written
+ * after its last checkpoint.
+ *
+ * Each line of the journal has the form:
+ *
+ *     <kind> <size> <mtime> <offset> <dest size> <dest mtime> <source uri> <destination uri>
+ *
+ * where kind is `D` for a created directory, `P` for a checkpoint of a file
+ * being copied and `C` for a completely copied file. Later lines override
+ * earlier lines for the same source. New journals start with one `S` line
+ * per source of the operation, which is only used to tell whether the
+ * journal can still be resumed.
+ *
+ * Only checkpoints are flushed right away. Losing the last few `C` lines
+ * when killed just means copying those files again, so they are flushed at
+ * most once per second.
+ *
+ * Journals are left behind by interrupted operations that are never
+ * restarted, so the journals which weren't touched for a while, or whose
+ * sources are gone, are removed whenever a journal is opened.
+ */
+struct NautilusTransferJournal
+{
+    char *path;
+    FILE *stream;
+    gint64 last_flush;
+
+    /* Only the entries of previous attempts, the ones we write are never
+     * looked up again. */
+    GHashTable *entries;
+};
+
+typedef struct
+{
+    char kind;
+    goffset size;
+    gint64 mtime;
+    goffset offset;
+    goffset dest_size;
+    gint64 dest_mtime;
+    char *dest_uri;
+} JournalEntry;
+
+#define JOURNAL_MAX_AGE_SECONDS (30 * 24 * 60 * 60)
+#define JOURNAL_FLUSH_INTERVAL_USEC G_USEC_PER_SEC
+#define JOURNAL_N_FIELDS 8
+
+#define JOURNAL_SOURCE_ATTRIBUTES \
+    G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+    G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+    G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+
+static void
+journal_entry_free (JournalEntry *entry)
+{
+    g_free (entry->dest_uri);
+    g_free (entry);
+}
+
+static gint64
+get_mtime_usec (GFileInfo *info)
+{
+    return g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+           g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+}
+
+static char *
+get_journal_path (GList *sources,
+                  GFile *destination)
+{
+    g_autoptr (GChecksum) checksum = NULL;
+    g_autofree char *destination_uri = NULL;
+
+    checksum = g_checksum_new (G_CHECKSUM_SHA256);
+    destination_uri = g_file_get_uri (destination);
+    g_checksum_update (checksum, (const guchar *) destination_uri, -1);
+
+    for (GList *l = sources; l != NULL; l = l->next)
+    {
+        g_autofree char *uri = g_file_get_uri (l->data);
+
+        g_checksum_update (checksum, (const guchar *) "\n", 1);
+        g_checksum_update (checksum, (const guchar *) uri, -1);
+    }
+
+    return g_build_filename (g_get_user_cache_dir (), "nautilus", "transfers",
+                             g_checksum_get_string (checksum), NULL);
+}
+
+static void
+load_entries (NautilusTransferJournal *journal)
+{
+    g_autofree char *contents = NULL;
+    g_auto (GStrv) lines = NULL;
+
+    if (!g_file_get_contents (journal->path, &contents, NULL, NULL))
+    {
+        return;
+    }
+
+    lines = g_strsplit (contents, "\n", -1);
+    for (guint i = 0; lines[i] != NULL; i++)
+    {
+        g_auto (GStrv) fields = g_strsplit (lines[i], " ", JOURNAL_N_FIELDS);
+        JournalEntry *entry;
+
+        /* A torn last line is expected if we were killed mid-write */
+        if (g_strv_length (fields) != JOURNAL_N_FIELDS || strlen (fields[0]) != 1 ||
+            fields[0][0] == 'S')
+        {
+            continue;
+        }
+
+        entry = g_new0 (JournalEntry, 1);
+        entry->kind = fields[0][0];
+        entry->size = g_ascii_strtoll (fields[1], NULL, 10);
+        entry->mtime = g_ascii_strtoll (fields[2], NULL, 10);
+        entry->offset = g_ascii_strtoll (fields[3], NULL, 10);
+        entry->dest_size = g_ascii_strtoll (fields[4], NULL, 10);
+        entry->dest_mtime = g_ascii_strtoll (fields[5], NULL, 10);
+        entry->dest_uri = g_strdup (fields[7]);
+
+        g_hash_table_replace (journal->entries, g_strdup (fields[6]), entry);
+    }
+}
+
+static gboolean
+sources_exist (const char *path)
+{
+    g_autoptr (GFile) file = g_file_new_for_path (path);
+    g_autoptr (GFileInputStream) file_stream = NULL;
+    g_autoptr (GDataInputStream) stream = NULL;
+
+    file_stream = g_file_read (file, NULL, NULL);
+    if (file_stream == NULL)
+    {
+        return FALSE;
+    }
+
+    stream = g_data_input_stream_new (G_INPUT_STREAM (file_stream));
+
+    /* The sources are listed first, so we don't have to read the whole file */
+    while (TRUE)
+    {
+        g_autofree char *line = NULL;
+        g_auto (GStrv) fields = NULL;
+        g_autoptr (GFile) source = NULL;
+
+        line = g_data_input_stream_read_line (stream, NULL, NULL, NULL);
+        if (line == NULL)
+        {
+            return TRUE;
+        }
+
+        fields = g_strsplit (line, " ", JOURNAL_N_FIELDS);
+        if (g_strv_length (fields) != JOURNAL_N_FIELDS || g_strcmp0 (fields[0], "S") != 0)
+        {
+            return TRUE;
+        }
+
+        source = g_file_new_for_uri (fields[6]);
+        if (!g_file_query_exists (source, NULL))
+        {
+            return FALSE;
+        }
+    }
+}
+
+static void
+expire_journals (const char *dirname,
+                 const char *current_path)
+{
+    g_autoptr (GDir) dir = NULL;
+    const char *name;
+    gint64 now;
+
+    dir = g_dir_open (dirname, 0, NULL);
+    if (dir == NULL)
+    {
+        return;
+    }
+
+    now = g_get_real_time () / G_USEC_PER_SEC;
+
+    while ((name = g_dir_read_name (dir)) != NULL)
+    {
+        g_autofree char *path = g_build_filename (dirname, name, NULL);
+        GStatBuf buf;
+
+        if (g_strcmp0 (path, current_path) == 0 ||
+            g_stat (path, &buf) != 0)
+        {
+            continue;
+        }
+
+        /* Journals are appended to as the copy progresses, so the
+         * modification time is the last time the operation ran. */
+        if (now - buf.st_mtime > JOURNAL_MAX_AGE_SECONDS ||
+            !sources_exist (path))
+        {
+            g_unlink (path);
+        }
+    }
+}
+
+/**
+ * nautilus_transfer_journal_open:
+ * @sources: the files being copied
+ * @destination: the directory they are copied into
+ *
+ * Opens the journal of a copy operation, loading the entries left by a
+ * previous, interrupted attempt of the same operation.
+ *
+ * Returns: (transfer full) (nullable): the journal, or %NULL if it can't be
+ *     written, in which case the operation runs without one.
+ */
+NautilusTransferJournal *
+nautilus_transfer_journal_open (GList *sources,
+                                GFile *destination)
+{
+    NautilusTransferJournal *journal;
+    g_autofree char *dirname = NULL;
+    g_autofree char *path = NULL;
+    g_autofree char *destination_uri = NULL;
+    FILE *stream;
+    gboolean is_new;
+
+    path = get_journal_path (sources, destination);
+    dirname = g_path_get_dirname (path);
+    if (g_mkdir_with_parents (dirname, 0700) != 0)
+    {
+        return NULL;
+    }
+
+    expire_journals (dirname, path);
+
+    is_new = !g_file_test (path, G_FILE_TEST_EXISTS);
+    stream = g_fopen (path, "a");
+    if (stream == NULL)
+    {
+        return NULL;
+    }
+
+    if (is_new)
+    {
+        destination_uri = g_file_get_uri (destination);
+
+        for (GList *l = sources; l != NULL; l = l->next)
+        {
+            g_autofree char *uri = g_file_get_uri (l->data);
+
+            fprintf (stream, "S 0 0 0 0 0 %s %s\n", uri, destination_uri);
+        }
+        fflush (stream);
+    }
+
+    journal = g_new0 (NautilusTransferJournal, 1);
+    journal->path = g_steal_pointer (&path);
+    journal->stream = stream;
+    journal->last_flush = g_get_monotonic_time ();
+    journal->entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, (GDestroyNotify) journal_entry_free);
+
+    load_entries (journal);
+
+    return journal;
+}
+
+void
+nautilus_transfer_journal_free (NautilusTransferJournal *journal)
+{
+    if (journal->stream != NULL)
+    {
+        fclose (journal->stream);
+    }
+
+    g_hash_table_destroy (journal->entries);
+    g_free (journal->path);
+    g_free (journal);
+}
+
+/**
+ * nautilus_transfer_journal_discard:
+ * @journal: the journal
+ *
+ * Removes the journal from disk, because the operation has completed and
+ * there is nothing to resume anymore.
+ */
+void
+nautilus_transfer_journal_discard (NautilusTransferJournal *journal)
+{
+    g_clear_pointer (&journal->stream, fclose);
+    g_unlink (journal->path);
+    g_hash_table_remove_all (journal->entries);
+}
+
+static JournalEntry *
+find_entry (NautilusTransferJournal *journal,
+            GFile                   *src,
+            GFile                   *dest)
+{
+    g_autofree char *src_uri = NULL;
+    g_autofree char *dest_uri = NULL;
+    JournalEntry *entry;
+
+    /* The common case of an operation which is not being resumed */
+    if (g_hash_table_size (journal->entries) == 0)
+    {
+        return NULL;
+    }
+
+    src_uri = g_file_get_uri (src);
+    dest_uri = g_file_get_uri (dest);
+    entry = g_hash_table_lookup (journal->entries, src_uri);
+    if (entry == NULL || g_strcmp0 (entry->dest_uri, dest_uri) != 0)
+    {
+        return NULL;
+    }
+
+    return entry;
+}
+
+/**
+ * nautilus_transfer_journal_lookup:
+ * @journal: the journal
+ * @src: the file about to be copied
+ * @dest: where it is going to be copied to
+ * @offset: (out): return location for the offset to resume from
+ * @size: (out): return location for the size of @src
+ * @cancellable: (nullable): a #GCancellable
+ *
+ * Checks whether a previous attempt already copied @src to @dest, or copied
+ * it up to @offset. Entries for sources that changed since, or destinations
+ * that were modified or truncated, are ignored.
+ *
+ * Returns: the state of the copy of @src
+ */
+NautilusTransferJournalState
+nautilus_transfer_journal_lookup (NautilusTransferJournal *journal,
+                                  GFile                   *src,
+                                  GFile                   *dest,
+                                  goffset                 *offset,
+                                  goffset                 *size,
+                                  GCancellable            *cancellable)
+{
+    JournalEntry *entry;
+    g_autoptr (GFileInfo) src_info = NULL;
+    g_autoptr (GFileInfo) dest_info = NULL;
+    goffset dest_size;
+
+    entry = find_entry (journal, src, dest);
+    if (entry == NULL || entry->kind == 'D')
+    {
+        return NAUTILUS_TRANSFER_JOURNAL_NONE;
+    }
+
+    src_info = g_file_query_info (src, JOURNAL_SOURCE_ATTRIBUTES,
+                                  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                  cancellable, NULL);
+    dest_info = g_file_query_info (dest, JOURNAL_SOURCE_ATTRIBUTES,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                   cancellable, NULL);
+    if (src_info == NULL || dest_info == NULL ||
+        g_file_info_get_size (src_info) != entry->size ||
+        get_mtime_usec (src_info) != entry->mtime)
+    {
+        return NAUTILUS_TRANSFER_JOURNAL_NONE;
+    }
+
+    dest_size = g_file_info_get_size (dest_info);
+    *size = entry->size;
+
+    if (entry->kind == 'C')
+    {
+        /* The modification time is copied over when the copy completes */
+        if (dest_size != entry->size ||
+            get_mtime_usec (dest_info) / G_USEC_PER_SEC != entry->mtime / G_USEC_PER_SEC)
+        {
+            return NAUTILUS_TRANSFER_JOURNAL_NONE;
+        }
+
+        *offset = entry->size;
+        return NAUTILUS_TRANSFER_JOURNAL_COMPLETE;
+    }
+
+    /* Anything else may have written to the destination since, or we were
+     * killed before we could write the checkpoint of the interruption. */
+    if (dest_size != entry->dest_size ||
+        get_mtime_usec (dest_info) != entry->dest_mtime)
+    {
+        return NAUTILUS_TRANSFER_JOURNAL_NONE;
+    }
+
+    /* Data after the last checkpoint may or may not have hit the disk, so
+     * resume from whatever is the smaller. */
+    *offset = MIN (entry->offset, dest_size);
+
+    return NAUTILUS_TRANSFER_JOURNAL_PARTIAL;
+}
+
+/**
+ * nautilus_transfer_journal_has_directory:
+ * @journal: the journal
+ * @src: a source directory
+ * @dest: the destination directory
+ *
+ * Returns: whether @dest was created by a previous attempt to copy @src, in
+ *     which case it can be merged into without asking.
+ */
+gboolean
+nautilus_transfer_journal_has_directory (NautilusTransferJournal *journal,
+                                         GFile                   *src,
+                                         GFile                   *dest)
+{
+    JournalEntry *entry;
+
+    entry = find_entry (journal, src, dest);
+
+    return entry != NULL && entry->kind == 'D';
+}
+
+static void
+append_entry (NautilusTransferJournal *journal,
+              char                     kind,
+              GFile                   *src,
+              GFile                   *dest,
+              goffset                  size,
+              gint64                   mtime,
+              goffset                  offset,
+              goffset                  dest_size,
+              gint64                   dest_mtime)
+{
+    g_autofree char *src_uri = NULL;
+    g_autofree char *dest_uri = NULL;
+    gint64 now;
+
+    if (journal->stream == NULL)
+    {
+        return;
+    }
+
+    src_uri = g_file_get_uri (src);
+    dest_uri = g_file_get_uri (dest);
+
+    fprintf (journal->stream,
+             "%c %" G_GOFFSET_FORMAT " %" G_GINT64_FORMAT " %" G_GOFFSET_FORMAT
+             " %" G_GOFFSET_FORMAT " %" G_GINT64_FORMAT " %s %s\n",
+             kind, size, mtime, offset, dest_size, dest_mtime, src_uri, dest_uri);
+
+    now = g_get_monotonic_time ();
+    if (kind == 'P' || now - journal->last_flush >= JOURNAL_FLUSH_INTERVAL_USEC)
+    {
+        fflush (journal->stream);
+        journal->last_flush = now;
+    }
+}
+
+void
+nautilus_transfer_journal_record_directory (NautilusTransferJournal *journal,
+                                            GFile                   *src,
+                                            GFile                   *dest)
+{
+    append_entry (journal, 'D', src, dest, 0, 0, 0, 0, 0);
+}
+
+/**
+ * nautilus_transfer_journal_record_checkpoint:
+ * @journal: the journal
+ * @src: the file being copied
+ * @dest: where it is being copied to
+ * @offset: how much of @src was written to @dest
+ * @cancellable: (nullable): a #GCancellable
+ *
+ * Records that @src was copied up to @offset, along with the current state
+ * of @dest, which must still be the same for the copy to be resumed. This
+ * is flushed to disk right away.
+ */
+void
+nautilus_transfer_journal_record_checkpoint (NautilusTransferJournal *journal,
+                                             GFile                   *src,
+                                             GFile                   *dest,
+                                             goffset                  offset,
+                                             GCancellable            *cancellable)
+{
+    g_autoptr (GFileInfo) src_info = NULL;
+    g_autoptr (GFileInfo) dest_info = NULL;
+
+    src_info = g_file_query_info (src, JOURNAL_SOURCE_ATTRIBUTES,
+                                  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                  cancellable, NULL);
+    dest_info = g_file_query_info (dest, JOURNAL_SOURCE_ATTRIBUTES,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                   cancellable, NULL);
+    if (src_info == NULL || dest_info == NULL)
+    {
+        return;
+    }
+
+    append_entry (journal, 'P', src, dest,
+                  g_file_info_get_size (src_info), get_mtime_usec (src_info), offset,
+                  g_file_info_get_size (dest_info), get_mtime_usec (dest_info));
+}
+
+void
+nautilus_transfer_journal_record_complete (NautilusTransferJournal *journal,
+                                           GFile                   *src,
+                                           GFile                   *dest,
+                                           GCancellable            *cancellable)
+{
+    g_autoptr (GFileInfo) info = NULL;
+
+    info = g_file_query_info (src, JOURNAL_SOURCE_ATTRIBUTES,
+                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                              cancellable, NULL);
+    if (info == NULL)
+    {
+        return;
+    }
+
+    /* The destination is checked against the source when resuming */
+    append_entry (journal, 'C', src, dest,
+                  g_file_info_get_size (info), get_mtime_usec (info),
+                  g_file_info_get_size (info), 0, 0);
+}
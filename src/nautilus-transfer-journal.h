@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 The GNOME project contributors
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    NAUTILUS_TRANSFER_JOURNAL_NONE,
+    NAUTILUS_TRANSFER_JOURNAL_PARTIAL,
+    NAUTILUS_TRANSFER_JOURNAL_COMPLETE,
+} NautilusTransferJournalState;
+
+/* Don't bother checkpointing (and resuming) files smaller than this. */
+#define NAUTILUS_TRANSFER_JOURNAL_CHECKPOINT_INTERVAL (32 * 1024 * 1024)
+
+typedef struct NautilusTransferJournal NautilusTransferJournal;
+
+NautilusTransferJournal      *nautilus_transfer_journal_open               (GList                   *sources,
+                                                                            GFile                   *destination);
+void                          nautilus_transfer_journal_free               (NautilusTransferJournal *journal);
+void                          nautilus_transfer_journal_discard            (NautilusTransferJournal *journal);
+
+NautilusTransferJournalState  nautilus_transfer_journal_lookup             (NautilusTransferJournal *journal,
+                                                                            GFile                   *src,
+                                                                            GFile                   *dest,
+                                                                            goffset                 *offset,
+                                                                            goffset                 *size,
+                                                                            GCancellable            *cancellable);
+gboolean                      nautilus_transfer_journal_has_directory      (NautilusTransferJournal *journal,
+                                                                            GFile                   *src,
+                                                                            GFile                   *dest);
+
+void                          nautilus_transfer_journal_record_directory   (NautilusTransferJournal *journal,
+                                                                            GFile                   *src,
+                                                                            GFile                   *dest);
+void                          nautilus_transfer_journal_record_checkpoint  (NautilusTransferJournal *journal,
+                                                                            GFile                   *src,
+                                                                            GFile                   *dest,
+                                                                            goffset                  offset,
+                                                                            GCancellable            *cancellable);
+void                          nautilus_transfer_journal_record_complete    (NautilusTransferJournal *journal,
+                                                                            GFile                   *src,
+                                                                            GFile                   *dest,
+                                                                            GCancellable            *cancellable);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (NautilusTransferJournal, nautilus_transfer_journal_free)
+
+G_END_DECLS
@@ -121,36 +121,158 @@ set_metadata_get_info_callback (GObject      *source_object,
     }
 }
 
+/* Metadata is not written right away: setting it on many files at once, or
+ * setting the same key again and again, would flood the metadata daemon with
+ * one request per call. The values go to the metadata of the file right away,
+ * and to the pending writes of the file, where a newer value for a key
+ * replaces the older one. The files with pending writes are queued, and
+ * written when idle, with a bounded number of requests in flight.
+ *
+ * Each write sets all the pending keys of one file at once. The metadata
+ * daemon takes the keys of a single file per request, so writes are not
+ * batched per directory: it would not save any request.
+ */
+#define MAX_METADATA_WRITES_IN_FLIGHT 8
+
+/* Files with pending writes and no write in flight, each holding a ref */
+static GQueue metadata_write_queue = G_QUEUE_INIT;
+static guint metadata_writes_in_flight = 0;
+static guint write_metadata_idle_id = 0;
+
+static void write_queued_metadata (void);
+
 static void
-set_metadata_callback (GObject      *source_object,
-                       GAsyncResult *result,
-                       gpointer      callback_data)
+metadata_written_callback (GObject      *source_object,
+                           GAsyncResult *result,
+                           gpointer      callback_data)
 {
-    NautilusFile *file;
-    GError *error;
-    gboolean res;
+    NautilusFile *file = callback_data;
+    NautilusFileColdData *cold = file->details->cold;
+    g_autoptr (GError) error = NULL;
 
-    file = callback_data;
-
-    error = NULL;
-    res = g_file_set_attributes_finish (G_FILE (source_object),
-                                        result,
-                                        NULL,
-                                        &error);
+    g_clear_object (&cold->writing_metadata);
+    metadata_writes_in_flight--;
 
-    if (res)
+    if (!g_file_set_attributes_finish (G_FILE (source_object), result, NULL, &error))
     {
+        /* Get back in sync with what is really stored */
         g_file_query_info_async (G_FILE (source_object),
                                  NAUTILUS_FILE_DEFAULT_ATTRIBUTES,
                                  0,
                                  G_PRIORITY_DEFAULT,
                                  NULL,
-                                 set_metadata_get_info_callback, file);
+                                 set_metadata_get_info_callback,
+                                 nautilus_file_ref (file));
+    }
+
+    if (cold->pending_metadata != NULL)
+    {
+        /* Set again while being written */
+        g_queue_push_tail (&metadata_write_queue, g_steal_pointer (&file));
     }
     else
     {
         nautilus_file_unref (file);
-        g_error_free (error);
+    }
+
+    write_queued_metadata ();
+}
+
+static void
+write_queued_metadata (void)
+{
+    while (metadata_writes_in_flight < MAX_METADATA_WRITES_IN_FLIGHT &&
+           !g_queue_is_empty (&metadata_write_queue))
+    {
+        NautilusFile *file = g_queue_pop_head (&metadata_write_queue);
+        NautilusFileColdData *cold = file->details->cold;
+        g_autoptr (GFile) location = nautilus_file_get_location (file);
+
+        cold->writing_metadata = g_steal_pointer (&cold->pending_metadata);
+        metadata_writes_in_flight++;
+
+        g_file_set_attributes_async (location,
+                                     cold->writing_metadata,
+                                     0,
+                                     G_PRIORITY_DEFAULT,
+                                     NULL,
+                                     metadata_written_callback,
+                                     file);
+    }
+}
+
+static gboolean
+write_metadata_idle_callback (gpointer user_data)
+{
+    write_metadata_idle_id = 0;
+    write_queued_metadata ();
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+queue_metadata_write (NautilusFile *file,
+                      GFileInfo    *info)
+{
+    NautilusFileColdData *cold;
+    g_auto (GStrv) attrs = NULL;
+
+    if (nautilus_file_merge_metadata_from_info (file, info))
+    {
+        nautilus_file_changed (file);
+    }
+
+    if (g_strcmp0 (g_getenv ("RUNNING_TESTS"), "TRUE") == 0)
+    {
+        return;
+    }
+
+    cold = nautilus_file_get_cold_data (file);
+    if (cold->pending_metadata == NULL)
+    {
+        cold->pending_metadata = g_file_info_new ();
+
+        /* Otherwise, it is queued again once the current write is done */
+        if (cold->writing_metadata == NULL)
+        {
+            g_queue_push_tail (&metadata_write_queue, nautilus_file_ref (file));
+        }
+    }
+
+    attrs = g_file_info_list_attributes (info, "metadata");
+    for (int i = 0; attrs[i] != NULL; i++)
+    {
+        GFileAttributeType type;
+        gpointer value;
+
+        if (g_file_info_get_attribute_data (info, attrs[i], &type, &value, NULL))
+        {
+            g_file_info_set_attribute (cold->pending_metadata, attrs[i], type, value);
+        }
+    }
+
+    if (write_metadata_idle_id == 0)
+    {
+        write_metadata_idle_id = g_idle_add (write_metadata_idle_callback, NULL);
+    }
+}
+
+/**
+ * nautilus_vfs_file_flush_metadata:
+ *
+ * Writes the queued metadata right away and waits for all the writes to be
+ * done. To be called before exiting.
+ */
+void
+nautilus_vfs_file_flush_metadata (void)
+{
+    g_clear_handle_id (&write_metadata_idle_id, g_source_remove);
+
+    /* Each write starts the next queued ones when it is done */
+    write_queued_metadata ();
+    while (metadata_writes_in_flight > 0)
+    {
+        g_main_context_iteration (NULL, TRUE);
     }
 }
 
@@ -174,20 +296,7 @@ vfs_file_set_metadata (NautilusFile *file,
                                    NULL);
     }
 
-    if (g_strcmp0 (g_getenv ("RUNNING_TESTS"), "TRUE") == 0)
-    {
-        nautilus_file_update_metadata_from_info (file, info);
-        return;
-    }
-
-    g_autoptr (GFile) location = nautilus_file_get_location (file);
-    g_file_set_attributes_async (location,
-                                 info,
-                                 0,
-                                 G_PRIORITY_DEFAULT,
-                                 NULL,
-                                 set_metadata_callback,
-                                 nautilus_file_ref (file));
+    queue_metadata_write (file, info);
 }
 
 static void
@@ -207,20 +316,7 @@ vfs_file_set_metadata_as_list (NautilusFile  *file,
         g_file_info_set_attribute_stringv (info, gio_key, value);
     }
 
-    if (g_strcmp0 (g_getenv ("RUNNING_TESTS"), "TRUE") == 0)
-    {
-        nautilus_file_update_metadata_from_info (file, info);
-        return;
-    }
-
-    g_autoptr (GFile) location = nautilus_file_get_location (file);
-    g_file_set_attributes_async (location,
-                                 info,
-                                 0,
-                                 G_PRIORITY_DEFAULT,
-                                 NULL,
-                                 set_metadata_callback,
-                                 nautilus_file_ref (file));
+    queue_metadata_write (file, info);
 }
 
 static GDateTime *
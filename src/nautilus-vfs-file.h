@@ -47,3 +47,5 @@ typedef struct {
 } NautilusVFSFileClass;
 
 GType   nautilus_vfs_file_get_type (void);
+
+void    nautilus_vfs_file_flush_metadata (void);
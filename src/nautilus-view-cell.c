@@ -5,7 +5,9 @@
  */
 
 #include "nautilus-view-cell.h"
+#include "nautilus-file.h"
 #include "nautilus-list-base.h"
+#include "nautilus-thumbnails.h"
 
 /**
  * NautilusViewCell:
@@ -17,6 +19,13 @@
  *
  * The view is responsible for setting #NautilusViewCell:item. This can be done
  * using a GBinding from #GtkListItem:item to #NautilusViewCell:item.
+ *
+ * The list widgets only create and map cells for the items in view, plus some
+ * margin around them, so subclasses can use
+ * nautilus_view_cell_set_mapped_attributes() to only load expensive file
+ * attributes for those items. When these include the thumbnail, the thumbnails
+ * of the files in mapped cells are generated first, then those of files in
+ * unmapped cells, e.g. in another tab.
  */
 
 typedef struct _NautilusViewCellPrivate NautilusViewCellPrivate;
@@ -30,6 +39,11 @@ struct _NautilusViewCellPrivate
     guint icon_size;
     guint position;
 
+    NautilusFileAttributes mapped_attributes;
+    NautilusFile *monitored_file; /* Owned reference */
+    NautilusFile *thumbnail_file; /* Owned reference */
+    gboolean thumbnail_visible;
+
     gboolean called_once;
 };
 
@@ -48,6 +62,75 @@ enum
 
 static GParamSpec *properties[N_PROPS] = { NULL, };
 
+static void
+update_monitored_file (NautilusViewCell *self)
+{
+    NautilusViewCellPrivate *priv = nautilus_view_cell_get_instance_private (self);
+    NautilusFile *file = NULL;
+
+    if (priv->mapped_attributes != 0 &&
+        priv->item != NULL &&
+        gtk_widget_get_mapped (GTK_WIDGET (self)))
+    {
+        file = nautilus_view_item_get_file (priv->item);
+    }
+
+    if (file == priv->monitored_file)
+    {
+        return;
+    }
+
+    /* Removing the monitor cancels the loading, if still in progress */
+    if (priv->monitored_file != NULL)
+    {
+        nautilus_file_monitor_remove (priv->monitored_file, self);
+        g_clear_pointer (&priv->monitored_file, nautilus_file_unref);
+    }
+
+    if (file != NULL)
+    {
+        priv->monitored_file = nautilus_file_ref (file);
+        nautilus_file_monitor_add (file, self, priv->mapped_attributes);
+    }
+}
+
+static void
+update_thumbnail_interest (NautilusViewCell *self)
+{
+    NautilusViewCellPrivate *priv = nautilus_view_cell_get_instance_private (self);
+    NautilusFile *file = NULL;
+    gboolean visible = FALSE;
+
+    if ((priv->mapped_attributes & NAUTILUS_FILE_ATTRIBUTE_THUMBNAIL) != 0 &&
+        priv->item != NULL)
+    {
+        file = nautilus_view_item_get_file (priv->item);
+        visible = gtk_widget_get_mapped (GTK_WIDGET (self));
+    }
+
+    if (file == priv->thumbnail_file && visible == priv->thumbnail_visible)
+    {
+        return;
+    }
+
+    /* Add the new interest first, so that the thumbnail isn't cancelled when
+     * only the visibility changes */
+    if (file != NULL)
+    {
+        nautilus_file_ref (file);
+        nautilus_thumbnail_add_interest (file, visible);
+    }
+
+    if (priv->thumbnail_file != NULL)
+    {
+        nautilus_thumbnail_remove_interest (priv->thumbnail_file, priv->thumbnail_visible);
+        nautilus_file_unref (priv->thumbnail_file);
+    }
+
+    priv->thumbnail_file = file;
+    priv->thumbnail_visible = visible;
+}
+
 static void
 nautilus_view_cell_get_property (GObject    *object,
                                  guint       prop_id,
@@ -109,7 +192,12 @@ nautilus_view_cell_set_property (GObject      *object,
 
         case PROP_ITEM:
         {
-            g_set_object (&priv->item, g_value_get_object (value));
+            /* Cells are recycled for other items without being unmapped */
+            if (g_set_object (&priv->item, g_value_get_object (value)))
+            {
+                update_monitored_file (self);
+                update_thumbnail_interest (self);
+            }
         }
         break;
 
@@ -132,12 +220,43 @@ nautilus_view_cell_set_property (GObject      *object,
     }
 }
 
+static void
+nautilus_view_cell_map (GtkWidget *widget)
+{
+    GTK_WIDGET_CLASS (nautilus_view_cell_parent_class)->map (widget);
+
+    update_monitored_file (NAUTILUS_VIEW_CELL (widget));
+    update_thumbnail_interest (NAUTILUS_VIEW_CELL (widget));
+}
+
+static void
+nautilus_view_cell_unmap (GtkWidget *widget)
+{
+    GTK_WIDGET_CLASS (nautilus_view_cell_parent_class)->unmap (widget);
+
+    update_monitored_file (NAUTILUS_VIEW_CELL (widget));
+    update_thumbnail_interest (NAUTILUS_VIEW_CELL (widget));
+}
+
 static void
 nautilus_view_cell_init (NautilusViewCell *self)
 {
     gtk_widget_set_name (GTK_WIDGET (self), "NautilusViewCell");
 }
 
+static void
+nautilus_view_cell_dispose (GObject *object)
+{
+    NautilusViewCell *self = NAUTILUS_VIEW_CELL (object);
+    NautilusViewCellPrivate *priv = nautilus_view_cell_get_instance_private (self);
+
+    priv->mapped_attributes = 0;
+    update_monitored_file (self);
+    update_thumbnail_interest (self);
+
+    G_OBJECT_CLASS (nautilus_view_cell_parent_class)->dispose (object);
+}
+
 static void
 nautilus_view_cell_finalize (GObject *object)
 {
@@ -154,7 +273,9 @@ static void
 nautilus_view_cell_class_init (NautilusViewCellClass *klass)
 {
     GObjectClass *object_class = G_OBJECT_CLASS (klass);
+    GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
+    object_class->dispose = nautilus_view_cell_dispose;
     object_class->finalize = nautilus_view_cell_finalize;
     object_class->get_property = nautilus_view_cell_get_property;
     object_class->set_property = nautilus_view_cell_set_property;
@@ -178,6 +299,9 @@ nautilus_view_cell_class_init (NautilusViewCellClass *klass)
                                                    0, G_MAXUINT, GTK_INVALID_LIST_POSITION,
                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
     g_object_class_install_properties (object_class, N_PROPS, properties);
+
+    widget_class->map = nautilus_view_cell_map;
+    widget_class->unmap = nautilus_view_cell_unmap;
 }
 
 gboolean
@@ -194,6 +318,37 @@ nautilus_view_cell_once (NautilusViewCell *self)
     return TRUE;
 }
 
+/**
+ * nautilus_view_cell_set_mapped_attributes:
+ * @self: a #NautilusViewCell
+ * @attributes: the attributes to load
+ *
+ * Keeps @attributes loaded for the file of #NautilusViewCell:item while the
+ * cell is mapped, i.e. while the item is in or near the visible part of the
+ * view. Loading them is cancelled when the cell is unmapped or recycled for
+ * another item.
+ */
+void
+nautilus_view_cell_set_mapped_attributes (NautilusViewCell       *self,
+                                          NautilusFileAttributes  attributes)
+{
+    g_return_if_fail (NAUTILUS_IS_VIEW_CELL (self));
+
+    NautilusViewCellPrivate *priv = nautilus_view_cell_get_instance_private (self);
+
+    if (priv->mapped_attributes == attributes)
+    {
+        return;
+    }
+
+    /* Forget the monitor so the next update replaces it */
+    priv->mapped_attributes = 0;
+    update_monitored_file (self);
+    priv->mapped_attributes = attributes;
+    update_monitored_file (self);
+    update_thumbnail_interest (self);
+}
+
 guint
 nautilus_view_cell_get_position (NautilusViewCell *self)
 {
@@ -232,6 +387,6 @@ nautilus_view_cell_get_item (NautilusViewCell *self)
     /* This gets a full reference. */
     g_object_get (self, "item", &item, NULL);
 
-    /* Return full reference for consistency with gtk_tree_list_row_get_item() */
+    /* Return full reference for consistency with nautilus_view_model_get_item_for_row() */
     return item;
 }
@@ -7,17 +7,76 @@ struct _NautilusViewModel
 {
     GObject parent_instance;
 
+    /* The files of the model, mapped to their sort hash */
     GHashTable *map_files_to_model;
     GHashTable *directory_reverse_map;
+    /* The view items which currently exist, by file */
+    GHashTable *items;
 
     GtkTreeListModel *tree_model;
     GtkSortListModel *sort_model;
     GtkMultiSelection *selection_model;
 
     gboolean expand_as_a_tree;
-    GList *cut_files;
+    GHashTable *cut_files;
+    GHashTable *loading_files;
 };
 
+/* The stores hold files. A view item is only made once something asks for
+ * the item of a row, usually a cell being bound to it, and is attached to
+ * the row. The row and its item go away once the row is scrolled out of
+ * view and unselected. */
+typedef struct
+{
+    NautilusViewModel *model;
+    NautilusFile *file;
+    NautilusViewItem *item;
+} LiveItem;
+
+static GQuark row_item_quark;
+
+static void
+on_item_finalized (gpointer  data,
+                   GObject  *where_the_object_was)
+{
+    LiveItem *live = data;
+
+    g_hash_table_remove (live->model->items, live->file);
+}
+
+static NautilusViewItem *
+get_or_create_item (NautilusViewModel *self,
+                    NautilusFile      *file)
+{
+    LiveItem *live;
+
+    live = g_hash_table_lookup (self->items, file);
+    if (live != NULL)
+    {
+        return g_object_ref (live->item);
+    }
+
+    live = g_new (LiveItem, 1);
+    live->model = self;
+    live->file = file;
+    live->item = nautilus_view_item_new (file);
+
+    /* The state which outlives the items is kept by the model. */
+    if (g_hash_table_contains (self->cut_files, file))
+    {
+        nautilus_view_item_set_cut (live->item, TRUE);
+    }
+    if (g_hash_table_contains (self->loading_files, file))
+    {
+        nautilus_view_item_set_loading (live->item, TRUE);
+    }
+
+    g_object_weak_ref (G_OBJECT (live->item), on_item_finalized, live);
+    g_hash_table_insert (self->items, file, live);
+
+    return live->item;
+}
+
 static inline GListStore *
 get_directory_store (NautilusViewModel *self,
                      NautilusFile      *directory)
@@ -195,6 +254,19 @@ dispose (GObject *object)
 
     g_clear_object (&self->tree_model);
 
+    if (self->items != NULL)
+    {
+        GHashTableIter iter;
+        LiveItem *live;
+
+        g_hash_table_iter_init (&iter, self->items);
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &live))
+        {
+            g_object_weak_unref (G_OBJECT (live->item), on_item_finalized, live);
+        }
+        g_clear_pointer (&self->items, g_hash_table_destroy);
+    }
+
     G_OBJECT_CLASS (nautilus_view_model_parent_class)->dispose (object);
 }
 
@@ -208,7 +280,8 @@ finalize (GObject *object)
     g_hash_table_destroy (self->map_files_to_model);
     g_hash_table_destroy (self->directory_reverse_map);
 
-    g_clear_list (&self->cut_files, g_object_unref);
+    g_hash_table_destroy (self->cut_files);
+    g_hash_table_destroy (self->loading_files);
 }
 
 static void
@@ -264,7 +337,7 @@ create_model_func (GObject           *item,
     NautilusFile *file;
     GListStore *store;
 
-    file = nautilus_view_item_get_file (NAUTILUS_VIEW_ITEM (item));
+    file = NAUTILUS_FILE (item);
     if (!nautilus_file_is_directory (file))
     {
         return NULL;
@@ -273,7 +346,7 @@ create_model_func (GObject           *item,
     store = g_hash_table_lookup (self->directory_reverse_map, file);
     if (store == NULL)
     {
-        store = g_list_store_new (NAUTILUS_TYPE_VIEW_ITEM);
+        store = g_list_store_new (NAUTILUS_TYPE_FILE);
         g_hash_table_insert (self->directory_reverse_map, file, store);
     }
 
@@ -287,7 +360,7 @@ constructed (GObject *object)
 
     G_OBJECT_CLASS (nautilus_view_model_parent_class)->constructed (object);
 
-    self->tree_model = gtk_tree_list_model_new (G_LIST_MODEL (g_list_store_new (NAUTILUS_TYPE_VIEW_ITEM)),
+    self->tree_model = gtk_tree_list_model_new (G_LIST_MODEL (g_list_store_new (NAUTILUS_TYPE_FILE)),
                                                 FALSE, FALSE,
                                                 (GtkTreeListModelCreateModelFunc) create_model_func,
                                                 self, NULL);
@@ -296,6 +369,9 @@ constructed (GObject *object)
 
     self->map_files_to_model = g_hash_table_new (NULL, NULL);
     self->directory_reverse_map = g_hash_table_new_full (NULL, NULL, NULL, g_object_unref);
+    self->items = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+    self->cut_files = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+    self->loading_files = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
 
     g_signal_connect_swapped (self->sort_model, "items-changed",
                               G_CALLBACK (g_list_model_items_changed), self);
@@ -323,6 +399,8 @@ nautilus_view_model_class_init (NautilusViewModelClass *klass)
                              G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
 
     g_object_class_install_properties (object_class, N_PROPS, properties);
+
+    row_item_quark = g_quark_from_static_string ("nautilus-view-model-row-item");
 }
 
 static void
@@ -385,66 +463,157 @@ nautilus_view_model_sort (NautilusViewModel *self)
         gtk_sorter_changed (sorter, GTK_SORTER_CHANGE_DIFFERENT);
     }
 }
-
-GList *
-nautilus_view_model_get_sorted_items_for_files (NautilusViewModel *self,
-                                                GList             *files)
+/**
+ * nautilus_view_model_get_item_for_row:
+ * @self: the model
+ * @row: a row of the model
+ *
+ * Gets the view item of @row, making it if there is none yet. The item lives
+ * as long as the row, or as long as anything else holds it.
+ *
+ * Returns: (transfer full) (nullable): the item of @row
+ */
+NautilusViewItem *
+nautilus_view_model_get_item_for_row (NautilusViewModel *self,
+                                      GtkTreeListRow    *row)
 {
-    GList *items = NULL;
+    NautilusViewItem *item;
 
-    for (GList *l = files; l != NULL; l = l->next)
+    item = g_object_get_qdata (G_OBJECT (row), row_item_quark);
+    if (item == NULL)
     {
-        NautilusViewItem *item;
+        g_autoptr (NautilusFile) file = gtk_tree_list_row_get_item (row);
 
-        item = nautilus_view_model_get_item_for_file (self, l->data);
-        if (item != NULL)
+        if (file == NULL)
         {
-            items = g_list_prepend (items, item);
+            /* The row has been destroyed */
+            return NULL;
         }
+
+        item = get_or_create_item (self, file);
+        g_object_set_qdata_full (G_OBJECT (row), row_item_quark,
+                                 item, g_object_unref);
     }
 
-    return g_list_sort_with_data (g_list_copy (items), compare_data_func, self);
+    return g_object_ref (item);
 }
 
+/* Only the items which exist are returned. The files which aren't shown
+ * have none, use nautilus_view_model_has_file() to tell whether a file is
+ * in the model. */
 NautilusViewItem *
 nautilus_view_model_get_item_for_file (NautilusViewModel *self,
                                        NautilusFile      *file)
 {
-    return g_hash_table_lookup (self->map_files_to_model, file);
+    LiveItem *live = g_hash_table_lookup (self->items, file);
+
+    return live != NULL ? live->item : NULL;
+}
+
+gboolean
+nautilus_view_model_has_file (NautilusViewModel *self,
+                              NautilusFile      *file)
+{
+    return g_hash_table_contains (self->map_files_to_model, file);
+}
+
+guint
+nautilus_view_model_get_sort_hash (NautilusViewModel *self,
+                                   NautilusFile      *file)
+{
+    return GPOINTER_TO_UINT (g_hash_table_lookup (self->map_files_to_model, file));
 }
 
+/* The view tells files that moved in the sort order apart by a hash of
+ * what they are sorted by, see nautilus_file_hash_for_sort_by_attribute_q() */
 void
-nautilus_view_model_remove_items (NautilusViewModel *self,
-                                  GList             *items,
+nautilus_view_model_set_sort_hash (NautilusViewModel *self,
+                                   NautilusFile      *file,
+                                   guint              sort_hash)
+{
+    if (g_hash_table_contains (self->map_files_to_model, file))
+    {
+        g_hash_table_insert (self->map_files_to_model, file, GUINT_TO_POINTER (sort_hash));
+    }
+}
+
+void
+nautilus_view_model_set_loading (NautilusViewModel *self,
+                                 NautilusFile      *file,
+                                 gboolean           loading)
+{
+    NautilusViewItem *item = nautilus_view_model_get_item_for_file (self, file);
+
+    if (loading)
+    {
+        g_hash_table_add (self->loading_files, g_object_ref (file));
+    }
+    else
+    {
+        g_hash_table_remove (self->loading_files, file);
+    }
+
+    if (item != NULL)
+    {
+        nautilus_view_item_set_loading (item, loading);
+    }
+}
+
+static void
+forget_file (NautilusViewModel *self,
+             NautilusFile      *file)
+{
+    g_hash_table_remove (self->map_files_to_model, file);
+    g_hash_table_remove (self->cut_files, file);
+    g_hash_table_remove (self->loading_files, file);
+    if (nautilus_file_is_directory (file))
+    {
+        g_hash_table_remove (self->directory_reverse_map, file);
+    }
+}
+
+void
+nautilus_view_model_remove_files (NautilusViewModel *self,
+                                  GList             *files,
                                   NautilusDirectory *directory)
 {
     g_autoptr (NautilusFile) parent = nautilus_directory_get_corresponding_file (directory);
     GListStore *dir_store = get_directory_store (self, parent);
+    guint n_items = g_list_model_get_n_items (G_LIST_MODEL (dir_store));
     guint new_start, current_start;
     guint n_items_in_range = 0;
+    g_autoptr (GHashTable) removed_files = g_hash_table_new (NULL, NULL);
     g_autoptr (GtkBitset) positions = gtk_bitset_new_empty ();
     GtkBitsetIter position_iter;
+    GHashTableIter iter;
+    gpointer key;
 
-    for (GList *l = items; l != NULL; l = l->next)
+    for (GList *l = files; l != NULL; l = l->next)
     {
-        NautilusViewItem *item = l->data;
-        NautilusFile *file = nautilus_view_item_get_file (item);
-        guint i;
+        g_hash_table_add (removed_files, l->data);
+    }
 
-        if (!g_list_store_find (dir_store, item, &i))
-        {
-            g_autofree char *uri = nautilus_file_get_uri (file);
+    /* Find all the positions in a single pass over the store, instead of a
+     * pass per file. Consecutive positions are read in constant time. */
+    for (guint i = 0; i < n_items && g_hash_table_size (removed_files) > 0; i++)
+    {
+        g_autoptr (NautilusFile) file = g_list_model_get_item (G_LIST_MODEL (dir_store), i);
 
-            g_warning ("Failed to remove item %s", uri);
+        if (!g_hash_table_remove (removed_files, file))
+        {
             continue;
         }
 
         gtk_bitset_add (positions, i);
-        g_hash_table_remove (self->map_files_to_model, file);
-        if (nautilus_file_is_directory (file))
-        {
-            g_hash_table_remove (self->directory_reverse_map, file);
-        }
+        forget_file (self, file);
+    }
+
+    g_hash_table_iter_init (&iter, removed_files);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+        g_autofree char *uri = nautilus_file_get_uri (key);
+
+        g_warning ("Failed to remove item %s", uri);
     }
 
     /* Remove contiguous item ranges to minimize ::items-changed emissions.
@@ -476,25 +645,25 @@ nautilus_view_model_remove_all_items (NautilusViewModel *self)
     g_list_store_remove_all (G_LIST_STORE (gtk_tree_list_model_get_model (self->tree_model)));
     g_hash_table_remove_all (self->map_files_to_model);
     g_hash_table_remove_all (self->directory_reverse_map);
+    g_hash_table_remove_all (self->cut_files);
+    g_hash_table_remove_all (self->loading_files);
 }
 
 void
-nautilus_view_model_add_item (NautilusViewModel *self,
-                              NautilusViewItem  *item)
+nautilus_view_model_add_file (NautilusViewModel *self,
+                              NautilusFile      *file)
 {
-    NautilusFile *file;
     g_autoptr (NautilusFile) parent = NULL;
 
-    file = nautilus_view_item_get_file (item);
     parent = nautilus_file_get_parent (file);
 
-    g_list_store_append (get_directory_store (self, parent), item);
-    g_hash_table_insert (self->map_files_to_model, file, item);
+    g_list_store_append (get_directory_store (self, parent), file);
+    g_hash_table_insert (self->map_files_to_model, file, NULL);
 }
 
 static void
-splice_items_into_common_parent (NautilusViewModel *self,
-                                 GPtrArray         *items,
+splice_files_into_common_parent (NautilusViewModel *self,
+                                 GPtrArray         *files,
                                  NautilusFile      *common_parent)
 {
     GListStore *dir_store;
@@ -502,72 +671,68 @@ splice_items_into_common_parent (NautilusViewModel *self,
     dir_store = get_directory_store (self, common_parent);
     g_list_store_splice (dir_store,
                          g_list_model_get_n_items (G_LIST_MODEL (dir_store)),
-                         0, items->pdata, items->len);
+                         0, files->pdata, files->len);
 }
 
 void
-nautilus_view_model_add_items (NautilusViewModel *self,
-                               GList             *items)
+nautilus_view_model_add_files (NautilusViewModel *self,
+                               GList             *files)
 {
     g_autoptr (GPtrArray) array = g_ptr_array_new ();
     g_autoptr (NautilusFile) previous_parent = NULL;
-    g_autoptr (GList) sorted_items = NULL;
-    NautilusViewItem *item;
+    g_autoptr (GList) sorted_files = NULL;
+    NautilusFile *file;
 
     /* The first added file becomes the initial focus and scroll anchor, so we
-     * need to sort items before adding them to the internal model. */
-    sorted_items = g_list_sort_with_data (g_list_copy (items), compare_data_func, self);
+     * need to sort files before adding them to the internal model. */
+    sorted_files = g_list_sort_with_data (g_list_copy (files), compare_data_func, self);
 
-    for (GList *l = sorted_items; l != NULL; l = l->next)
+    for (GList *l = sorted_files; l != NULL; l = l->next)
     {
         g_autoptr (NautilusFile) parent = NULL;
 
-        item = NAUTILUS_VIEW_ITEM (l->data);
-        parent = nautilus_file_get_parent (nautilus_view_item_get_file (item));
+        file = NAUTILUS_FILE (l->data);
+        parent = nautilus_file_get_parent (file);
 
         if (previous_parent != NULL && previous_parent != parent)
         {
-            /* The pending items share a common parent. */
-            splice_items_into_common_parent (self, array, previous_parent);
+            /* The pending files share a common parent. */
+            splice_files_into_common_parent (self, array, previous_parent);
 
-            /* Clear pending items and start a new with a new parent. */
+            /* Clear pending files and start a new with a new parent. */
             g_ptr_array_unref (array);
             array = g_ptr_array_new ();
         }
         g_set_object (&previous_parent, parent);
 
-        g_ptr_array_add (array, item);
-        g_hash_table_insert (self->map_files_to_model,
-                             nautilus_view_item_get_file (item),
-                             item);
+        g_ptr_array_add (array, file);
+        g_hash_table_insert (self->map_files_to_model, file, NULL);
     }
 
     if (previous_parent != NULL)
     {
-        /* Flush the pending items. */
-        splice_items_into_common_parent (self, array, previous_parent);
+        /* Flush the pending files. */
+        splice_files_into_common_parent (self, array, previous_parent);
     }
 }
 
 void
 nautilus_view_model_clear_subdirectory (NautilusViewModel *self,
-                                        NautilusViewItem  *item)
+                                        NautilusFile      *file)
 {
-    NautilusFile *file;
     GListModel *children;
     guint n_children = 0;
 
     g_return_if_fail (NAUTILUS_IS_VIEW_MODEL (self));
-    g_return_if_fail (NAUTILUS_IS_VIEW_ITEM (item));
+    g_return_if_fail (NAUTILUS_IS_FILE (file));
 
-    file = nautilus_view_item_get_file (item);
     children = G_LIST_MODEL (g_hash_table_lookup (self->directory_reverse_map, file));
     n_children = (children != NULL) ? g_list_model_get_n_items (children) : 0;
     for (guint i = 0; i < n_children; i++)
     {
-        g_autoptr (NautilusViewItem) child = g_list_model_get_item (children, i);
+        g_autoptr (NautilusFile) child = g_list_model_get_item (children, i);
 
-        if (nautilus_file_is_directory (nautilus_view_item_get_file (child)))
+        if (nautilus_file_is_directory (child))
         {
             /* Clear recursively */
             nautilus_view_model_clear_subdirectory (self, child);
@@ -606,24 +771,31 @@ nautilus_view_model_set_cut_files (NautilusViewModel *self,
                                    GList             *cut_files)
 {
     NautilusViewItem *item;
+    GHashTableIter iter;
+    gpointer file;
 
-    for (GList *l = self->cut_files; l != NULL; l = l->next)
+    g_hash_table_iter_init (&iter, self->cut_files);
+    while (g_hash_table_iter_next (&iter, &file, NULL))
     {
-        item = nautilus_view_model_get_item_for_file (self, l->data);
+        item = nautilus_view_model_get_item_for_file (self, file);
         if (item != NULL)
         {
             nautilus_view_item_set_cut (item, FALSE);
         }
     }
-    g_clear_list (&self->cut_files, g_object_unref);
+    g_hash_table_remove_all (self->cut_files);
 
     for (GList *l = cut_files; l != NULL; l = l->next)
     {
+        if (!nautilus_view_model_has_file (self, l->data))
+        {
+            continue;
+        }
+
+        g_hash_table_add (self->cut_files, g_object_ref (l->data));
         item = nautilus_view_model_get_item_for_file (self, l->data);
         if (item != NULL)
         {
-            self->cut_files = g_list_prepend (self->cut_files,
-                                              g_object_ref (l->data));
             nautilus_view_item_set_cut (item, TRUE);
         }
     }
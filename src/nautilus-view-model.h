@@ -16,22 +16,32 @@ GtkSorter *nautilus_view_model_get_sorter (NautilusViewModel *self);
 void nautilus_view_model_set_sorter (NautilusViewModel *self,
                                      GtkSorter         *sorter);
 void nautilus_view_model_sort (NautilusViewModel *self);
+NautilusViewItem * nautilus_view_model_get_item_for_row (NautilusViewModel *self,
+                                                         GtkTreeListRow    *row);
 NautilusViewItem * nautilus_view_model_get_item_for_file (NautilusViewModel *self,
                                                           NautilusFile      *file);
-GList * nautilus_view_model_get_sorted_items_for_files (NautilusViewModel *self,
-                                                        GList             *files);
+gboolean nautilus_view_model_has_file (NautilusViewModel *self,
+                                       NautilusFile      *file);
+guint nautilus_view_model_get_sort_hash (NautilusViewModel *self,
+                                         NautilusFile      *file);
+void nautilus_view_model_set_sort_hash (NautilusViewModel *self,
+                                        NautilusFile      *file,
+                                        guint              sort_hash);
+void nautilus_view_model_set_loading (NautilusViewModel *self,
+                                      NautilusFile      *file,
+                                      gboolean           loading);
 /* Don't use inside a loop, use nautilus_view_model_remove_all_items instead. */
-void nautilus_view_model_remove_items (NautilusViewModel     *self,
-                                       GList                 *items,
+void nautilus_view_model_remove_files (NautilusViewModel     *self,
+                                       GList                 *files,
                                        NautilusDirectory     *directory);
 void nautilus_view_model_remove_all_items (NautilusViewModel *self);
-/* Don't use inside a loop, use nautilus_view_model_add_items instead. */
-void nautilus_view_model_add_item (NautilusViewModel     *self,
-                                   NautilusViewItem *item);
-void nautilus_view_model_add_items (NautilusViewModel *self,
-                                    GList             *items);
+/* Don't use inside a loop, use nautilus_view_model_add_files instead. */
+void nautilus_view_model_add_file (NautilusViewModel *self,
+                                   NautilusFile      *file);
+void nautilus_view_model_add_files (NautilusViewModel *self,
+                                    GList             *files);
 void nautilus_view_model_clear_subdirectory (NautilusViewModel *self,
-                                             NautilusViewItem  *item);
+                                             NautilusFile      *file);
 void nautilus_view_model_expand_as_a_tree (NautilusViewModel *self,
                                            gboolean           expand_as_a_tree);
 void nautilus_view_model_set_cut_files (NautilusViewModel *self,
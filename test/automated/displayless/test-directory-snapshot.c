@@ -0,0 +1,129 @@
+#include <glib.h>
+
+#include <nautilus-directory.h>
+#include <nautilus-directory-snapshot.h>
+#include <nautilus-file.h>
+#include <nautilus-file-private.h>
+
+#define DIRECTORY_MTIME 1700000000123456
+
+static GPtrArray *
+create_infos (void)
+{
+    GPtrArray *infos = g_ptr_array_new_with_free_func (g_object_unref);
+
+    for (guint i = 0; i < 10; i++)
+    {
+        GFileInfo *info = g_file_info_new ();
+        g_autoptr (GIcon) icon = g_content_type_get_icon ("text/plain");
+        g_autofree char *name = g_strdup_printf ("file-%u.txt", i);
+
+        g_file_info_set_name (info, name);
+        g_file_info_set_display_name (info, name);
+        g_file_info_set_file_type (info, G_FILE_TYPE_REGULAR);
+        g_file_info_set_content_type (info, "text/plain");
+        g_file_info_set_icon (info, icon);
+        g_file_info_set_size (info, i * 1000);
+        g_file_info_set_is_hidden (info, i == 0);
+        g_file_info_set_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED, 1600000000 + i);
+
+        g_ptr_array_add (infos, info);
+    }
+
+    return infos;
+}
+
+static GList *
+create_files (NautilusDirectory *directory,
+              GPtrArray         *infos)
+{
+    GList *files = NULL;
+
+    for (guint i = 0; i < infos->len; i++)
+    {
+        files = g_list_prepend (files,
+                                nautilus_file_new_from_info (directory,
+                                                             g_ptr_array_index (infos, i)));
+    }
+
+    return g_list_reverse (files);
+}
+
+static void
+test_directory_snapshot_round_trip (void)
+{
+    g_autoptr (NautilusDirectory) directory = nautilus_directory_get_by_uri ("file:///snapshot");
+    g_autoptr (GPtrArray) original_infos = create_infos ();
+    g_autolist (NautilusFile) files = create_files (directory, original_infos);
+    g_autoptr (GBytes) bytes = nautilus_directory_snapshot_serialize (DIRECTORY_MTIME, files);
+    g_autoptr (GPtrArray) infos = nautilus_directory_snapshot_parse (bytes, DIRECTORY_MTIME);
+    guint i = 0;
+
+    g_assert_nonnull (infos);
+    g_assert_cmpuint (infos->len, ==, g_list_length (files));
+
+    for (GList *l = files; l != NULL; l = l->next, i++)
+    {
+        NautilusFile *file = l->data;
+        GFileInfo *info = g_ptr_array_index (infos, i);
+        g_autoptr (NautilusFile) copy = nautilus_file_new_from_basic_info (directory, info);
+
+        g_assert_cmpstr (nautilus_file_get_name (copy), ==, nautilus_file_get_name (file));
+        g_assert_cmpint (nautilus_file_get_size (copy), ==, nautilus_file_get_size (file));
+        g_assert_cmpint (nautilus_file_get_mtime (copy), ==, nautilus_file_get_mtime (file));
+        g_assert_cmpstr (nautilus_file_get_mime_type (copy), ==, "text/plain");
+        g_assert_true (nautilus_file_is_hidden_file (copy) == nautilus_file_is_hidden_file (file));
+
+        /* When the enumeration finds the file unchanged, nothing is updated */
+        g_assert_false (nautilus_file_update_info (copy, g_ptr_array_index (original_infos, i)));
+    }
+}
+
+static void
+test_directory_snapshot_outdated (void)
+{
+    g_autoptr (NautilusDirectory) directory = nautilus_directory_get_by_uri ("file:///snapshot");
+    g_autoptr (GPtrArray) original_infos = create_infos ();
+    g_autolist (NautilusFile) files = create_files (directory, original_infos);
+    g_autoptr (GBytes) bytes = nautilus_directory_snapshot_serialize (DIRECTORY_MTIME, files);
+    g_autoptr (GPtrArray) infos = nautilus_directory_snapshot_parse (bytes, DIRECTORY_MTIME + 1);
+
+    /* The directory changed since the snapshot was saved */
+    g_assert_null (infos);
+}
+
+static void
+test_directory_snapshot_invalid (void)
+{
+    g_autoptr (NautilusDirectory) directory = nautilus_directory_get_by_uri ("file:///snapshot");
+    g_autoptr (GPtrArray) original_infos = create_infos ();
+    g_autolist (NautilusFile) files = create_files (directory, original_infos);
+    g_autoptr (GBytes) bytes = nautilus_directory_snapshot_serialize (DIRECTORY_MTIME, files);
+    gsize size = g_bytes_get_size (bytes);
+
+    for (gsize length = 0; length < size; length += 7)
+    {
+        g_autoptr (GBytes) truncated = g_bytes_new_from_bytes (bytes, 0, length);
+        g_autoptr (GPtrArray) infos = nautilus_directory_snapshot_parse (truncated, DIRECTORY_MTIME);
+
+        g_assert_null (infos);
+    }
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_test_init (&argc, &argv, G_TEST_OPTION_ISOLATE_DIRS, NULL);
+    g_test_set_nonfatal_assertions ();
+    nautilus_ensure_extension_points ();
+
+    g_test_add_func ("/directory-snapshot/round-trip",
+                     test_directory_snapshot_round_trip);
+    g_test_add_func ("/directory-snapshot/outdated",
+                     test_directory_snapshot_outdated);
+    g_test_add_func ("/directory-snapshot/invalid",
+                     test_directory_snapshot_invalid);
+
+    return g_test_run ();
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 The GNOME project contributors
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* Reports how much memory a loaded file takes. This is a benchmark, run it
+ * with `meson test --benchmark test-file-memory` on two revisions to compare
+ * them. It only relies on API which predates the file memory changes. */
+
+#include <glib.h>
+
+#if defined (__GLIBC__)
+#include <malloc.h>
+#if __GLIBC_PREREQ (2, 33)
+#define HAVE_MALLINFO2 1
+#endif
+#endif
+
+#include <nautilus-directory.h>
+#include <nautilus-directory-private.h>
+#include <nautilus-file.h>
+#include <nautilus-file-private.h>
+#include <nautilus-file-utilities.h>
+
+#include "test-utilities.h"
+
+#define N_FILES 20000
+
+static int data_dummy;
+static gboolean got_files_flag;
+
+static void
+got_files_callback (NautilusDirectory *directory,
+                    GList             *files,
+                    gpointer           callback_data)
+{
+    got_files_flag = TRUE;
+}
+
+static void
+test_file_memory_per_loaded_file (void)
+{
+#ifdef HAVE_MALLINFO2
+    g_autoptr (GFile) root = g_file_new_for_path (test_get_tmp_dir ());
+    g_autoptr (NautilusDirectory) directory = NULL;
+    g_autofree char *uri = NULL;
+    struct mallinfo2 before;
+    struct mallinfo2 after;
+    gsize per_file;
+
+    create_multiple_files ("memory", N_FILES);
+
+    uri = g_file_get_uri (root);
+    directory = nautilus_directory_get_by_uri (uri);
+
+    /* Load the files once first, to warm up the caches shared by all files,
+     * so that only the cost of the files themselves is measured. */
+    got_files_flag = FALSE;
+    nautilus_directory_call_when_ready (directory,
+                                        NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                        TRUE,
+                                        got_files_callback, &data_dummy);
+    for (guint i = 0; !got_files_flag && i < 1000000; i++)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+    g_assert_true (got_files_flag);
+
+    before = mallinfo2 ();
+
+    /* The monitor keeps the files loaded, as a view does. */
+    nautilus_directory_file_monitor_add (directory, &data_dummy, TRUE,
+                                         NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                         NULL, NULL);
+    got_files_flag = FALSE;
+    nautilus_directory_call_when_ready (directory,
+                                        NAUTILUS_FILE_ATTRIBUTE_INFO,
+                                        TRUE,
+                                        got_files_callback, &data_dummy);
+    for (guint i = 0; !got_files_flag && i < 1000000; i++)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+    g_assert_true (got_files_flag);
+
+    after = mallinfo2 ();
+    g_assert_cmpuint (g_list_length (directory->details->file_list), ==, N_FILES);
+
+    per_file = (after.uordblks - before.uordblks) / N_FILES;
+    g_test_message ("NautilusFile and its private data: %zu bytes",
+                    sizeof (NautilusFile) + sizeof (NautilusFilePrivate));
+    g_test_message ("%d loaded files take %zu bytes each on the heap",
+                    N_FILES, per_file);
+    g_test_minimized_result (per_file, "%zu bytes per loaded file", per_file);
+
+    nautilus_directory_file_monitor_remove (directory, &data_dummy);
+    empty_directory_by_prefix (root, "memory");
+    test_clear_tmp_dir ();
+#else
+    g_test_skip ("Measuring the heap needs mallinfo2() from glibc 2.33");
+#endif
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+    nautilus_ensure_extension_points ();
+
+    g_test_add_func ("/file-memory/per-loaded-file",
+                     test_file_memory_per_loaded_file);
+
+    return g_test_run ();
+}
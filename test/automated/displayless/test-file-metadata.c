@@ -48,6 +48,29 @@ test_file_metadata_str_get_null (void)
     g_assert_cmpstr (metadata, ==, "default");
 }
 
+static void
+test_file_metadata_set_keeps_other_keys (void)
+{
+    g_autoptr (NautilusFile) file = nautilus_file_get_by_uri (TEST_FILE);
+    g_auto (GStrv) list = NULL;
+    char *emblems[] = { "emblem-a", "emblem-b", NULL };
+
+    nautilus_file_set_metadata (file, KEY_STR, "default", "first");
+    nautilus_file_set_metadata_list (file, NAUTILUS_METADATA_KEY_EMBLEMS, emblems);
+    nautilus_file_set_metadata (file, KEY_STR, "default", "second");
+
+    g_assert_cmpstr (nautilus_file_get_metadata (file, KEY_STR, "default"), ==, "second");
+    list = nautilus_file_get_metadata_list (file, NAUTILUS_METADATA_KEY_EMBLEMS);
+    g_assert_nonnull (list);
+    g_assert_cmpstrv (list, emblems);
+
+    nautilus_file_set_metadata_list (file, NAUTILUS_METADATA_KEY_EMBLEMS, NULL);
+    g_clear_pointer (&list, g_strfreev);
+    list = nautilus_file_get_metadata_list (file, NAUTILUS_METADATA_KEY_EMBLEMS);
+    g_assert_null (list);
+    g_assert_cmpstr (nautilus_file_get_metadata (file, KEY_STR, "default"), ==, "second");
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -66,6 +89,8 @@ main (int   argc,
                      test_file_metadata_str_set);
     g_test_add_func ("/file-metadata-str-set/null",
                      test_file_metadata_str_get_null);
+    g_test_add_func ("/file-metadata-set/keeps-other-keys",
+                     test_file_metadata_set_keeps_other_keys);
 
     return g_test_run ();
 }
@@ -87,6 +87,22 @@ test_file_sort_with_self (void)
     g_assert_cmpint (order, ==, 0);
 }
 
+static void
+test_file_cold_data (void)
+{
+    g_autoptr (NautilusFile) file = nautilus_file_get_by_uri ("file:///etc");
+
+    /* Most files never need the rarely used fields */
+    g_assert_null (file->details->cold);
+    g_assert_null (nautilus_file_get_search_fts_snippet (file));
+    nautilus_file_set_search_fts_snippet (file, NULL);
+    g_assert_null (file->details->cold);
+
+    nautilus_file_set_search_fts_snippet (file, "snippet");
+    g_assert_nonnull (file->details->cold);
+    g_assert_cmpstr (nautilus_file_get_search_fts_snippet (file), ==, "snippet");
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -107,6 +123,8 @@ main (int   argc,
                      test_file_sort_order);
     g_test_add_func ("/file-sort/with-self",
                      test_file_sort_with_self);
+    g_test_add_func ("/file-memory/cold-data",
+                     test_file_cold_data);
 
     return g_test_run ();
 }
@@ -0,0 +1,203 @@
+#include <glib.h>
+
+#include <nautilus-progress-info-manager.h>
+
+#define LARGE_JOB_SIZE (1024 * 1024 * 1024)
+#define SMALL_JOB_SIZE 1024
+
+typedef struct
+{
+    NautilusProgressInfo *info;
+    GCancellable *cancellable;
+    gboolean started;
+} TestJob;
+
+static void
+on_job_may_start (gpointer user_data)
+{
+    TestJob *job = user_data;
+
+    job->started = TRUE;
+}
+
+static void
+test_job_queue (NautilusProgressInfoManager *manager,
+                TestJob                     *job,
+                const char                  *device_id,
+                goffset                      size)
+{
+    job->info = nautilus_progress_info_new ();
+    job->cancellable = nautilus_progress_info_get_cancellable (job->info);
+    job->started = FALSE;
+
+    nautilus_progress_info_manager_queue_for_device (manager, job->info, device_id, size,
+                                                     job->cancellable,
+                                                     on_job_may_start, job);
+}
+
+static void
+test_job_release (NautilusProgressInfoManager *manager,
+                  TestJob                     *job)
+{
+    nautilus_progress_info_manager_release_device (manager, job->info);
+    g_clear_object (&job->cancellable);
+    g_clear_object (&job->info);
+}
+
+static void
+run_pending_callbacks (void)
+{
+    while (g_main_context_iteration (NULL, FALSE))
+    {
+    }
+}
+
+static void
+test_same_device (void)
+{
+    g_autoptr (NautilusProgressInfoManager) manager = nautilus_progress_info_manager_dup_singleton ();
+    TestJob first;
+    TestJob second;
+
+    test_job_queue (manager, &first, "device", LARGE_JOB_SIZE);
+    test_job_queue (manager, &second, "device", LARGE_JOB_SIZE);
+    run_pending_callbacks ();
+    g_assert_true (first.started);
+    g_assert_false (second.started);
+
+    test_job_release (manager, &first);
+    run_pending_callbacks ();
+    g_assert_true (second.started);
+
+    test_job_release (manager, &second);
+}
+
+static void
+test_other_device (void)
+{
+    g_autoptr (NautilusProgressInfoManager) manager = nautilus_progress_info_manager_dup_singleton ();
+    TestJob first;
+    TestJob second;
+
+    test_job_queue (manager, &first, "device", LARGE_JOB_SIZE);
+    test_job_queue (manager, &second, "other-device", LARGE_JOB_SIZE);
+    run_pending_callbacks ();
+    g_assert_true (first.started);
+    g_assert_true (second.started);
+
+    test_job_release (manager, &first);
+    test_job_release (manager, &second);
+}
+
+static void
+test_unknown_device (void)
+{
+    g_autoptr (NautilusProgressInfoManager) manager = nautilus_progress_info_manager_dup_singleton ();
+    TestJob first;
+    TestJob second;
+
+    /* Unknown devices may well be different ones */
+    test_job_queue (manager, &first, NULL, LARGE_JOB_SIZE);
+    test_job_queue (manager, &second, NULL, LARGE_JOB_SIZE);
+    run_pending_callbacks ();
+    g_assert_true (first.started);
+    g_assert_true (second.started);
+
+    test_job_release (manager, &first);
+    test_job_release (manager, &second);
+}
+
+static void
+test_small_job (void)
+{
+    g_autoptr (NautilusProgressInfoManager) manager = nautilus_progress_info_manager_dup_singleton ();
+    TestJob large;
+    TestJob waiting;
+    TestJob small;
+
+    test_job_queue (manager, &large, "device", LARGE_JOB_SIZE);
+    test_job_queue (manager, &waiting, "device", LARGE_JOB_SIZE);
+    test_job_queue (manager, &small, "device", SMALL_JOB_SIZE);
+    run_pending_callbacks ();
+    g_assert_true (large.started);
+    g_assert_false (waiting.started);
+    g_assert_true (small.started);
+
+    /* Neither does it take the slot of the waiting job */
+    test_job_release (manager, &large);
+    run_pending_callbacks ();
+    g_assert_true (waiting.started);
+
+    test_job_release (manager, &waiting);
+    test_job_release (manager, &small);
+}
+
+static void
+test_cancel_waiting (void)
+{
+    g_autoptr (NautilusProgressInfoManager) manager = nautilus_progress_info_manager_dup_singleton ();
+    TestJob first;
+    TestJob second;
+
+    test_job_queue (manager, &first, "device", LARGE_JOB_SIZE);
+    test_job_queue (manager, &second, "device", LARGE_JOB_SIZE);
+    run_pending_callbacks ();
+    g_assert_false (second.started);
+
+    /* The job gets to clean up */
+    g_cancellable_cancel (second.cancellable);
+    run_pending_callbacks ();
+    g_assert_true (second.started);
+
+    test_job_release (manager, &first);
+    test_job_release (manager, &second);
+}
+
+static void
+test_raise_limit (void)
+{
+    g_autoptr (NautilusProgressInfoManager) manager = nautilus_progress_info_manager_dup_singleton ();
+    TestJob first;
+    TestJob second;
+
+    test_job_queue (manager, &first, "device", LARGE_JOB_SIZE);
+    test_job_queue (manager, &second, "device", LARGE_JOB_SIZE);
+    run_pending_callbacks ();
+    g_assert_false (second.started);
+
+    g_object_set (manager, "max-jobs-per-device", 2, NULL);
+    run_pending_callbacks ();
+    g_assert_true (second.started);
+
+    g_object_set (manager, "max-jobs-per-device", 1, NULL);
+    test_job_release (manager, &first);
+    test_job_release (manager, &second);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_autoptr (NautilusProgressInfoManager) manager = NULL;
+
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+
+    /* Keep the singleton, and its queue, alive across the tests */
+    manager = nautilus_progress_info_manager_dup_singleton ();
+
+    g_test_add_func ("/progress-info-manager/same-device",
+                     test_same_device);
+    g_test_add_func ("/progress-info-manager/other-device",
+                     test_other_device);
+    g_test_add_func ("/progress-info-manager/unknown-device",
+                     test_unknown_device);
+    g_test_add_func ("/progress-info-manager/small-job",
+                     test_small_job);
+    g_test_add_func ("/progress-info-manager/cancel-waiting",
+                     test_cancel_waiting);
+    g_test_add_func ("/progress-info-manager/raise-limit",
+                     test_raise_limit);
+
+    return g_test_run ();
+}
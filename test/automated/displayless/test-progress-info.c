@@ -0,0 +1,96 @@
+#include <glib.h>
+
+#include <nautilus-progress-info.h>
+
+static void
+test_progress_info_delete_fraction (void)
+{
+    g_autoptr (NautilusProgressInfo) info = nautilus_progress_info_new ();
+    g_autofree char *details = NULL;
+
+    nautilus_progress_info_start (info);
+
+    /* Deleting the first of four files, nothing is done yet */
+    nautilus_progress_info_publish_counters (info, NAUTILUS_PROGRESS_DETAILS_FILES,
+                                             1, 0, 4, 0, 0, 0);
+    g_assert_cmpfloat (nautilus_progress_info_get_progress (info), ==, 0.0);
+    details = nautilus_progress_info_get_details (info);
+    g_assert_cmpstr (details, ==, "1 / 4");
+    g_clear_pointer (&details, g_free);
+
+    /* Two files are gone, the details show the one being deleted */
+    nautilus_progress_info_publish_counters (info, NAUTILUS_PROGRESS_DETAILS_FILES,
+                                             3, 2, 4, 0, 0, 0);
+    g_assert_cmpfloat (nautilus_progress_info_get_progress (info), ==, 0.5);
+    details = nautilus_progress_info_get_details (info);
+    g_assert_cmpstr (details, ==, "3 / 4");
+    g_clear_pointer (&details, g_free);
+
+    nautilus_progress_info_publish_counters (info, NAUTILUS_PROGRESS_DETAILS_FILES,
+                                             4, 4, 4, 0, 0, 0);
+    g_assert_cmpfloat (nautilus_progress_info_get_progress (info), ==, 1.0);
+}
+
+static void
+test_progress_info_cancel_during_transfer (void)
+{
+    g_autoptr (NautilusProgressInfo) info = nautilus_progress_info_new ();
+    g_autofree char *details = NULL;
+
+    nautilus_progress_info_start (info);
+    nautilus_progress_info_publish_counters (info, NAUTILUS_PROGRESS_DETAILS_BYTES,
+                                             1, 0, 2, 50, 100, 0);
+
+    nautilus_progress_info_cancel (info);
+    details = nautilus_progress_info_get_details (info);
+    g_assert_cmpstr (details, ==, "Canceled");
+    g_clear_pointer (&details, g_free);
+
+    /* The bar stays where it was cancelled */
+    g_assert_cmpfloat (nautilus_progress_info_get_progress (info), ==, 0.5);
+
+    /* Counters published by the job before it notices are ignored */
+    nautilus_progress_info_publish_counters (info, NAUTILUS_PROGRESS_DETAILS_BYTES,
+                                             2, 1, 2, 75, 100, 0);
+    details = nautilus_progress_info_get_details (info);
+    g_assert_cmpstr (details, ==, "Canceled");
+    g_assert_cmpfloat (nautilus_progress_info_get_progress (info), ==, 0.5);
+}
+
+static void
+test_progress_info_details_after_counters (void)
+{
+    g_autoptr (NautilusProgressInfo) info = nautilus_progress_info_new ();
+    g_autofree char *details = NULL;
+
+    nautilus_progress_info_start (info);
+    nautilus_progress_info_publish_counters (info, NAUTILUS_PROGRESS_DETAILS_BYTES,
+                                             1, 0, 4, 25, 100, 0);
+
+    /* Text details don't reset the bar to a fraction that was never set */
+    nautilus_progress_info_set_details (info, "Almost there");
+    details = nautilus_progress_info_get_details (info);
+    g_assert_cmpstr (details, ==, "Almost there");
+    g_assert_cmpfloat (nautilus_progress_info_get_progress (info), ==, 0.25);
+
+    /* Until the fraction is set explicitly */
+    nautilus_progress_info_set_progress (info, 3, 4);
+    g_assert_cmpfloat (nautilus_progress_info_get_progress (info), ==, 0.75);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+    g_test_set_nonfatal_assertions ();
+
+    g_test_add_func ("/progress-info/delete-fraction",
+                     test_progress_info_delete_fraction);
+    g_test_add_func ("/progress-info/cancel-during-transfer",
+                     test_progress_info_cancel_during_transfer);
+    g_test_add_func ("/progress-info/details-after-counters",
+                     test_progress_info_details_after_counters);
+
+    return g_test_run ();
+}
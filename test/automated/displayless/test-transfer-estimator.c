@@ -0,0 +1,108 @@
+#include <glib.h>
+
+#include <nautilus-transfer-estimator.h>
+
+#define MEGABYTE 1000000
+
+static void
+test_estimator_overhead_and_rate (void)
+{
+    g_autoptr (NautilusTransferEstimator) estimator = nautilus_transfer_estimator_new (NULL);
+    gdouble elapsed = 0;
+    goffset bytes = 0;
+    gint64 files = 0;
+
+    g_assert_cmpfloat (nautilus_transfer_estimator_get_remaining_time (estimator, MEGABYTE, 1), <, 0);
+
+    nautilus_transfer_estimator_update (estimator, elapsed, bytes, files);
+
+    /* A hundred empty files per second… */
+    for (guint i = 0; i < 10; i++)
+    {
+        elapsed += 1;
+        files += 100;
+        nautilus_transfer_estimator_update (estimator, elapsed, bytes, files);
+    }
+
+    /* …then a 10 MB file per second, plus the time to create it */
+    for (guint i = 0; i < 20; i++)
+    {
+        elapsed += 1.01;
+        files += 1;
+        bytes += 10 * MEGABYTE;
+        nautilus_transfer_estimator_update (estimator, elapsed, bytes, files);
+    }
+
+    /* Both parts are accounted for, unlike with an average over the whole
+     * transfer, which would be off by half */
+    g_assert_cmpfloat_with_epsilon (nautilus_transfer_estimator_get_rate (estimator),
+                                    10 * MEGABYTE, MEGABYTE / 10);
+    g_assert_cmpfloat_with_epsilon (nautilus_transfer_estimator_get_remaining_time (estimator,
+                                                                                    100 * MEGABYTE,
+                                                                                    100),
+                                    11, 0.1);
+}
+
+static void
+test_estimator_skip (void)
+{
+    g_autoptr (NautilusTransferEstimator) estimator = nautilus_transfer_estimator_new (NULL);
+    goffset bytes = 0;
+
+    for (guint i = 0; i <= 10; i++)
+    {
+        bytes = i * 10 * MEGABYTE;
+        nautilus_transfer_estimator_update (estimator, i, bytes, 0);
+    }
+
+    /* An earlier attempt already copied a whole gigabyte */
+    nautilus_transfer_estimator_skip (estimator, 1000 * MEGABYTE, 1);
+    bytes += 1000 * MEGABYTE + 10 * MEGABYTE;
+    nautilus_transfer_estimator_update (estimator, 11, bytes, 1);
+
+    g_assert_cmpfloat_with_epsilon (nautilus_transfer_estimator_get_rate (estimator),
+                                    10 * MEGABYTE, MEGABYTE / 10);
+}
+
+static void
+test_estimator_history (void)
+{
+    g_autoptr (NautilusTransferEstimator) estimator = nautilus_transfer_estimator_new ("device");
+    g_autoptr (NautilusTransferEstimator) same_device = NULL;
+    g_autoptr (NautilusTransferEstimator) other_device = NULL;
+
+    g_assert_false (nautilus_transfer_estimator_has_history (estimator));
+
+    for (guint i = 0; i <= 10; i++)
+    {
+        nautilus_transfer_estimator_update (estimator, i, i * 5 * MEGABYTE, i);
+    }
+    nautilus_transfer_estimator_save_history (estimator);
+
+    /* The next transfer to the device has an estimate before any progress */
+    same_device = nautilus_transfer_estimator_new ("device");
+    g_assert_true (nautilus_transfer_estimator_has_history (same_device));
+    g_assert_cmpfloat_with_epsilon (nautilus_transfer_estimator_get_rate (same_device),
+                                    nautilus_transfer_estimator_get_rate (estimator), 1);
+    g_assert_cmpfloat (nautilus_transfer_estimator_get_remaining_time (same_device, MEGABYTE, 1), >, 0);
+
+    other_device = nautilus_transfer_estimator_new ("other-device");
+    g_assert_false (nautilus_transfer_estimator_has_history (other_device));
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_test_init (&argc, &argv, G_TEST_OPTION_ISOLATE_DIRS, NULL);
+    g_test_set_nonfatal_assertions ();
+
+    g_test_add_func ("/transfer-estimator/overhead-and-rate",
+                     test_estimator_overhead_and_rate);
+    g_test_add_func ("/transfer-estimator/skip",
+                     test_estimator_skip);
+    g_test_add_func ("/transfer-estimator/history",
+                     test_estimator_history);
+
+    return g_test_run ();
+}
@@ -0,0 +1,265 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <utime.h>
+
+#include <nautilus-transfer-journal.h>
+
+typedef struct
+{
+    GFile *src_dir;
+    GFile *dest_dir;
+    GFile *src;
+    GFile *dest;
+    GList *sources;
+} JournalFixture;
+
+static void
+journal_fixture_set_up (JournalFixture *fixture,
+                        gconstpointer   user_data)
+{
+    g_autofree char *tmp_dir = g_dir_make_tmp ("nautilus-journal.XXXXXX", NULL);
+    g_autoptr (GFile) root = g_file_new_for_path (tmp_dir);
+
+    fixture->src_dir = g_file_get_child (root, "source");
+    fixture->dest_dir = g_file_get_child (root, "destination");
+    g_file_make_directory (fixture->src_dir, NULL, NULL);
+    g_file_make_directory (fixture->dest_dir, NULL, NULL);
+
+    fixture->src = g_file_get_child (fixture->src_dir, "file");
+    fixture->dest = g_file_get_child (fixture->dest_dir, "file");
+    g_file_replace_contents (fixture->src, "0123456789", 10, NULL, FALSE,
+                             G_FILE_CREATE_NONE, NULL, NULL, NULL);
+
+    fixture->sources = g_list_prepend (NULL, g_object_ref (fixture->src));
+}
+
+static void
+journal_fixture_tear_down (JournalFixture *fixture,
+                           gconstpointer   user_data)
+{
+    g_autoptr (GFile) root = g_file_get_parent (fixture->src_dir);
+
+    g_file_delete (fixture->src, NULL, NULL);
+    g_file_delete (fixture->dest, NULL, NULL);
+    g_file_delete (fixture->src_dir, NULL, NULL);
+    g_file_delete (fixture->dest_dir, NULL, NULL);
+    g_file_delete (root, NULL, NULL);
+
+    g_list_free_full (fixture->sources, g_object_unref);
+    g_object_unref (fixture->src);
+    g_object_unref (fixture->dest);
+    g_object_unref (fixture->src_dir);
+    g_object_unref (fixture->dest_dir);
+}
+
+static void
+test_journal_complete (JournalFixture *fixture,
+                       gconstpointer   user_data)
+{
+    g_autoptr (NautilusTransferJournal) journal = NULL;
+    g_autoptr (NautilusTransferJournal) reopened = NULL;
+    goffset offset = 0;
+    goffset size = 0;
+
+    journal = nautilus_transfer_journal_open (fixture->sources, fixture->dest_dir);
+    g_assert_nonnull (journal);
+
+    g_assert_true (g_file_copy (fixture->src, fixture->dest, G_FILE_COPY_NONE,
+                                NULL, NULL, NULL, NULL));
+    nautilus_transfer_journal_record_complete (journal, fixture->src, fixture->dest, NULL);
+
+    /* A later attempt of the same operation sees the completed file, once
+     * the batched entries were written out. */
+    g_clear_pointer (&journal, nautilus_transfer_journal_free);
+    reopened = nautilus_transfer_journal_open (fixture->sources, fixture->dest_dir);
+    g_assert_cmpint (nautilus_transfer_journal_lookup (reopened, fixture->src, fixture->dest,
+                                                       &offset, &size, NULL),
+                     ==, NAUTILUS_TRANSFER_JOURNAL_COMPLETE);
+    g_assert_cmpint (size, ==, 10);
+
+    /* But not once the source changed */
+    g_file_replace_contents (fixture->src, "01234", 5, NULL, FALSE,
+                             G_FILE_CREATE_NONE, NULL, NULL, NULL);
+    g_assert_cmpint (nautilus_transfer_journal_lookup (reopened, fixture->src, fixture->dest,
+                                                       &offset, &size, NULL),
+                     ==, NAUTILUS_TRANSFER_JOURNAL_NONE);
+
+    nautilus_transfer_journal_discard (reopened);
+}
+
+static void
+test_journal_checkpoint (JournalFixture *fixture,
+                         gconstpointer   user_data)
+{
+    g_autoptr (NautilusTransferJournal) journal = NULL;
+    g_autoptr (NautilusTransferJournal) reopened = NULL;
+    goffset offset = 0;
+    goffset size = 0;
+
+    journal = nautilus_transfer_journal_open (fixture->sources, fixture->dest_dir);
+    g_assert_nonnull (journal);
+
+    /* Only 4 bytes made it to the disk, even though we checkpointed 6 */
+    g_file_replace_contents (fixture->dest, "0123", 4, NULL, FALSE,
+                             G_FILE_CREATE_NONE, NULL, NULL, NULL);
+    nautilus_transfer_journal_record_checkpoint (journal, fixture->src, fixture->dest, 6, NULL);
+
+    reopened = nautilus_transfer_journal_open (fixture->sources, fixture->dest_dir);
+    g_assert_cmpint (nautilus_transfer_journal_lookup (reopened, fixture->src, fixture->dest,
+                                                       &offset, &size, NULL),
+                     ==, NAUTILUS_TRANSFER_JOURNAL_PARTIAL);
+    g_assert_cmpint (offset, ==, 4);
+
+    nautilus_transfer_journal_discard (reopened);
+}
+
+static void
+test_journal_checkpoint_dest_changed (JournalFixture *fixture,
+                                      gconstpointer   user_data)
+{
+    g_autoptr (NautilusTransferJournal) journal = NULL;
+    g_autoptr (NautilusTransferJournal) reopened = NULL;
+    goffset offset = 0;
+    goffset size = 0;
+
+    journal = nautilus_transfer_journal_open (fixture->sources, fixture->dest_dir);
+    g_assert_nonnull (journal);
+
+    g_file_replace_contents (fixture->dest, "0123", 4, NULL, FALSE,
+                             G_FILE_CREATE_NONE, NULL, NULL, NULL);
+    nautilus_transfer_journal_record_checkpoint (journal, fixture->src, fixture->dest, 4, NULL);
+
+    /* Something else wrote to the destination after the checkpoint */
+    g_file_replace_contents (fixture->dest, "abcdef", 6, NULL, FALSE,
+                             G_FILE_CREATE_NONE, NULL, NULL, NULL);
+
+    reopened = nautilus_transfer_journal_open (fixture->sources, fixture->dest_dir);
+    g_assert_cmpint (nautilus_transfer_journal_lookup (reopened, fixture->src, fixture->dest,
+                                                       &offset, &size, NULL),
+                     ==, NAUTILUS_TRANSFER_JOURNAL_NONE);
+
+    nautilus_transfer_journal_discard (reopened);
+}
+
+static void
+test_journal_directory (JournalFixture *fixture,
+                        gconstpointer   user_data)
+{
+    g_autoptr (NautilusTransferJournal) journal = NULL;
+    g_autoptr (NautilusTransferJournal) reopened = NULL;
+
+    journal = nautilus_transfer_journal_open (fixture->sources, fixture->dest_dir);
+    g_assert_nonnull (journal);
+    nautilus_transfer_journal_record_directory (journal, fixture->src_dir, fixture->dest_dir);
+    g_clear_pointer (&journal, nautilus_transfer_journal_free);
+
+    reopened = nautilus_transfer_journal_open (fixture->sources, fixture->dest_dir);
+    g_assert_true (nautilus_transfer_journal_has_directory (reopened, fixture->src_dir,
+                                                            fixture->dest_dir));
+    g_assert_false (nautilus_transfer_journal_has_directory (reopened, fixture->src,
+                                                             fixture->dest));
+
+    nautilus_transfer_journal_discard (reopened);
+}
+
+static guint
+count_journals (void)
+{
+    g_autofree char *dirname = g_build_filename (g_get_user_cache_dir (), "nautilus",
+                                                 "transfers", NULL);
+    g_autoptr (GDir) dir = g_dir_open (dirname, 0, NULL);
+    guint n_journals = 0;
+
+    while (dir != NULL && g_dir_read_name (dir) != NULL)
+    {
+        n_journals++;
+    }
+
+    return n_journals;
+}
+
+static void
+test_journal_expire_missing_source (JournalFixture *fixture,
+                                    gconstpointer   user_data)
+{
+    g_autoptr (NautilusTransferJournal) journal = NULL;
+    g_autoptr (NautilusTransferJournal) other = NULL;
+    g_autoptr (GList) other_sources = g_list_prepend (NULL, fixture->src_dir);
+
+    /* Left behind by an interrupted copy */
+    journal = nautilus_transfer_journal_open (fixture->sources, fixture->dest_dir);
+    g_assert_nonnull (journal);
+    g_assert_cmpuint (count_journals (), ==, 1);
+
+    /* A journal whose sources still exist is kept */
+    other = nautilus_transfer_journal_open (other_sources, fixture->dest_dir);
+    g_assert_cmpuint (count_journals (), ==, 2);
+    g_clear_pointer (&other, nautilus_transfer_journal_free);
+
+    /* But not once they are gone */
+    g_file_delete (fixture->src, NULL, NULL);
+    other = nautilus_transfer_journal_open (other_sources, fixture->dest_dir);
+    g_assert_cmpuint (count_journals (), ==, 1);
+
+    nautilus_transfer_journal_discard (other);
+}
+
+static void
+test_journal_expire_old (JournalFixture *fixture,
+                         gconstpointer   user_data)
+{
+    g_autoptr (NautilusTransferJournal) journal = NULL;
+    g_autoptr (NautilusTransferJournal) other = NULL;
+    g_autoptr (GList) other_sources = g_list_prepend (NULL, fixture->src_dir);
+    g_autofree char *dirname = g_build_filename (g_get_user_cache_dir (), "nautilus",
+                                                 "transfers", NULL);
+    g_autoptr (GDir) dir = NULL;
+    const char *name;
+
+    journal = nautilus_transfer_journal_open (fixture->sources, fixture->dest_dir);
+    g_assert_nonnull (journal);
+
+    /* Pretend the copy was interrupted a long time ago */
+    dir = g_dir_open (dirname, 0, NULL);
+    while ((name = g_dir_read_name (dir)) != NULL)
+    {
+        g_autofree char *path = g_build_filename (dirname, name, NULL);
+        struct utimbuf times = { .actime = 0, .modtime = 0 };
+
+        g_utime (path, &times);
+    }
+
+    other = nautilus_transfer_journal_open (other_sources, fixture->dest_dir);
+    g_assert_cmpuint (count_journals (), ==, 1);
+
+    nautilus_transfer_journal_discard (other);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+    g_test_init (&argc, &argv, G_TEST_OPTION_ISOLATE_DIRS, NULL);
+    g_test_set_nonfatal_assertions ();
+
+    g_test_add ("/transfer-journal/complete",
+                JournalFixture, NULL,
+                journal_fixture_set_up, test_journal_complete, journal_fixture_tear_down);
+    g_test_add ("/transfer-journal/checkpoint",
+                JournalFixture, NULL,
+                journal_fixture_set_up, test_journal_checkpoint, journal_fixture_tear_down);
+    g_test_add ("/transfer-journal/checkpoint-dest-changed",
+                JournalFixture, NULL,
+                journal_fixture_set_up, test_journal_checkpoint_dest_changed, journal_fixture_tear_down);
+    g_test_add ("/transfer-journal/directory",
+                JournalFixture, NULL,
+                journal_fixture_set_up, test_journal_directory, journal_fixture_tear_down);
+    g_test_add ("/transfer-journal/expire-missing-source",
+                JournalFixture, NULL,
+                journal_fixture_set_up, test_journal_expire_missing_source, journal_fixture_tear_down);
+    g_test_add ("/transfer-journal/expire-old",
+                JournalFixture, NULL,
+                journal_fixture_set_up, test_journal_expire_old, journal_fixture_tear_down);
+
+    return g_test_run ();
+}